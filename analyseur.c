@@ -0,0 +1,312 @@
+/*
+Nom du fichier : analyseur.c
+Fait par : Erwann GIRAULT
+But : Recherche vectorisée des séparateurs et conversions numériques rapides
+      pour le chargement des sauvegardes
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "analyseur.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define ANALYSEUR_X86 1
+#endif
+
+typedef const char* (*FonctionRecherche)(const char*, const char*, char);
+
+static FonctionRecherche recherche_active = NULL;
+static NoyauRecherche noyau_actif = NOYAU_SCALAIRE;
+static pthread_once_t init_noyau = PTHREAD_ONCE_INIT;
+
+static const char* chercher_scalaire(const char* p, const char* fin, char octet) {
+    /*
+    Argument:
+        p: Début de la zone
+        fin: Fin de la zone (exclue)
+        octet: Octet recherché
+    But:
+        Version de référence, octet par octet
+    Retour:
+        Pointeur vers la première occurrence, ou NULL
+    */
+    for (; p < fin; p++) {
+        if (*p == octet) return p;
+    }
+    return NULL;
+}
+
+#ifdef ANALYSEUR_X86
+static const char* chercher_sse2(const char* p, const char* fin, char octet) {
+    /*
+    Argument:
+        p, fin, octet: Comme chercher_scalaire
+    But:
+        Comparer 16 octets à la fois ; le masque des égalités donne directement
+        la position de la première occurrence
+    Retour:
+        Pointeur vers la première occurrence, ou NULL
+    */
+    __m128i cible = _mm_set1_epi8(octet);
+    while (fin - p >= 16) {
+        __m128i bloc = _mm_loadu_si128((const __m128i*)p);
+        unsigned int masque = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bloc, cible));
+        if (masque != 0) return p + __builtin_ctz(masque);
+        p += 16;
+    }
+    return chercher_scalaire(p, fin, octet);
+}
+
+__attribute__((target("avx2")))
+static const char* chercher_avx2(const char* p, const char* fin, char octet) {
+    /*
+    Argument:
+        p, fin, octet: Comme chercher_scalaire
+    But:
+        Même principe que la version SSE2 sur 32 octets, avec deux blocs par
+        tour de boucle pour les longues zones sans occurrence
+    Retour:
+        Pointeur vers la première occurrence, ou NULL
+    */
+    __m256i cible = _mm256_set1_epi8(octet);
+    while (fin - p >= 64) {
+        __m256i egal1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), cible);
+        __m256i egal2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), cible);
+        if (!_mm256_testz_si256(_mm256_or_si256(egal1, egal2), _mm256_or_si256(egal1, egal2))) {
+            unsigned int masque = (unsigned int)_mm256_movemask_epi8(egal1);
+            if (masque != 0) return p + __builtin_ctz(masque);
+            return p + 32 + __builtin_ctz((unsigned int)_mm256_movemask_epi8(egal2));
+        }
+        p += 64;
+    }
+    while (fin - p >= 32) {
+        unsigned int masque = (unsigned int)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), cible));
+        if (masque != 0) return p + __builtin_ctz(masque);
+        p += 32;
+    }
+    return chercher_sse2(p, fin, octet);
+}
+#endif
+
+static void detecter_noyau(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Choisir le meilleur noyau disponible sur le processeur (appelé une seule fois)
+    Retour:
+        Aucun
+    */
+    recherche_active = chercher_scalaire;
+    noyau_actif = NOYAU_SCALAIRE;
+#ifdef ANALYSEUR_X86
+    recherche_active = chercher_sse2;
+    noyau_actif = NOYAU_SSE2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        recherche_active = chercher_avx2;
+        noyau_actif = NOYAU_AVX2;
+    }
+#endif
+}
+
+const char* chercher_octet(const char* debut, const char* fin, char octet) {
+    /*
+    Argument:
+        debut: Début de la zone
+        fin: Fin de la zone (exclue, aucun octet au-delà n'est lu)
+        octet: Octet recherché ('\n' ou '|' pour les sauvegardes)
+    But:
+        Trouver la première occurrence d'un octet avec le noyau choisi pour le processeur
+    Retour:
+        Pointeur vers la première occurrence, ou NULL si absent
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+    return recherche_active(debut, fin, octet);
+}
+
+NoyauRecherche analyseur_noyau_actif(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Connaître le noyau de recherche utilisé
+    Retour:
+        Le noyau actif
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+    return noyau_actif;
+}
+
+int analyseur_choisir_noyau(NoyauRecherche noyau) {
+    /*
+    Argument:
+        noyau: Noyau à imposer (mesures, comparaison avec la version scalaire)
+    But:
+        Forcer un noyau de recherche, s'il est disponible sur ce processeur
+    Retour:
+        0 si le noyau est actif, -1 s'il n'est pas disponible
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+    switch (noyau) {
+        case NOYAU_SCALAIRE:
+            recherche_active = chercher_scalaire;
+            break;
+#ifdef ANALYSEUR_X86
+        case NOYAU_SSE2:
+            recherche_active = chercher_sse2;
+            break;
+        case NOYAU_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return -1;
+            recherche_active = chercher_avx2;
+            break;
+#endif
+        default:
+            return -1;
+    }
+    noyau_actif = noyau;
+    return 0;
+}
+
+const char* analyseur_nom_noyau(NoyauRecherche noyau) {
+    /*
+    Argument:
+        noyau: Noyau de recherche
+    But:
+        Donner un nom lisible pour l'affichage et les mesures
+    Retour:
+        Chaîne constante
+    */
+    switch (noyau) {
+        case NOYAU_SSE2: return "sse2";
+        case NOYAU_AVX2: return "avx2";
+        default: return "scalaire";
+    }
+}
+
+static bool chiffres_seuls(const char* texte, int max_chiffres, uint64_t* valeur) {
+    /*
+    Argument:
+        texte: Champ terminé par '\0'
+        max_chiffres: Nombre de chiffres au-delà duquel on laisse la main à strto*
+        valeur: Valeur lue
+    But:
+        Chemin rapide commun : le champ ne contient que des chiffres (au moins un)
+    Retour:
+        true si le chemin rapide s'applique
+    */
+    uint64_t v = 0;
+    int n = 0;
+    for (; texte[n] != '\0'; n++) {
+        unsigned int chiffre = (unsigned int)(texte[n] - '0');
+        if (chiffre > 9 || n >= max_chiffres) return false;
+        v = v * 10 + chiffre;
+    }
+    if (n == 0) return false;
+    *valeur = v;
+    return true;
+}
+
+uint32_t analyser_u32(const char* texte) {
+    /*
+    Argument:
+        texte: Champ terminé par '\0'
+    But:
+        Convertir un ID
+    Retour:
+        Même résultat que (uint32_t)strtoul(texte, NULL, 10)
+    */
+    uint64_t v;
+    if (chiffres_seuls(texte, 9, &v)) return (uint32_t)v;
+    return (uint32_t)strtoul(texte, NULL, 10);
+}
+
+int analyser_int(const char* texte) {
+    /*
+    Argument:
+        texte: Champ terminé par '\0'
+    But:
+        Convertir une quantité
+    Retour:
+        Même résultat que (int)strtol(texte, NULL, 10)
+    */
+    uint64_t v;
+    if (texte[0] == '-') {
+        if (chiffres_seuls(texte + 1, 9, &v)) return -(int)v;
+    } else if (chiffres_seuls(texte, 9, &v)) {
+        return (int)v;
+    }
+    return (int)strtol(texte, NULL, 10);
+}
+
+long analyser_long(const char* texte) {
+    /*
+    Argument:
+        texte: Champ terminé par '\0'
+    But:
+        Convertir un timestamp
+    Retour:
+        Même résultat que strtol(texte, NULL, 10)
+    */
+    uint64_t v;
+    if (texte[0] == '-') {
+        if (chiffres_seuls(texte + 1, 18, &v)) return -(long)v;
+    } else if (chiffres_seuls(texte, 18, &v)) {
+        return (long)v;
+    }
+    return strtol(texte, NULL, 10);
+}
+
+float analyser_float(const char* texte) {
+    /*
+    Argument:
+        texte: Champ terminé par '\0'
+    But:
+        Convertir un prix. Chemin rapide (méthode de Clinger) : si la mantisse
+        décimale tient sur 24 bits et qu'il y a au plus 10 décimales, mantisse
+        et puissance de 10 sont exactes en float et une seule division donne
+        l'arrondi correct, comme strtof
+    Retour:
+        Même résultat que strtof(texte, NULL)
+    */
+    static const float puissances[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+    const char* p = texte;
+    bool negatif = false;
+    if (*p == '-') {
+        negatif = true;
+        p++;
+    }
+
+    uint32_t mantisse = 0;
+    int nb_chiffres = 0;
+    int decimales = 0;
+    bool point = false;
+    for (; *p != '\0'; p++) {
+        if (*p == '.' && !point) {
+            point = true;
+            continue;
+        }
+        unsigned int chiffre = (unsigned int)(*p - '0');
+        if (chiffre > 9 || nb_chiffres >= 8) {
+            return strtof(texte, NULL);
+        }
+        mantisse = mantisse * 10 + chiffre;
+        nb_chiffres++;
+        if (point) decimales++;
+    }
+
+    if (nb_chiffres == 0 || mantisse > (1u << 24) || decimales > 10) {
+        return strtof(texte, NULL);
+    }
+    float resultat = (float)mantisse / puissances[decimales];
+    return negatif ? -resultat : resultat;
+}
@@ -0,0 +1,33 @@
+#ifndef _ANALYSEUR_H
+#define _ANALYSEUR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+    Noyaux d'analyse rapide du format de sauvegarde "|".
+    - chercher_octet : équivalent de memchr, vectorisé (AVX2 ou SSE2 sur x86,
+      version scalaire ailleurs). Le noyau est choisi au premier appel selon
+      le processeur.
+    - analyser_* : conversions sur un champ terminé par '\0'. Les cas simples
+      (chiffres uniquement, prix "123.45") sont traités à la main, les autres
+      passent par strtoul/strtol/strtof : le résultat est toujours identique.
+*/
+
+typedef enum {
+    NOYAU_SCALAIRE,
+    NOYAU_SSE2,
+    NOYAU_AVX2
+} NoyauRecherche;
+
+const char* chercher_octet(const char* debut, const char* fin, char octet);
+NoyauRecherche analyseur_noyau_actif(void);
+int analyseur_choisir_noyau(NoyauRecherche noyau);
+const char* analyseur_nom_noyau(NoyauRecherche noyau);
+
+uint32_t analyser_u32(const char* texte);
+int analyser_int(const char* texte);
+long analyser_long(const char* texte);
+float analyser_float(const char* texte);
+
+#endif
@@ -0,0 +1,456 @@
+/*
+Nom du fichier : bench.c
+Fait par : Erwann GIRAULT
+But : Mesures de performance des opérations de l'inventaire sur un inventaire
+      synthétique de taille réglable, résultats en JSON ("make bench")
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "gestion_produit.h"
+#include "gestion_db.h"
+#include "index_nom.h"
+#include "colonnes.h"
+
+#define TAILLES_MAX 16
+#define NB_CATEGORIES 32
+#define NB_VARIANTES 1024          // descriptions et notes différentes (seule leur longueur compte)
+#define RECHERCHES_PAR_TAILLE 1000
+#define LONGUEUR_MOTIF 4
+#define FICHIER_BENCH "bench_inventaire.txt"
+#define SECONDES_PAR_JOUR 86400
+
+typedef struct {
+    size_t tailles[TAILLES_MAX];
+    size_t nb_tailles;
+    size_t longueur_nom;
+    size_t longueur_description;
+    size_t longueur_note;
+    double part_sans_date;     // produits sans péremption (date 0)
+    double part_perimes;       // produits déjà périmés (retirés par supprimer_perimes)
+    long horizon_jours;        // les autres périment dans les horizon_jours jours
+    bool fsync;
+    uint64_t graine;
+} ParametresBench;
+
+typedef struct {
+    char* noms;                // n noms de longueur_nom + 1 octets
+    char* variantes;           // NB_VARIANTES descriptions puis NB_VARIANTES notes
+    char categories[NB_CATEGORIES][16];
+    uint32_t* categorie;       // indice de catégorie de chaque produit
+    time_t* dates;
+    int* quantites;
+    float* prix;
+} Inventaire;
+
+static uint64_t etat_aleatoire;
+static FILE* sortie_json;
+static bool premier_resultat = true;
+
+static uint64_t aleatoire(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Générateur xorshift64* : mêmes données d'une exécution à l'autre
+        pour une même graine
+    Retour:
+        64 bits pseudo-aléatoires
+    */
+    etat_aleatoire ^= etat_aleatoire >> 12;
+    etat_aleatoire ^= etat_aleatoire << 25;
+    etat_aleatoire ^= etat_aleatoire >> 27;
+    return etat_aleatoire * 0x2545F4914F6CDD1DULL;
+}
+
+static double uniforme(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Tirage uniforme
+    Retour:
+        Réel dans [0, 1)
+    */
+    return (double)(aleatoire() >> 11) / 9007199254740992.0;
+}
+
+static void remplir_texte(char* texte, size_t longueur) {
+    /*
+    Argument:
+        texte: Destination (longueur + 1 octets)
+        longueur: Nombre de lettres
+    But:
+        Texte de lettres minuscules aléatoires
+    Retour:
+        Aucun
+    */
+    for (size_t i = 0; i < longueur; i++) {
+        texte[i] = (char)('a' + aleatoire() % 26);
+    }
+    texte[longueur] = '\0';
+}
+
+static double maintenant_s(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Horloge monotone
+    Retour:
+        Secondes
+    */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void resultat(size_t n, const char* operation, size_t operations, double secondes, const char* extra_nom, size_t extra) {
+    /*
+    Argument:
+        n: Taille de l'inventaire
+        operation: Nom de l'opération mesurée
+        operations: Nombre d'opérations chronométrées
+        secondes: Durée totale
+        extra_nom, extra: Compteur propre à l'opération (NULL si aucun)
+    But:
+        Écrire un résultat JSON, et un résumé lisible sur la sortie d'erreur
+    Retour:
+        Aucun
+    */
+    double ns = (operations > 0) ? secondes * 1e9 / (double)operations : 0.0;
+    fprintf(sortie_json, "%s\n    {\"n\": %zu, \"operation\": \"%s\", \"operations\": %zu, \"secondes\": %.6f, \"ns_par_operation\": %.1f",
+            premier_resultat ? "" : ",", n, operation, operations, secondes, ns);
+    if (extra_nom != NULL) fprintf(sortie_json, ", \"%s\": %zu", extra_nom, extra);
+    fprintf(sortie_json, "}");
+    premier_resultat = false;
+    fprintf(stderr, "%10zu  %-18s %12.1f ns/op  %10.4f s\n", n, operation, ns, secondes);
+}
+
+static int generer(Inventaire* inv, size_t n, const ParametresBench* p) {
+    /*
+    Argument:
+        inv: Données à remplir
+        n: Nombre de produits
+        p: Longueurs des chaînes et répartition des péremptions
+    But:
+        Préparer les champs des n produits avant toute mesure
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    size_t taille_variante_description = p->longueur_description + 1;
+    size_t taille_variante_note = p->longueur_note + 1;
+    inv->noms = (char*)malloc(n * (p->longueur_nom + 1));
+    inv->variantes = (char*)malloc(NB_VARIANTES * (taille_variante_description + taille_variante_note));
+    inv->categorie = (uint32_t*)malloc(n * sizeof(uint32_t));
+    inv->dates = (time_t*)malloc(n * sizeof(time_t));
+    inv->quantites = (int*)malloc(n * sizeof(int));
+    inv->prix = (float*)malloc(n * sizeof(float));
+    if (inv->noms == NULL || inv->variantes == NULL || inv->categorie == NULL || inv->dates == NULL
+        || inv->quantites == NULL || inv->prix == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < NB_VARIANTES; i++) {
+        remplir_texte(inv->variantes + i * taille_variante_description, p->longueur_description);
+        remplir_texte(inv->variantes + NB_VARIANTES * taille_variante_description + i * taille_variante_note, p->longueur_note);
+    }
+    for (int i = 0; i < NB_CATEGORIES; i++) {
+        snprintf(inv->categories[i], sizeof(inv->categories[i]), "categorie%d", i);
+    }
+
+    time_t t = time(NULL);
+    for (size_t i = 0; i < n; i++) {
+        remplir_texte(inv->noms + i * (p->longueur_nom + 1), p->longueur_nom);
+        inv->categorie[i] = (uint32_t)(aleatoire() % NB_CATEGORIES);
+        inv->quantites[i] = (int)(aleatoire() % 1000);
+        inv->prix[i] = (float)(aleatoire() % 100000) / 100.0f;
+
+        double tirage = uniforme();
+        if (tirage < p->part_sans_date) {
+            inv->dates[i] = 0;
+        } else if (tirage < p->part_sans_date + p->part_perimes) {
+            inv->dates[i] = t - 1 - (time_t)(aleatoire() % (SECONDES_PAR_JOUR * 30));
+        } else {
+            inv->dates[i] = t + 60 + (time_t)(aleatoire() % (uint64_t)(p->horizon_jours * SECONDES_PAR_JOUR));
+        }
+    }
+    return 0;
+}
+
+static void liberer_inventaire(Inventaire* inv) {
+    /*
+    Argument:
+        inv: Données générées
+    But:
+        Libérer les données générées
+    Retour:
+        Aucun
+    */
+    free(inv->noms);
+    free(inv->variantes);
+    free(inv->categorie);
+    free(inv->dates);
+    free(inv->quantites);
+    free(inv->prix);
+}
+
+static int mesurer(size_t n, const ParametresBench* p) {
+    /*
+    Argument:
+        n: Taille de l'inventaire
+        p: Paramètres du générateur
+    But:
+        Chronométrer chaque opération sur un inventaire de n produits
+    Retour:
+        0 si succès, -1 en cas d'erreur
+    */
+    Inventaire inv;
+    memset(&inv, 0, sizeof(inv));
+    Produit** produits = (Produit**)malloc(n * sizeof(Produit*));
+    if (produits == NULL || generer(&inv, n, p) != 0) {
+        fprintf(stderr, "[!] Erreur : Memoire insuffisante pour %zu produits\n", n);
+        free(produits);
+        liberer_inventaire(&inv);
+        return -1;
+    }
+    size_t taille_description = p->longueur_description + 1;
+    const char* notes = inv.variantes + NB_VARIANTES * taille_description;
+
+    double debut = maintenant_s();
+    for (size_t i = 0; i < n; i++) {
+        size_t v = i % NB_VARIANTES;
+        produits[i] = creer_produit((uint32_t)(i + 1), inv.noms + i * (p->longueur_nom + 1),
+                                    inv.variantes + v * taille_description, inv.categories[inv.categorie[i]],
+                                    inv.quantites[i], inv.prix[i], inv.dates[i], notes + v * (p->longueur_note + 1));
+    }
+    resultat(n, "creer_produit", n, maintenant_s() - debut, NULL, 0);
+
+    Produit* head = NULL;
+    debut = maintenant_s();
+    for (size_t i = 0; i < n; i++) {
+        if (produits[i] != NULL) insertion(&head, produits[i]);
+    }
+    resultat(n, "insertion", n, maintenant_s() - debut, NULL, 0);
+
+    size_t trouves = 0;
+    uint32_t* ids = (uint32_t*)malloc(n * sizeof(uint32_t));
+    if (ids != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = (uint32_t)(1 + aleatoire() % n);
+        }
+        debut = maintenant_s();
+        for (size_t i = 0; i < n; i++) {
+            trouves += (rechercher_par_id(head, ids[i]) != NULL);
+        }
+        resultat(n, "rechercher_par_id", n, maintenant_s() - debut, "trouves", trouves);
+        free(ids);
+    }
+
+    // Motifs de LONGUEUR_MOTIF lettres pris dans des noms existants
+    size_t nb_recherches = (n < RECHERCHES_PAR_TAILLE) ? n : RECHERCHES_PAR_TAILLE;
+    char (*motifs)[LONGUEUR_MOTIF + 1] = malloc(nb_recherches * sizeof(*motifs));
+    if (motifs != NULL && p->longueur_nom >= LONGUEUR_MOTIF) {
+        for (size_t i = 0; i < nb_recherches; i++) {
+            const char* nom = inv.noms + (aleatoire() % n) * (p->longueur_nom + 1);
+            memcpy(motifs[i], nom + aleatoire() % (p->longueur_nom - LONGUEUR_MOTIF + 1), LONGUEUR_MOTIF);
+            motifs[i][LONGUEUR_MOTIF] = '\0';
+        }
+        size_t nb_resultats = 0;
+        debut = maintenant_s();
+        for (size_t i = 0; i < nb_recherches; i++) {
+            Produit** resultats;
+            size_t nb;
+            if (index_nom_rechercher(motifs[i], &resultats, &nb) == 0) nb_resultats += nb;
+            free(resultats);
+        }
+        resultat(n, "recherche_nom", nb_recherches, maintenant_s() - debut, "resultats", nb_resultats);
+    }
+    free(motifs);
+
+    debut = maintenant_s();
+    int res = sauvegarde(head, FICHIER_BENCH);
+    double duree = maintenant_s() - debut;
+    struct stat infos;
+    size_t octets = (res == 0 && stat(FICHIER_BENCH, &infos) == 0) ? (size_t)infos.st_size : 0;
+    resultat(n, "sauvegarde", n, duree, "octets", octets);
+
+    debut = maintenant_s();
+    size_t retires = supprimer_perimes(&head, time(NULL), false);
+    resultat(n, "supprimer_perimes", 1, maintenant_s() - debut, "retires", retires);
+
+    free_struct_produit(head);
+    head = NULL;
+    uint32_t max_id = 0;
+    debut = maintenant_s();
+    charger_fichier(&head, FICHIER_BENCH, &max_id);
+    resultat(n, "charger_fichier", n, maintenant_s() - debut, "charges", colonnes_taille());
+
+    // Même inventaire en instantané binaire (reconnu par charger_fichier)
+    debut = maintenant_s();
+    res = sauvegarde_binaire(head, FICHIER_BENCH);
+    duree = maintenant_s() - debut;
+    octets = (res == 0 && stat(FICHIER_BENCH, &infos) == 0) ? (size_t)infos.st_size : 0;
+    resultat(n, "sauvegarde_binaire", n, duree, "octets", octets);
+
+    free_struct_produit(head);
+    head = NULL;
+    max_id = 0;
+    debut = maintenant_s();
+    charger_fichier(&head, FICHIER_BENCH, &max_id);
+    resultat(n, "charger_binaire", n, maintenant_s() - debut, "charges", colonnes_taille());
+
+    free_struct_produit(head);
+    unlink(FICHIER_BENCH);
+    free(produits);
+    liberer_inventaire(&inv);
+    return 0;
+}
+
+static bool lire_taille(const char* texte, size_t min, size_t max, size_t* valeur) {
+    /*
+    Argument:
+        texte: Nombre (notation 1e6 acceptée)
+        min, max: Bornes
+        valeur: Résultat
+    But:
+        Lire une taille de la ligne de commande
+    Retour:
+        true si la valeur est valide
+    */
+    char* fin;
+    double v = strtod(texte, &fin);
+    if (fin == texte || (*fin != '\0' && *fin != ',') || v < (double)min || v > (double)max) return false;
+    *valeur = (size_t)v;
+    return true;
+}
+
+static bool lire_part(const char* texte, double* valeur) {
+    /*
+    Argument:
+        texte: Proportion entre 0 et 1
+        valeur: Résultat
+    But:
+        Lire une proportion de la ligne de commande
+    Retour:
+        true si la valeur est valide
+    */
+    char* fin;
+    double v = strtod(texte, &fin);
+    if (fin == texte || *fin != '\0' || !(v >= 0.0 && v <= 1.0)) return false;
+    *valeur = v;
+    return true;
+}
+
+static int lire_arguments(int argc, char* argv[], ParametresBench* p) {
+    /*
+    Argument:
+        argc, argv: Arguments du programme
+        p: Paramètres (valeurs par défaut déjà en place)
+    But:
+        Lire --tailles, --nom, --description, --note, --sans-date, --perimes,
+        --horizon, --graine et --fsync
+    Retour:
+        0 si succès, -1 si un argument est invalide
+    */
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        if (strcmp(option, "--fsync") == 0) {
+            p->fsync = true;
+            continue;
+        }
+        if (i + 1 >= argc) return -1;
+        const char* valeur = argv[++i];
+        size_t entier;
+        if (strcmp(option, "--tailles") == 0) {
+            p->nb_tailles = 0;
+            const char* t = valeur;
+            while (*t != '\0') {
+                if (p->nb_tailles == TAILLES_MAX || !lire_taille(t, 1, 100000000, &p->tailles[p->nb_tailles])) return -1;
+                p->nb_tailles++;
+                t += strcspn(t, ",");
+                if (*t == ',') t++;
+            }
+            if (p->nb_tailles == 0) return -1;
+        } else if (strcmp(option, "--nom") == 0) {
+            if (!lire_taille(valeur, 1, 64, &p->longueur_nom)) return -1;
+        } else if (strcmp(option, "--description") == 0) {
+            if (!lire_taille(valeur, 0, 1024, &p->longueur_description)) return -1;
+        } else if (strcmp(option, "--note") == 0) {
+            if (!lire_taille(valeur, 0, 1024, &p->longueur_note)) return -1;
+        } else if (strcmp(option, "--sans-date") == 0) {
+            if (!lire_part(valeur, &p->part_sans_date)) return -1;
+        } else if (strcmp(option, "--perimes") == 0) {
+            if (!lire_part(valeur, &p->part_perimes)) return -1;
+        } else if (strcmp(option, "--horizon") == 0) {
+            if (!lire_taille(valeur, 1, 36500, &entier)) return -1;
+            p->horizon_jours = (long)entier;
+        } else if (strcmp(option, "--graine") == 0) {
+            if (!lire_taille(valeur, 1, 1000000000000000ULL, &entier)) return -1;
+            p->graine = entier;
+        } else {
+            return -1;
+        }
+    }
+    return (p->part_sans_date + p->part_perimes <= 1.0) ? 0 : -1;
+}
+
+int main(int argc, char* argv[]) {
+    /*
+    But :
+        Lire les paramètres, mesurer chaque taille d'inventaire et écrire
+        les résultats en JSON sur la sortie standard
+    Arguments :
+        argc, argv : voir lire_arguments
+    Retour :
+        0 si toutes les mesures ont abouti, 1 sinon, 2 si les arguments sont invalides
+    */
+    ParametresBench p = {
+        .tailles = {1000, 10000, 100000, 1000000}, .nb_tailles = 4,
+        .longueur_nom = 24, .longueur_description = 64, .longueur_note = 16,
+        .part_sans_date = 0.3, .part_perimes = 0.1, .horizon_jours = 365,
+        .fsync = false, .graine = 42
+    };
+    if (lire_arguments(argc, argv, &p) != 0) {
+        fprintf(stderr, "Usage : %s [--tailles 1e3,1e4,...] [--nom L] [--description L] [--note L]\n"
+                        "          [--sans-date P] [--perimes P] [--horizon JOURS] [--graine G] [--fsync]\n", argv[0]);
+        return 2;
+    }
+
+    // Le JSON garde la vraie sortie standard ; les messages des modules
+    // (sauvegarde, chargement) partent sur /dev/null
+    int fd_json = dup(STDOUT_FILENO);
+    sortie_json = (fd_json >= 0) ? fdopen(fd_json, "w") : NULL;
+    if (sortie_json == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        perror("[!] Erreur sortie");
+        return 1;
+    }
+
+    etat_aleatoire = p.graine;
+    activer_journalisation(false); // ni historique ni journal : on mesure les structures
+    sauvegarde_configurer_fsync(p.fsync);
+
+    fprintf(sortie_json, "{\n  \"parametres\": {\"longueur_nom\": %zu, \"longueur_description\": %zu, \"longueur_note\": %zu, "
+            "\"part_sans_date\": %.3f, \"part_perimes\": %.3f, \"horizon_jours\": %ld, \"fsync\": %s, \"graine\": %llu, \"coeurs\": %ld},\n"
+            "  \"resultats\": [",
+            p.longueur_nom, p.longueur_description, p.longueur_note, p.part_sans_date, p.part_perimes,
+            p.horizon_jours, p.fsync ? "true" : "false", (unsigned long long)p.graine, sysconf(_SC_NPROCESSORS_ONLN));
+
+    int code = 0;
+    for (size_t i = 0; i < p.nb_tailles; i++) {
+        if (mesurer(p.tailles[i], &p) != 0) code = 1;
+    }
+
+    fprintf(sortie_json, "\n  ]\n}\n");
+    fclose(sortie_json);
+    return code;
+}
@@ -0,0 +1,458 @@
+/*
+Nom du fichier : categories.c
+Fait par : Erwann GIRAULT
+But : Table des catégories internées (un seul exemplaire de chaque libellé),
+      liste des produits de chaque catégorie et agrégats tenus à jour
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "categories.h"
+
+#define CAPACITE_INITIALE 16 // doit rester une puissance de 2
+
+typedef struct {
+    double haut;
+    double bas;      // erreurs d'arrondi cumulées des additions de haut
+} SommeCompensee;
+
+typedef struct {
+    char* nom;
+    Produit** membres;
+    size_t taille;
+    size_t capacite;
+    int64_t stock;          // somme des quantités
+    SommeCompensee valeur;  // somme des quantite * prix_unitaire
+    bool a_recalculer;      // touchée par un chargement en lot
+} Categorie;
+
+typedef struct {
+    unsigned long generation;  // cache périmé si différent de la génération globale
+    uint32_t id;
+    char* nom;
+} CacheThread;
+
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static Categorie* categories = NULL;   // la catégorie d'ID n est en categories[n - 1]
+static size_t nb_categories = 0;
+static size_t capacite_categories = 0;
+static uint32_t* table = NULL;         // ID par case, 0 = case libre
+static size_t capacite_table = 0;
+static atomic_ulong generation = 1;
+static _Thread_local CacheThread cache;
+
+static size_t position_ideale(const char* nom) {
+    /*
+    Argument:
+        nom: Libellé de la catégorie
+    But:
+        Hachage FNV-1a du libellé
+    Retour:
+        Indice de la case de départ du sondage
+    */
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (const unsigned char* p = (const unsigned char*)nom; *p != '\0'; p++) {
+        h = (h ^ *p) * 0x100000001B3ULL;
+    }
+    return (size_t)(h & (capacite_table - 1));
+}
+
+static uint32_t trouver(const char* nom) {
+    /*
+    Argument:
+        nom: Libellé recherché (verrou tenu)
+    But:
+        Sonder la table à partir de la position idéale
+    Retour:
+        ID de la catégorie, ou 0 si absente
+    */
+    if (capacite_table == 0) return 0;
+    size_t pos = position_ideale(nom);
+    while (table[pos] != 0) {
+        if (strcmp(categories[table[pos] - 1].nom, nom) == 0) return table[pos];
+        pos = (pos + 1) & (capacite_table - 1);
+    }
+    return 0;
+}
+
+static int redimensionner_table(size_t nouvelle_capacite) {
+    /*
+    Argument:
+        nouvelle_capacite: Nombre de cases (puissance de 2)
+    But:
+        Allouer une nouvelle table et y replacer toutes les catégories
+    Retour:
+        0 si succès, -1 si l'allocation échoue (l'ancienne table reste valide)
+    */
+    uint32_t* nouvelle = (uint32_t*)calloc(nouvelle_capacite, sizeof(uint32_t));
+    if (nouvelle == NULL) return -1;
+    free(table);
+    table = nouvelle;
+    capacite_table = nouvelle_capacite;
+
+    for (size_t i = 0; i < nb_categories; i++) {
+        size_t pos = position_ideale(categories[i].nom);
+        while (table[pos] != 0) {
+            pos = (pos + 1) & (capacite_table - 1);
+        }
+        table[pos] = (uint32_t)(i + 1);
+    }
+    return 0;
+}
+
+static uint32_t creer(const char* nom) {
+    /*
+    Argument:
+        nom: Libellé absent de la table (verrou tenu)
+    But:
+        Copier le libellé et lui attribuer le prochain ID
+    Retour:
+        ID de la nouvelle catégorie, ou 0 en cas d'erreur d'allocation
+    */
+    if ((nb_categories + 1) * 10 > capacite_table * 7) {
+        if (redimensionner_table(capacite_table == 0 ? CAPACITE_INITIALE : capacite_table * 2) != 0) return 0;
+    }
+    if (nb_categories == capacite_categories) {
+        size_t nouvelle = (capacite_categories == 0) ? CAPACITE_INITIALE : capacite_categories * 2;
+        Categorie* agrandi = (Categorie*)realloc(categories, nouvelle * sizeof(Categorie));
+        if (agrandi == NULL) return 0;
+        categories = agrandi;
+        capacite_categories = nouvelle;
+    }
+    size_t longueur = strlen(nom);
+    char* copie = (char*)malloc(longueur + 1);
+    if (copie == NULL) return 0;
+    memcpy(copie, nom, longueur + 1);
+
+    Categorie* c = &categories[nb_categories];
+    c->nom = copie;
+    c->membres = NULL;
+    c->taille = 0;
+    c->capacite = 0;
+    c->stock = 0;
+    c->valeur.haut = 0.0;
+    c->valeur.bas = 0.0;
+    c->a_recalculer = false;
+    nb_categories++;
+    uint32_t id = (uint32_t)nb_categories;
+
+    size_t pos = position_ideale(nom);
+    while (table[pos] != 0) {
+        pos = (pos + 1) & (capacite_table - 1);
+    }
+    table[pos] = id;
+    return id;
+}
+
+uint32_t categories_interner(const char* nom, char** libelle) {
+    /*
+    Argument:
+        nom: Libellé saisi ou lu dans un fichier
+        libelle: Reçoit l'exemplaire partagé du libellé (à ne pas modifier ni libérer)
+    But:
+        Trouver la catégorie ou la créer. Le dernier libellé interné par le
+        thread est vérifié sans verrou (les chargements enchaînent souvent la
+        même catégorie)
+    Retour:
+        ID de la catégorie, ou 0 en cas d'erreur d'allocation
+    */
+    if (nom == NULL) return 0;
+    unsigned long actuelle = atomic_load_explicit(&generation, memory_order_acquire);
+    if (cache.generation == actuelle && cache.nom != NULL && strcmp(cache.nom, nom) == 0) {
+        *libelle = cache.nom;
+        return cache.id;
+    }
+
+    pthread_mutex_lock(&verrou);
+    uint32_t id = trouver(nom);
+    if (id == 0) id = creer(nom);
+    char* exemplaire = (id != 0) ? categories[id - 1].nom : NULL;
+    pthread_mutex_unlock(&verrou);
+
+    if (id != 0) {
+        cache.generation = actuelle;
+        cache.id = id;
+        cache.nom = exemplaire;
+        *libelle = exemplaire;
+    }
+    return id;
+}
+
+uint32_t categories_chercher(const char* nom) {
+    /*
+    Argument:
+        nom: Libellé recherché (casse comprise)
+    But:
+        Trouver une catégorie sans la créer
+    Retour:
+        ID de la catégorie, ou 0 si aucun produit n'en a jamais fait partie
+    */
+    if (nom == NULL) return 0;
+    pthread_mutex_lock(&verrou);
+    uint32_t id = trouver(nom);
+    pthread_mutex_unlock(&verrou);
+    return id;
+}
+
+const char* categories_nom(uint32_t id) {
+    /*
+    Argument:
+        id: ID de catégorie
+    But:
+        Retrouver le libellé d'une catégorie
+    Retour:
+        Le libellé, ou NULL si l'ID est inconnu
+    */
+    if (id == 0 || id > nb_categories) return NULL;
+    return categories[id - 1].nom;
+}
+
+size_t categories_nombre(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Parcourir les catégories (ID de 1 à categories_nombre())
+    Retour:
+        Nombre de catégories internées (certaines peuvent être vides)
+    */
+    return nb_categories;
+}
+
+static void somme_ajouter(SommeCompensee* somme, double terme) {
+    /*
+    Argument:
+        somme: Somme à compléter
+        terme: Valeur à ajouter (négative pour retirer)
+    But:
+        Addition compensée (TwoSum de Knuth) : l'erreur d'arrondi exacte de
+        chaque addition est gardée dans bas, si bien que des milliers d'ajouts
+        et de retraits ne font pas dériver la somme
+    Retour:
+        Aucun
+    */
+    double t = somme->haut + terme;
+    double z = t - somme->haut;
+    somme->bas += (somme->haut - (t - z)) + (terme - z);
+    somme->haut = t;
+}
+
+static void cumuler(Categorie* c, int quantite, float prix_unitaire, int sens) {
+    /*
+    Argument:
+        c: Catégorie du produit
+        quantite, prix_unitaire: Valeurs du produit
+        sens: 1 pour un produit qui entre, -1 pour un produit qui sort
+    But:
+        Mettre à jour le stock et la valeur en O(1). Le produit quantite * prix
+        est découpé en deux termes calculés sans arrondi (16 bits de quantité
+        fois les 24 bits de mantisse du prix) : retirer un produit soustrait
+        exactement ce qui avait été ajouté
+    Retour:
+        Aucun
+    */
+    uint32_t q = (quantite < 0) ? (uint32_t)(-(int64_t)quantite) : (uint32_t)quantite;
+    double signe = (quantite < 0) ? -(double)sens : (double)sens;
+    double prix = (double)prix_unitaire;
+    c->stock += (int64_t)sens * quantite;
+    somme_ajouter(&c->valeur, signe * ((double)(q >> 16) * 65536.0 * prix));
+    somme_ajouter(&c->valeur, signe * ((double)(q & 0xFFFFu) * prix));
+}
+
+static int ajouter_membre(Categorie* c, Produit* produit) {
+    /*
+    Argument:
+        c: Catégorie du produit
+        produit: Produit à ajouter en fin de liste
+    But:
+        Ranger le produit dans la liste de la catégorie (sans les agrégats)
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (c->taille == c->capacite) {
+        size_t nouvelle = (c->capacite == 0) ? 8 : c->capacite * 2;
+        Produit** agrandi = (Produit**)realloc(c->membres, nouvelle * sizeof(Produit*));
+        if (agrandi == NULL) return -1;
+        c->membres = agrandi;
+        c->capacite = nouvelle;
+    }
+    c->membres[c->taille++] = produit;
+    produit->rang_categorie = c->taille; // 0 est réservé à "absent des catégories"
+    return 0;
+}
+
+int categories_ajouter(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui entre dans l'inventaire (id_categorie déjà renseigné)
+    But:
+        Ajouter le produit en fin de liste de sa catégorie et à ses agrégats
+    Retour:
+        0 si succès, -1 si la catégorie est inconnue ou en cas d'erreur d'allocation
+    */
+    if (produit == NULL || produit->id_categorie == 0 || produit->id_categorie > nb_categories) return -1;
+    Categorie* c = &categories[produit->id_categorie - 1];
+    if (ajouter_membre(c, produit) != 0) return -1;
+    cumuler(c, produit->quantite, produit->prix_unitaire, 1);
+    return 0;
+}
+
+int categories_ajouter_lot(Produit* premier) {
+    /*
+    Argument:
+        premier: Premier produit d'une chaîne terminée par NULL (lot de chargement)
+    But:
+        Ajouter chaque produit du lot à sa catégorie, puis recalculer en bloc
+        les agrégats des catégories touchées à partir de leurs membres (ce
+        qui repart aussi d'une somme sans historique d'arrondi)
+    Retour:
+        0 si succès, -1 si au moins un produit n'a pas pu être ajouté
+    */
+    int res = 0;
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+        if (actu->id_categorie == 0 || actu->id_categorie > nb_categories) {
+            res = -1;
+            continue;
+        }
+        Categorie* c = &categories[actu->id_categorie - 1];
+        if (ajouter_membre(c, actu) != 0) {
+            res = -1;
+            continue;
+        }
+        c->a_recalculer = true;
+    }
+
+    for (size_t i = 0; i < nb_categories; i++) {
+        Categorie* c = &categories[i];
+        if (!c->a_recalculer) continue;
+        c->stock = 0;
+        c->valeur.haut = 0.0;
+        c->valeur.bas = 0.0;
+        for (size_t j = 0; j < c->taille; j++) {
+            cumuler(c, c->membres[j]->quantite, c->membres[j]->prix_unitaire, 1);
+        }
+        c->a_recalculer = false;
+    }
+    return res;
+}
+
+void categories_mettre_a_jour(Produit* produit, int quantite, float prix_unitaire) {
+    /*
+    Argument:
+        produit: Membre d'une catégorie dont la quantité ou le prix va changer
+                 (champs encore à leur ancienne valeur)
+        quantite, prix_unitaire: Nouvelles valeurs
+    But:
+        Remplacer la contribution du produit aux agrégats de sa catégorie
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->rang_categorie == 0) return;
+    Categorie* c = &categories[produit->id_categorie - 1];
+    cumuler(c, produit->quantite, produit->prix_unitaire, -1);
+    cumuler(c, quantite, prix_unitaire, 1);
+}
+
+void categories_retirer(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui quitte l'inventaire (ou avant un changement de catégorie)
+    But:
+        Retirer sa contribution aux agrégats et déplacer le dernier membre de
+        sa catégorie dans sa case
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->rang_categorie == 0) return;
+    Categorie* c = &categories[produit->id_categorie - 1];
+    size_t rang = produit->rang_categorie - 1;
+
+    cumuler(c, produit->quantite, produit->prix_unitaire, -1);
+    Produit* dernier = c->membres[c->taille - 1];
+    c->membres[rang] = dernier;
+    dernier->rang_categorie = rang + 1;
+    c->taille--;
+    produit->rang_categorie = 0;
+}
+
+size_t categories_taille(uint32_t id) {
+    /*
+    Argument:
+        id: ID de catégorie
+    But:
+        Connaître le nombre de produits de la catégorie dans l'inventaire
+    Retour:
+        Nombre de membres (0 si l'ID est inconnu)
+    */
+    if (id == 0 || id > nb_categories) return 0;
+    return categories[id - 1].taille;
+}
+
+void categories_agregat(uint32_t id, AgregatCategorie* agregat) {
+    /*
+    Argument:
+        id: ID de catégorie
+        agregat: Résultat
+    But:
+        Lire les agrégats tenus à jour d'une catégorie, en O(1)
+    Retour:
+        Aucun (agrégats nuls si l'ID est inconnu)
+    */
+    if (id == 0 || id > nb_categories) {
+        agregat->produits = 0;
+        agregat->stock = 0;
+        agregat->valeur = 0.0;
+        return;
+    }
+    const Categorie* c = &categories[id - 1];
+    agregat->produits = c->taille;
+    agregat->stock = c->stock;
+    agregat->valeur = c->valeur.haut + c->valeur.bas;
+}
+
+Produit* categories_membre(uint32_t id, size_t rang) {
+    /*
+    Argument:
+        id: ID de catégorie
+        rang: Rang du membre (de 0 à categories_taille(id) - 1)
+    But:
+        Parcourir les produits d'une seule catégorie
+    Retour:
+        Le produit, ou NULL si hors limites
+    */
+    if (id == 0 || id > nb_categories || rang >= categories[id - 1].taille) return NULL;
+    return categories[id - 1].membres[rang];
+}
+
+void categories_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer les libellés, les listes et la table (appelé quand toute la
+        liste est libérée) ; les caches des threads deviennent périmés
+    Retour:
+        Aucun
+    */
+    pthread_mutex_lock(&verrou);
+    for (size_t i = 0; i < nb_categories; i++) {
+        free(categories[i].nom);
+        free(categories[i].membres);
+    }
+    free(categories);
+    free(table);
+    categories = NULL;
+    nb_categories = 0;
+    capacite_categories = 0;
+    table = NULL;
+    capacite_table = 0;
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+    pthread_mutex_unlock(&verrou);
+}
@@ -0,0 +1,49 @@
+#ifndef _CATEGORIES_H
+#define _CATEGORIES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Catégories internées et index secondaire par catégorie :
+    - Chaque libellé distinct est rangé une seule fois ; les produits pointent
+      dessus (categorie, jamais modifié sur place) et gardent son numéro
+      (id_categorie, à partir de 1).
+    - categories_interner peut être appelée par les threads de chargement
+      (verrou, évité par un cache du dernier libellé de chaque thread).
+    - Chaque catégorie tient la liste de ses produits, chaque produit garde son
+      rang (rang_categorie) : lister ou agréger une catégorie ne parcourt
+      qu'elle. Maintenu par insertion, insertion_lot, modifier_produit (si la
+      catégorie change), suppression_par_id et free_struct_produit.
+    - Un retrait déplace le dernier membre dans le trou : l'ordre des membres
+      n'est pas celui de la liste.
+    - Chaque catégorie tient aussi ses agrégats (nombre de produits, stock,
+      valeur quantite * prix), mis à jour en O(1) à chaque ajout, retrait ou
+      modification (categories_mettre_a_jour) et recalculés en bloc pour les
+      catégories touchées par un chargement. La valeur est une somme
+      compensée : elle ne dérive pas au fil des mises à jour.
+*/
+
+typedef struct {
+    size_t produits;
+    int64_t stock;
+    double valeur;
+} AgregatCategorie;
+
+uint32_t categories_interner(const char* nom, char** libelle);
+uint32_t categories_chercher(const char* nom);
+const char* categories_nom(uint32_t id);
+size_t categories_nombre(void);
+
+int categories_ajouter(Produit* produit);
+int categories_ajouter_lot(Produit* premier);
+void categories_retirer(Produit* produit);
+void categories_mettre_a_jour(Produit* produit, int quantite, float prix_unitaire);
+void categories_agregat(uint32_t id, AgregatCategorie* agregat);
+size_t categories_taille(uint32_t id);
+Produit* categories_membre(uint32_t id, size_t rang);
+void categories_liberer(void);
+
+#endif
@@ -0,0 +1,208 @@
+/*
+Nom du fichier : cle_recherche.c
+Fait par : Erwann GIRAULT
+But : Normalisation des noms en clés de recherche (casse et accents) et
+      recherche vectorisée d'une clé dans une autre
+*/
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cle_recherche.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define CLE_X86 1
+#endif
+
+typedef bool (*FonctionContient)(const char*, size_t, const char*, size_t);
+
+static FonctionContient contient_actif = NULL;
+static pthread_once_t init_noyau = PTHREAD_ONCE_INIT;
+
+/*
+    Lettre de base des caractères U+00C0 à U+00FF (second octet UTF-8 après 0xC3).
+    '?' : pas d'équivalent sur une lettre (Æ, Ð, ×, Þ, ß, ...), les deux octets sont gardés.
+*/
+static const char lettres_latin1[64] =
+    "aaaaaa?ceeeeiiii" "?nooooo?ouuuuy??"
+    "aaaaaa?ceeeeiiii" "?nooooo?ouuuuy?y";
+
+size_t cle_normaliser(const char* texte, char* cle) {
+    /*
+    Argument:
+        texte: Nom ou motif, terminé par '\0'
+        cle: Destination, au moins strlen(texte) + 1 octets (peut être texte lui-même)
+    But:
+        Mettre les lettres ASCII en minuscules sans dépendre de la locale, et
+        remplacer les lettres accentuées (UTF-8 sur deux octets) par leur lettre de base
+    Retour:
+        Longueur de la clé (sans le '\0')
+    */
+    const unsigned char* s = (const unsigned char*)texte;
+    size_t n = 0;
+    while (*s != '\0') {
+        unsigned char c = *s;
+        if (c >= 'A' && c <= 'Z') {
+            cle[n++] = (char)(c + ('a' - 'A'));
+            s++;
+        } else if (c == 0xC3 && s[1] >= 0x80 && s[1] <= 0xBF) {
+            char base = lettres_latin1[s[1] - 0x80];
+            if (base != '?') {
+                cle[n++] = base;
+            } else {
+                // Majuscule sans lettre de base (Æ, Ð, Þ) : même écart que l'ASCII
+                unsigned char suite = s[1];
+                if (suite >= 0x80 && suite <= 0x9E && suite != 0x97) suite += 0x20;
+                cle[n++] = (char)c;
+                cle[n++] = (char)suite;
+            }
+            s += 2;
+        } else {
+            cle[n++] = (char)c;
+            s++;
+        }
+    }
+    cle[n] = '\0';
+    return n;
+}
+
+static bool contient_scalaire(const char* cle, size_t n, const char* motif, size_t m) {
+    /*
+    Argument:
+        cle, n: Clé examinée et sa longueur
+        motif, m: Motif normalisé et sa longueur (1 <= m <= n)
+    But:
+        Version de référence : chaque occurrence du premier octet est vérifiée
+    Retour:
+        true si la clé contient le motif
+    */
+    const char* fin = cle + (n - m) + 1; // dernière position de départ possible, exclue
+    for (const char* p = cle; p < fin; p++) {
+        p = (const char*)memchr(p, motif[0], (size_t)(fin - p));
+        if (p == NULL) return false;
+        if (memcmp(p + 1, motif + 1, m - 1) == 0) return true;
+    }
+    return false;
+}
+
+#ifdef CLE_X86
+static bool contient_sse2(const char* cle, size_t n, const char* motif, size_t m) {
+    /*
+    Argument:
+        cle, n, motif, m: Comme contient_scalaire
+    But:
+        Tester 16 positions de départ à la fois : une position n'est vérifiée
+        octet par octet que si le premier et le dernier octet du motif y sont
+        tous les deux à leur place
+    Retour:
+        true si la clé contient le motif
+    */
+    __m128i premier = _mm_set1_epi8(motif[0]);
+    __m128i dernier = _mm_set1_epi8(motif[m - 1]);
+    size_t i = 0;
+    // Le bloc du dernier octet commence à i + m - 1 : il doit tenir dans la clé
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i debut = _mm_loadu_si128((const __m128i*)(cle + i));
+        __m128i fin = _mm_loadu_si128((const __m128i*)(cle + i + m - 1));
+        unsigned int masque = (unsigned int)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(debut, premier), _mm_cmpeq_epi8(fin, dernier)));
+        while (masque != 0) {
+            unsigned int bit = (unsigned int)__builtin_ctz(masque);
+            if (memcmp(cle + i + bit + 1, motif + 1, m - 1) == 0) return true;
+            masque &= masque - 1;
+        }
+    }
+    return (i + m <= n) && contient_scalaire(cle + i, n - i, motif, m);
+}
+
+__attribute__((target("avx2")))
+static bool contient_avx2(const char* cle, size_t n, const char* motif, size_t m) {
+    /*
+    Argument:
+        cle, n, motif, m: Comme contient_scalaire
+    But:
+        Même filtre que la version SSE2 sur 32 positions ; le reste (noms
+        courts, fin de clé) passe par la version SSE2
+    Retour:
+        true si la clé contient le motif
+    */
+    __m256i premier = _mm256_set1_epi8(motif[0]);
+    __m256i dernier = _mm256_set1_epi8(motif[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i debut = _mm256_loadu_si256((const __m256i*)(cle + i));
+        __m256i fin = _mm256_loadu_si256((const __m256i*)(cle + i + m - 1));
+        unsigned int masque = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(debut, premier), _mm256_cmpeq_epi8(fin, dernier)));
+        while (masque != 0) {
+            unsigned int bit = (unsigned int)__builtin_ctz(masque);
+            if (memcmp(cle + i + bit + 1, motif + 1, m - 1) == 0) return true;
+            masque &= masque - 1;
+        }
+    }
+    return (i + m <= n) && contient_sse2(cle + i, n - i, motif, m);
+}
+#endif
+
+static void detecter_noyau(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Choisir le meilleur noyau disponible sur le processeur (appelé une seule fois)
+    Retour:
+        Aucun
+    */
+    contient_actif = contient_scalaire;
+#ifdef CLE_X86
+    contient_actif = contient_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        contient_actif = contient_avx2;
+    }
+#endif
+}
+
+bool cle_contient(const char* cle, size_t longueur_cle, const char* motif, size_t longueur_motif) {
+    /*
+    Argument:
+        cle, longueur_cle: Clé d'un produit (cle_nom) et sa longueur
+        motif, longueur_motif: Motif passé par cle_normaliser et sa longueur
+    But:
+        Recherche de sous-chaîne sur des clés normalisées : aucune conversion
+        de casse n'est refaite ici. Aucun octet n'est lu au-delà des longueurs
+    Retour:
+        true si la clé contient le motif (toujours vrai pour un motif vide)
+    */
+    if (longueur_motif == 0) return true;
+    if (longueur_motif > longueur_cle) return false;
+    pthread_once(&init_noyau, detecter_noyau);
+    return contient_actif(cle, longueur_cle, motif, longueur_motif);
+}
+
+int cle_utiliser_simd(bool actif) {
+    /*
+    Argument:
+        actif: false pour imposer la version scalaire (mesures, vérification)
+    But:
+        Choisir la version de la recherche de sous-chaîne
+    Retour:
+        0 si le choix est appliqué, -1 si aucune version vectorisée n'est disponible
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+    if (!actif) {
+        contient_actif = contient_scalaire;
+        return 0;
+    }
+#ifdef CLE_X86
+    contient_actif = __builtin_cpu_supports("avx2") ? contient_avx2 : contient_sse2;
+    return 0;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef _CLE_RECHERCHE_H
+#define _CLE_RECHERCHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+    Clé de recherche d'un nom :
+    - Lettres ASCII en minuscules, lettres accentuées UTF-8 (Latin-1) ramenées
+      à leur lettre de base ("Sérum" -> "serum"), autres octets inchangés.
+    - La clé n'est jamais plus longue que le texte : un tampon de
+      strlen(texte) + 1 octets suffit.
+    - Calculée une fois par creer_produit, adopter_produit et modifier_produit,
+      et rangée dans l'arène avec les autres chaînes du produit.
+    - cle_contient compare deux clés déjà normalisées, 16 ou 32 positions à la
+      fois (SSE2/AVX2 choisi au premier appel, version scalaire ailleurs).
+*/
+
+size_t cle_normaliser(const char* texte, char* cle);
+bool cle_contient(const char* cle, size_t longueur_cle, const char* motif, size_t longueur_motif);
+int cle_utiliser_simd(bool actif);
+
+#endif
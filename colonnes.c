@@ -0,0 +1,419 @@
+/*
+Nom du fichier : colonnes.c
+Fait par : Erwann GIRAULT
+But : Copie en colonnes (tableaux contigus) des champs numériques des produits,
+      pour calculer les agrégats du stock sans parcourir la liste chaînée
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "colonnes.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define COLONNES_X86 1
+#endif
+
+#define CAPACITE_INITIALE 64
+
+static uint32_t* ids = NULL;
+static int32_t* quantites = NULL;
+static float* prix = NULL;
+static int64_t* dates = NULL;
+static Produit** produits = NULL;
+static size_t capacite = 0;
+static size_t nb_elements = 0;
+
+static bool avx2_actif = false;
+static pthread_once_t init_noyau = PTHREAD_ONCE_INIT;
+
+static int reserver(size_t nb_elements_prevus) {
+    /*
+    Argument:
+        nb_elements_prevus: Nombre total d'éléments à pouvoir ranger
+    But:
+        Agrandir les cinq colonnes (capacité doublée) ; en cas d'échec, les
+        colonnes déjà agrandies restent valides et la capacité ne change pas
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (nb_elements_prevus <= capacite) return 0;
+    size_t nouvelle = (capacite == 0) ? CAPACITE_INITIALE : capacite;
+    while (nouvelle < nb_elements_prevus) nouvelle *= 2;
+
+    uint32_t* n_ids = (uint32_t*)realloc(ids, nouvelle * sizeof(uint32_t));
+    if (n_ids == NULL) return -1;
+    ids = n_ids;
+    int32_t* n_quantites = (int32_t*)realloc(quantites, nouvelle * sizeof(int32_t));
+    if (n_quantites == NULL) return -1;
+    quantites = n_quantites;
+    float* n_prix = (float*)realloc(prix, nouvelle * sizeof(float));
+    if (n_prix == NULL) return -1;
+    prix = n_prix;
+    int64_t* n_dates = (int64_t*)realloc(dates, nouvelle * sizeof(int64_t));
+    if (n_dates == NULL) return -1;
+    dates = n_dates;
+    Produit** n_produits = (Produit**)realloc(produits, nouvelle * sizeof(Produit*));
+    if (n_produits == NULL) return -1;
+    produits = n_produits;
+
+    capacite = nouvelle;
+    return 0;
+}
+
+static void ecrire(size_t rang, Produit* produit) {
+    /*
+    Argument:
+        rang: Case des colonnes
+        produit: Produit à y recopier
+    But:
+        Recopier les champs numériques et mémoriser le rang dans le produit
+    Retour:
+        Aucun
+    */
+    ids[rang] = produit->id;
+    quantites[rang] = produit->quantite;
+    prix[rang] = produit->prix_unitaire;
+    dates[rang] = (int64_t)produit->date_peremption;
+    produits[rang] = produit;
+    produit->rang_colonne = rang + 1; // 0 est réservé à "absent des colonnes"
+}
+
+int colonnes_ajouter(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui entre dans l'inventaire
+    But:
+        Ajouter le produit en fin de colonnes
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (produit == NULL) return -1;
+    if (reserver(nb_elements + 1) != 0) return -1;
+    ecrire(nb_elements, produit);
+    nb_elements++;
+    return 0;
+}
+
+int colonnes_ajouter_lot(Produit* premier) {
+    /*
+    Argument:
+        premier: Premier produit d'une chaîne terminée par NULL (lot de chargement)
+    But:
+        Agrandir les colonnes une seule fois puis y recopier tout le lot
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (aucun produit ajouté)
+    */
+    size_t nb = 0;
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) nb++;
+    if (reserver(nb_elements + nb) != 0) return -1;
+
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+        ecrire(nb_elements, actu);
+        nb_elements++;
+    }
+    return 0;
+}
+
+void colonnes_mettre_a_jour(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit dont les champs numériques ont changé
+    But:
+        Recopier ses nouvelles valeurs à son rang
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->rang_colonne == 0) return;
+    ecrire(produit->rang_colonne - 1, produit);
+}
+
+void colonnes_retirer(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui quitte l'inventaire
+    But:
+        Combler sa case avec le dernier élément des colonnes
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->rang_colonne == 0) return;
+    size_t rang = produit->rang_colonne - 1;
+    nb_elements--;
+    if (rang != nb_elements) {
+        ecrire(rang, produits[nb_elements]);
+    }
+    produit->rang_colonne = 0;
+}
+
+size_t colonnes_taille(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Connaître le nombre de produits dans les colonnes
+    Retour:
+        Nombre d'éléments
+    */
+    return nb_elements;
+}
+
+Produit* colonnes_produit(size_t rang) {
+    /*
+    Argument:
+        rang: Indice dans les colonnes (0 à colonnes_taille() - 1)
+    But:
+        Retrouver le produit (et donc ses chaînes) d'une case des colonnes
+    Retour:
+        Pointeur vers le produit, ou NULL si le rang est hors limites
+    */
+    return (rang < nb_elements) ? produits[rang] : NULL;
+}
+
+void colonnes_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer les colonnes (appelé quand toute la liste est libérée)
+    Retour:
+        Aucun
+    */
+    free(ids);
+    free(quantites);
+    free(prix);
+    free(dates);
+    free(produits);
+    ids = NULL;
+    quantites = NULL;
+    prix = NULL;
+    dates = NULL;
+    produits = NULL;
+    capacite = 0;
+    nb_elements = 0;
+}
+
+/* ---- Agrégats ---- */
+
+static double valeur_scalaire(const int32_t* q, const float* p, size_t n) {
+    /*
+    Argument:
+        q, p: Colonnes des quantités et des prix
+        n: Nombre d'éléments
+    But:
+        Somme des quantité x prix en double, sur quatre accumulateurs : même
+        ordre d'addition que la version AVX2, donc même résultat au bit près
+    Retour:
+        Valeur totale du stock
+    */
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            acc[k] += (double)q[i + k] * (double)p[i + k];
+        }
+    }
+    double total = (acc[0] + acc[2]) + (acc[1] + acc[3]);
+    for (; i < n; i++) {
+        total += (double)q[i] * (double)p[i];
+    }
+    return total;
+}
+
+static size_t stock_faible_scalaire(const int32_t* q, size_t n, int seuil) {
+    /*
+    Argument:
+        q: Colonne des quantités
+        n: Nombre d'éléments
+        seuil: Quantité minimale attendue
+    But:
+        Compter les quantités strictement inférieures au seuil
+    Retour:
+        Nombre de produits concernés
+    */
+    size_t nb = 0;
+    for (size_t i = 0; i < n; i++) {
+        nb += (q[i] < seuil);
+    }
+    return nb;
+}
+
+static size_t peremption_scalaire(const int64_t* d, size_t n, int64_t limite) {
+    /*
+    Argument:
+        d: Colonne des dates de péremption
+        n: Nombre d'éléments
+        limite: Timestamp
+    But:
+        Compter les dates renseignées (différentes de 0) antérieures à la limite
+    Retour:
+        Nombre de produits concernés
+    */
+    size_t nb = 0;
+    for (size_t i = 0; i < n; i++) {
+        nb += (d[i] > 0 && d[i] < limite);
+    }
+    return nb;
+}
+
+#ifdef COLONNES_X86
+__attribute__((target("avx2")))
+static double valeur_avx2(const int32_t* q, const float* p, size_t n) {
+    /*
+    Argument:
+        q, p, n: Comme valeur_scalaire
+    But:
+        Quatre produits par tour : conversion en double des quantités et des
+        prix, multiplication et accumulation sur 4 voies
+    Retour:
+        Valeur totale du stock
+    */
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vq = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(q + i)));
+        __m256d vp = _mm256_cvtps_pd(_mm_loadu_ps(p + i));
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(vq, vp));
+    }
+    __m128d somme = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double total = _mm_cvtsd_f64(somme) + _mm_cvtsd_f64(_mm_unpackhi_pd(somme, somme));
+    for (; i < n; i++) {
+        total += (double)q[i] * (double)p[i];
+    }
+    return total;
+}
+
+__attribute__((target("avx2")))
+static size_t stock_faible_avx2(const int32_t* q, size_t n, int seuil) {
+    /*
+    Argument:
+        q, n, seuil: Comme stock_faible_scalaire
+    But:
+        Comparer 8 quantités à la fois et compter les bits du masque
+    Retour:
+        Nombre de produits concernés
+    */
+    __m256i vseuil = _mm256_set1_epi32(seuil);
+    size_t nb = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i vq = _mm256_loadu_si256((const __m256i*)(q + i));
+        unsigned int masque = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vseuil, vq)));
+        nb += (size_t)__builtin_popcount(masque);
+    }
+    return nb + stock_faible_scalaire(q + i, n - i, seuil);
+}
+
+__attribute__((target("avx2")))
+static size_t peremption_avx2(const int64_t* d, size_t n, int64_t limite) {
+    /*
+    Argument:
+        d, n, limite: Comme peremption_scalaire
+    But:
+        Tester 4 dates à la fois (0 < date < limite) et compter les bits du masque
+    Retour:
+        Nombre de produits concernés
+    */
+    __m256i vlimite = _mm256_set1_epi64x(limite);
+    __m256i zero = _mm256_setzero_si256();
+    size_t nb = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i vd = _mm256_loadu_si256((const __m256i*)(d + i));
+        __m256i dans = _mm256_and_si256(_mm256_cmpgt_epi64(vd, zero), _mm256_cmpgt_epi64(vlimite, vd));
+        nb += (size_t)__builtin_popcount((unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(dans)));
+    }
+    return nb + peremption_scalaire(d + i, n - i, limite);
+}
+#endif
+
+static void detecter_noyau(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Activer les agrégats AVX2 si le processeur les supporte (appelé une seule fois)
+    Retour:
+        Aucun
+    */
+#ifdef COLONNES_X86
+    __builtin_cpu_init();
+    avx2_actif = __builtin_cpu_supports("avx2");
+#endif
+}
+
+int colonnes_utiliser_avx2(bool actif) {
+    /*
+    Argument:
+        actif: false pour imposer la version scalaire (mesures, vérification)
+    But:
+        Choisir la version des agrégats
+    Retour:
+        0 si le choix est appliqué, -1 si l'AVX2 n'est pas disponible
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+    if (!actif) {
+        avx2_actif = false;
+        return 0;
+    }
+#ifdef COLONNES_X86
+    if (__builtin_cpu_supports("avx2")) {
+        avx2_actif = true;
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+double colonnes_valeur_stock(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Valeur totale du stock (somme des quantité x prix unitaire)
+    Retour:
+        Valeur du stock
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+#ifdef COLONNES_X86
+    if (avx2_actif) return valeur_avx2(quantites, prix, nb_elements);
+#endif
+    return valeur_scalaire(quantites, prix, nb_elements);
+}
+
+size_t colonnes_compter_stock_faible(int seuil) {
+    /*
+    Argument:
+        seuil: Quantité en dessous de laquelle le stock est jugé faible
+    But:
+        Compter les produits dont la quantité est inférieure au seuil
+    Retour:
+        Nombre de produits
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+#ifdef COLONNES_X86
+    if (avx2_actif) return stock_faible_avx2(quantites, nb_elements, seuil);
+#endif
+    return stock_faible_scalaire(quantites, nb_elements, seuil);
+}
+
+size_t colonnes_compter_peremption_avant(time_t limite) {
+    /*
+    Argument:
+        limite: Timestamp
+    But:
+        Compter les produits datés qui seront périmés avant la limite
+    Retour:
+        Nombre de produits
+    */
+    pthread_once(&init_noyau, detecter_noyau);
+#ifdef COLONNES_X86
+    if (avx2_actif) return peremption_avx2(dates, nb_elements, (int64_t)limite);
+#endif
+    return peremption_scalaire(dates, nb_elements, (int64_t)limite);
+}
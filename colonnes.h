@@ -0,0 +1,40 @@
+#ifndef _COLONNES_H
+#define _COLONNES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "gestion_produit.h"
+
+/*
+    Stockage en colonnes des champs numériques de l'inventaire :
+    - Tableaux contigus : ids, quantités, prix, dates de péremption, et le
+      produit (qui porte les chaînes) au même rang.
+    - Maintenu par insertion, insertion_lot, modifier_produit, suppression_par_id
+      et free_struct_produit ; chaque produit garde son rang (rang_colonne).
+    - Un retrait déplace le dernier élément dans le trou : l'ordre des colonnes
+      n'est pas celui de la liste.
+    - Les agrégats parcourent les colonnes sans toucher aux produits, en AVX2
+      si le processeur le permet (même résultat que la version scalaire).
+*/
+
+// Seuils du résumé du stock (menu et mode commandes)
+#define SEUIL_STOCK_FAIBLE 5
+#define HORIZON_PEREMPTION_JOURS 7
+
+int colonnes_ajouter(Produit* produit);
+int colonnes_ajouter_lot(Produit* premier);
+void colonnes_mettre_a_jour(Produit* produit);
+void colonnes_retirer(Produit* produit);
+size_t colonnes_taille(void);
+Produit* colonnes_produit(size_t rang);
+void colonnes_liberer(void);
+
+double colonnes_valeur_stock(void);
+size_t colonnes_compter_stock_faible(int seuil);
+size_t colonnes_compter_peremption_avant(time_t limite);
+int colonnes_utiliser_avx2(bool actif);
+
+#endif
@@ -0,0 +1,557 @@
+/*
+Nom du fichier : commandes.c
+Fait par : Erwann GIRAULT
+But : Mode commandes non interactif : exécute un script de commandes
+      (fichier ou entrée standard) sur l'inventaire, sans menu ni invite
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <float.h>
+#include <time.h>
+
+#include "commandes.h"
+#include "index_id.h"
+#include "index_nom.h"
+#include "colonnes.h"
+#include "categories.h"
+#include "index_tri.h"
+#include "journal_ops.h"
+#include "stats.h"
+
+#define NB_CHAMPS_PRODUIT 7 // nom|description|categorie|quantite|prix|date|note
+
+typedef struct {
+    const char* nom;
+    const char* description;
+    const char* categorie;
+    const char* quantite;
+    const char* prix;
+    const char* date;
+    const char* note;
+} ChampsProduit;
+
+typedef enum {
+    ACCES_AUCUN,
+    ACCES_LECTURE,
+    ACCES_ECRITURE
+} Acces;
+
+static bool lire_entier(const char* texte, long min, long max, long* valeur) {
+    /*
+    Argument:
+        texte: Champ à convertir
+        min, max: Bornes acceptées
+        valeur: Résultat
+    But:
+        Conversion stricte : tout le champ doit être un entier dans les bornes
+    Retour:
+        true si la conversion est valide
+    */
+    if (texte == NULL || *texte == '\0') return false;
+    char* fin;
+    errno = 0;
+    long v = strtol(texte, &fin, 10);
+    if (errno != 0 || *fin != '\0' || v < min || v > max) return false;
+    *valeur = v;
+    return true;
+}
+
+static bool lire_prix(const char* texte, double* valeur) {
+    /*
+    Argument:
+        texte: Champ à convertir
+        valeur: Résultat
+    But:
+        Conversion stricte d'un prix positif et représentable en float
+        (prix_unitaire) : "inf", "nan" et les valeurs au-delà de FLT_MAX sont
+        refusés, un infini fausserait pour de bon les totaux des colonnes et
+        des catégories
+    Retour:
+        true si la conversion est valide
+    */
+    if (texte == NULL || *texte == '\0') return false;
+    char* fin;
+    errno = 0;
+    double v = strtod(texte, &fin);
+    if (errno != 0 || *fin != '\0' || !(v >= 0.0 && v <= FLT_MAX)) return false;
+    *valeur = v;
+    return true;
+}
+
+static bool decouper_produit(char* texte, ChampsProduit* champs) {
+    /*
+    Argument:
+        texte: "nom|description|categorie|quantite|prix|date|note" (modifié sur place)
+        champs: Pointeurs vers chaque champ (la note peut manquer)
+    But:
+        Séparer les champs d'un produit au délimiteur de la sauvegarde
+    Retour:
+        true si le nombre de champs est correct (6 ou 7)
+    */
+    const char* parties[NB_CHAMPS_PRODUIT] = {NULL, NULL, NULL, NULL, NULL, NULL, ""};
+    int nb = 0;
+    char* p = texte;
+    while (nb < NB_CHAMPS_PRODUIT) {
+        parties[nb++] = p;
+        char* sep = strchr(p, '|');
+        if (sep == NULL) break;
+        *sep = '\0';
+        p = sep + 1;
+        if (nb == NB_CHAMPS_PRODUIT) return false; // champ en trop
+    }
+    if (nb < NB_CHAMPS_PRODUIT - 1) return false;
+
+    champs->nom = parties[0];
+    champs->description = parties[1];
+    champs->categorie = parties[2];
+    champs->quantite = parties[3];
+    champs->prix = parties[4];
+    champs->date = parties[5];
+    champs->note = parties[6];
+    return true;
+}
+
+static void ecrire_produit(FILE* sortie, const Produit* p) {
+    /*
+    Argument:
+        sortie: Flux de sortie
+        p: Produit à écrire
+    But:
+        Une ligne au format de la sauvegarde
+    Retour:
+        Aucun
+    */
+    fprintf(sortie, "%u|%s|%s|%s|%d|%.2f|%ld|%s\n", p->id, p->nom, p->description, p->categorie,
+            p->quantite, p->prix_unitaire, (long)p->date_peremption, p->note);
+}
+
+static int erreur(FILE* sortie, size_t numero, const char* message) {
+    /*
+    Argument:
+        sortie: Flux de sortie
+        numero: Numéro de la ligne de commande
+        message: Cause de l'erreur
+    But:
+        Répondre une erreur (sur la sortie, dans l'ordre des réponses)
+    Retour:
+        -1
+    */
+    fprintf(sortie, "erreur %zu : %s\n", numero, message);
+    return -1;
+}
+
+static int commande_ajouter(char* arguments, size_t numero, FILE* sortie, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        arguments: Champs du produit
+        numero, sortie: Voir erreur
+        head, max_id: Inventaire et compteur d'ID
+    But:
+        Créer et insérer un produit avec le prochain ID
+    Retour:
+        0 si succès, -1 sinon
+    */
+    ChampsProduit c;
+    long quantite, date;
+    double prix;
+    if (!decouper_produit(arguments, &c)) return erreur(sortie, numero, "add attend nom|description|categorie|quantite|prix|date|note");
+    if (*c.nom == '\0' || *c.categorie == '\0') return erreur(sortie, numero, "nom et categorie obligatoires");
+    if (!lire_entier(c.quantite, 0, INT_MAX, &quantite)) return erreur(sortie, numero, "quantite invalide");
+    if (!lire_prix(c.prix, &prix)) return erreur(sortie, numero, "prix invalide");
+    if (!lire_entier(c.date, 0, LONG_MAX, &date)) return erreur(sortie, numero, "date invalide");
+
+    uint32_t id = *max_id + 1;
+    Produit* nouveau = creer_produit(id, c.nom, c.description, c.categorie, (int)quantite, (float)prix, (time_t)date, c.note);
+    if (nouveau == NULL) return erreur(sortie, numero, "produit refuse (nom > 64 ou description > 1024 caracteres)");
+    if (insertion(head, nouveau) != 0) {
+        liberer_produit(nouveau);
+        return erreur(sortie, numero, "echec allocation memoire");
+    }
+    *max_id = id;
+    fprintf(sortie, "ok %u\n", id);
+    return 0;
+}
+
+static int commande_modifier(char* arguments, size_t numero, FILE* sortie) {
+    /*
+    Argument:
+        arguments: "ID champs" (un champ vide garde la valeur actuelle)
+        numero, sortie: Voir erreur
+    But:
+        Modifier un produit existant
+    Retour:
+        0 si succès, -1 sinon
+    */
+    char* espace = strchr(arguments, ' ');
+    if (espace == NULL) return erreur(sortie, numero, "mod attend ID nom|description|categorie|quantite|prix|date|note");
+    *espace = '\0';
+
+    long id;
+    if (!lire_entier(arguments, 1, UINT32_MAX, &id)) return erreur(sortie, numero, "ID invalide");
+    Produit* p = index_id_chercher((uint32_t)id);
+    if (p == NULL) return erreur(sortie, numero, "ID introuvable");
+
+    ChampsProduit c;
+    if (!decouper_produit(espace + 1, &c)) return erreur(sortie, numero, "mod attend ID nom|description|categorie|quantite|prix|date|note");
+    long quantite = p->quantite;
+    long date = (long)p->date_peremption;
+    double prix = p->prix_unitaire;
+    if (*c.quantite != '\0' && !lire_entier(c.quantite, 0, INT_MAX, &quantite)) return erreur(sortie, numero, "quantite invalide");
+    if (*c.prix != '\0' && !lire_prix(c.prix, &prix)) return erreur(sortie, numero, "prix invalide");
+    if (*c.date != '\0' && !lire_entier(c.date, 0, LONG_MAX, &date)) return erreur(sortie, numero, "date invalide");
+
+    if (modifier_produit(p, (*c.nom != '\0') ? c.nom : p->nom,
+                         (*c.description != '\0') ? c.description : p->description,
+                         (*c.categorie != '\0') ? c.categorie : p->categorie,
+                         (int)quantite, (float)prix, (time_t)date,
+                         (*c.note != '\0') ? c.note : p->note) == NULL) {
+        return erreur(sortie, numero, "modification refusee");
+    }
+    fprintf(sortie, "ok %u\n", p->id);
+    return 0;
+}
+
+static int commande_rechercher(const char* motif, size_t numero, FILE* sortie) {
+    /*
+    Argument:
+        motif: Texte recherché (reste de la ligne)
+        numero, sortie: Voir erreur
+    But:
+        Lister les produits dont le nom contient le motif, par ID croissant
+    Retour:
+        0 si succès, -1 si la recherche a manqué de mémoire
+    */
+    Produit** resultats;
+    size_t nb;
+    if (index_nom_rechercher(motif, &resultats, &nb) != 0) return erreur(sortie, numero, "memoire insuffisante pour la recherche");
+    for (size_t i = 0; i < nb; i++) {
+        ecrire_produit(sortie, resultats[i]);
+    }
+    free(resultats);
+    fprintf(sortie, "ok %zu\n", nb);
+    return 0;
+}
+
+static int commande_lister(char* arguments, size_t numero, FILE* sortie, const Produit* head) {
+    /*
+    Argument:
+        arguments: "" ou "DEBUT" ou "DEBUT LIMITE" (pagination, LIMITE 0 = jusqu'à la fin)
+        numero, sortie: Voir erreur
+        head: Premier produit de la liste
+    But:
+        Lister une page de l'inventaire dans l'ordre de la liste
+    Retour:
+        0 si succès, -1 si la pagination est invalide
+    */
+    long debut = 0, limite = 0;
+    char* espace = strchr(arguments, ' ');
+    if (espace != NULL) *espace = '\0';
+    if ((*arguments != '\0' && !lire_entier(arguments, 0, LONG_MAX, &debut))
+        || (espace != NULL && !lire_entier(espace + 1, 0, LONG_MAX, &limite))) {
+        return erreur(sortie, numero, "list attend [debut [limite]]");
+    }
+
+    const Produit* actu = head;
+    for (long i = 0; i < debut && actu != NULL; i++) {
+        actu = actu->suivant;
+    }
+    size_t nb = 0;
+    for (; actu != NULL && (limite == 0 || nb < (size_t)limite); actu = actu->suivant, nb++) {
+        ecrire_produit(sortie, actu);
+    }
+    fprintf(sortie, "ok %zu\n", nb);
+    return 0;
+}
+
+static int commande_categorie(const char* nom, FILE* sortie) {
+    /*
+    Argument:
+        nom: Libellé de la catégorie
+        sortie: Flux de sortie
+    But:
+        Lister les produits d'une seule catégorie
+    Retour:
+        0
+    */
+    uint32_t id = categories_chercher(nom);
+    size_t taille = categories_taille(id);
+    for (size_t i = 0; i < taille; i++) {
+        ecrire_produit(sortie, categories_membre(id, i));
+    }
+    fprintf(sortie, "ok %zu\n", taille);
+    return 0;
+}
+
+static int commande_agregats(FILE* sortie) {
+    /*
+    Argument:
+        sortie: Flux de sortie
+    But:
+        Écrire les agrégats tenus à jour de chaque catégorie non vide :
+        "nom|produits|stock|valeur"
+    Retour:
+        0
+    */
+    size_t nb = 0;
+    for (uint32_t id = 1; id <= categories_nombre(); id++) {
+        AgregatCategorie agregat;
+        categories_agregat(id, &agregat);
+        if (agregat.produits == 0) continue;
+        fprintf(sortie, "%s|%zu|%lld|%.2f\n", categories_nom(id), agregat.produits,
+                (long long)agregat.stock, agregat.valeur);
+        nb++;
+    }
+    fprintf(sortie, "ok %zu\n", nb);
+    return 0;
+}
+
+static int commande_trier(char* arguments, size_t numero, FILE* sortie) {
+    /*
+    Argument:
+        arguments: "CRITERE [LIMITE [desc]]" avec CRITERE prix, quantite ou
+                   peremption (LIMITE 0 = toute la vue)
+        numero, sortie: Voir erreur
+    But:
+        Lister les produits dans l'ordre d'une vue triée, du plus petit au plus
+        grand (ou l'inverse avec "desc"), sans trier l'inventaire
+    Retour:
+        0 si succès, -1 si les arguments sont invalides
+    */
+    char* suite = NULL;
+    char* mot = strtok_r(arguments, " ", &suite);
+    char* texte_limite = strtok_r(NULL, " ", &suite);
+    char* ordre = strtok_r(NULL, " ", &suite);
+    CritereTri critere;
+    long limite = 0;
+    if (mot == NULL || index_tri_critere_depuis_chaine(mot, &critere) != 0
+        || (texte_limite != NULL && !lire_entier(texte_limite, 0, LONG_MAX, &limite))
+        || (ordre != NULL && strcmp(ordre, "desc") != 0) || strtok_r(NULL, " ", &suite) != NULL) {
+        return erreur(sortie, numero, "top attend prix|quantite|peremption [limite [desc]]");
+    }
+
+    CurseurTri curseur;
+    index_tri_ouvrir(critere, ordre != NULL, &curseur);
+    size_t nb = 0;
+    Produit* p;
+    while ((limite == 0 || nb < (size_t)limite) && (p = index_tri_suivant(&curseur)) != NULL) {
+        ecrire_produit(sortie, p);
+        nb++;
+    }
+    fprintf(sortie, "ok %zu\n", nb);
+    return 0;
+}
+
+static int commande_peremptions(char* arguments, size_t numero, FILE* sortie) {
+    /*
+    Argument:
+        arguments: "DEBUT FIN", dates epoch ou "AAAA-MM-JJ[THH:MM:SS]" (incluses)
+        numero, sortie: Voir erreur
+    But:
+        Lister les produits qui périment dans l'intervalle, de la date la plus
+        proche à la plus lointaine (les produits sans péremption n'y sont jamais)
+    Retour:
+        0 si succès, -1 si les dates sont invalides
+    */
+    char* suite = NULL;
+    char* texte_debut = strtok_r(arguments, " ", &suite);
+    char* texte_fin = strtok_r(NULL, " ", &suite);
+    time_t debut, fin;
+    if (texte_debut == NULL || texte_fin == NULL || strtok_r(NULL, " ", &suite) != NULL
+        || historique_date_depuis_chaine(texte_debut, &debut) != 0
+        || historique_date_depuis_chaine(texte_fin, &fin) != 0 || fin < debut) {
+        return erreur(sortie, numero, "expiring attend DEBUT FIN (epoch ou AAAA-MM-JJ)");
+    }
+
+    CurseurTri curseur;
+    index_tri_placer(TRI_PEREMPTION, (double)debut, &curseur);
+    size_t nb = 0;
+    Produit* p;
+    while ((p = index_tri_suivant(&curseur)) != NULL && p->date_peremption <= fin) {
+        ecrire_produit(sortie, p);
+        nb++;
+    }
+    fprintf(sortie, "ok %zu\n", nb);
+    return 0;
+}
+
+static int executer_commande(const char* ligne, char* arguments, size_t numero, FILE* sortie, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        ligne: Nom de la commande
+        arguments: Reste de la ligne (modifié sur place)
+        numero, sortie, head, max_id: Voir commandes_executer_ligne
+    But:
+        Exécuter une commande, le verrou de l'inventaire étant déjà tenu
+    Retour:
+        0 si succès, -1 en cas d'erreur, 1 pour "quit"
+    */
+    long id;
+    if (strcmp(ligne, "add") == 0) {
+        return commande_ajouter(arguments, numero, sortie, head, max_id);
+    } else if (strcmp(ligne, "mod") == 0) {
+        return commande_modifier(arguments, numero, sortie);
+    } else if (strcmp(ligne, "del") == 0) {
+        if (!lire_entier(arguments, 1, UINT32_MAX, &id)) return erreur(sortie, numero, "ID invalide");
+        if (suppression_par_id(head, (uint32_t)id) != 0) return erreur(sortie, numero, "ID introuvable");
+        fprintf(sortie, "ok %ld\n", id);
+    } else if (strcmp(ligne, "get") == 0) {
+        if (!lire_entier(arguments, 1, UINT32_MAX, &id)) return erreur(sortie, numero, "ID invalide");
+        Produit* p = index_id_chercher((uint32_t)id);
+        if (p == NULL) return erreur(sortie, numero, "ID introuvable");
+        ecrire_produit(sortie, p);
+        fprintf(sortie, "ok 1\n");
+    } else if (strcmp(ligne, "find") == 0) {
+        return commande_rechercher(arguments, numero, sortie);
+    } else if (strcmp(ligne, "cat") == 0) {
+        return commande_categorie(arguments, sortie);
+    } else if (strcmp(ligne, "categories") == 0) {
+        return commande_agregats(sortie);
+    } else if (strcmp(ligne, "list") == 0) {
+        return commande_lister(arguments, numero, sortie, *head);
+    } else if (strcmp(ligne, "top") == 0) {
+        return commande_trier(arguments, numero, sortie);
+    } else if (strcmp(ligne, "expiring") == 0) {
+        return commande_peremptions(arguments, numero, sortie);
+    } else if (strcmp(ligne, "summary") == 0) {
+        time_t limite = time(NULL) + (time_t)HORIZON_PEREMPTION_JOURS * 24 * 3600;
+        fprintf(sortie, "produits %zu valeur %.2f stock_faible %zu peremption %zu\n", colonnes_taille(),
+                colonnes_valeur_stock(), colonnes_compter_stock_faible(SEUIL_STOCK_FAIBLE),
+                colonnes_compter_peremption_avant(limite));
+        fprintf(sortie, "ok 1\n");
+    } else if (strcmp(ligne, "stats") == 0) {
+        if (*arguments != '\0' && strcmp(arguments, "export") != 0) return erreur(sortie, numero, "stats attend [export]");
+        stats_afficher(sortie);
+        if (*arguments != '\0' && stats_exporter(FICHIER_STATISTIQUES) != 0) return erreur(sortie, numero, "export des statistiques impossible");
+        fprintf(sortie, "ok\n");
+    } else if (strcmp(ligne, "purge") == 0) {
+        fprintf(sortie, "ok %zu\n", supprimer_perimes(head, time(NULL), false));
+    } else if (strcmp(ligne, "save") == 0) {
+        if (journal_ops_sauvegarder(*head) != 0) return erreur(sortie, numero, "echec de la sauvegarde");
+        fprintf(sortie, "ok\n");
+    } else if (strcmp(ligne, "load") == 0) {
+        free_struct_produit(*head);
+        *head = NULL;
+        *max_id = 0;
+        journal_ops_charger(head, max_id);
+        fprintf(sortie, "ok %zu\n", colonnes_taille());
+    } else if (strcmp(ligne, "quit") == 0) {
+        fprintf(sortie, "ok\n");
+        return 1;
+    } else {
+        return erreur(sortie, numero, "commande inconnue");
+    }
+    return 0;
+}
+
+static Acces acces_commande(const char* nom) {
+    /*
+    Argument:
+        nom: Nom de la commande
+    But:
+        Savoir quel verrou de l'inventaire la commande demande
+    Retour:
+        ACCES_LECTURE pour les consultations, ACCES_AUCUN pour "quit" et les
+        commandes inconnues, ACCES_ECRITURE pour le reste
+    */
+    static const char* const lectures[] = {"get", "find", "cat", "categories", "list", "top", "expiring", "summary", "stats"};
+    for (size_t i = 0; i < sizeof(lectures) / sizeof(lectures[0]); i++) {
+        if (strcmp(nom, lectures[i]) == 0) return ACCES_LECTURE;
+    }
+    static const char* const ecritures[] = {"add", "mod", "del", "purge", "save", "load"};
+    for (size_t i = 0; i < sizeof(ecritures) / sizeof(ecritures[0]); i++) {
+        if (strcmp(nom, ecritures[i]) == 0) return ACCES_ECRITURE;
+    }
+    return ACCES_AUCUN;
+}
+
+int commandes_executer_ligne(char* ligne, size_t numero, FILE* sortie, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        ligne: Commande sans son '\n' (modifiée sur place)
+        numero: Numéro de la ligne, repris dans les messages d'erreur
+        sortie: Flux des réponses
+        head, max_id: Inventaire et compteur d'ID
+    But:
+        Exécuter une commande et écrire sa réponse, sous le verrou de
+        l'inventaire : les consultations de plusieurs threads avancent
+        ensemble, les modifications passent seules
+    Retour:
+        0 si succès (ou ligne ignorée), -1 en cas d'erreur, 1 pour "quit"
+    */
+    size_t longueur = strlen(ligne);
+    if (longueur > 0 && ligne[longueur - 1] == '\r') ligne[--longueur] = '\0';
+    if (longueur == 0 || ligne[0] == '#') return 0;
+
+    char* arguments = strchr(ligne, ' ');
+    if (arguments != NULL) {
+        *arguments++ = '\0';
+    } else {
+        arguments = ligne + longueur; // chaîne vide
+    }
+
+    Acces acces = acces_commande(ligne);
+    if (acces == ACCES_LECTURE) inventaire_verrouiller_lecture();
+    if (acces == ACCES_ECRITURE) inventaire_verrouiller_ecriture();
+    int res = executer_commande(ligne, arguments, numero, sortie, head, max_id);
+    if (acces != ACCES_AUCUN) inventaire_deverrouiller();
+    return res;
+}
+
+int commandes_executer(FILE* entree, FILE* sortie, Produit** head, uint32_t* max_id, BilanCommandes* bilan) {
+    /*
+    Argument:
+        entree: Script de commandes (fichier ou stdin)
+        sortie: Flux des réponses
+        head, max_id: Inventaire et compteur d'ID
+        bilan: Compteurs de l'exécution (peut être NULL)
+    But:
+        Lire et exécuter les commandes par lots de COMMANDES_PAR_LOT : retrait
+        des périmés une fois par lot, sortie vidée en fin de lot (l'appelant
+        donne à la sortie un grand tampon avec setvbuf avant toute écriture)
+    Retour:
+        0 si toutes les commandes ont réussi, -1 sinon
+    */
+    BilanCommandes local = {0, 0, 0};
+    char* ligne = NULL;
+    size_t capacite = 0;
+    size_t numero = 0;
+    bool fin = false;
+
+    while (!fin) {
+        inventaire_verrouiller_ecriture();
+        local.nb_perimes += supprimer_perimes(head, time(NULL), false);
+        inventaire_deverrouiller();
+
+        for (size_t i = 0; i < COMMANDES_PAR_LOT; i++) {
+            if (getline(&ligne, &capacite, entree) < 0) {
+                fin = true;
+                break;
+            }
+            numero++;
+            char* saut = strchr(ligne, '\n');
+            if (saut != NULL) *saut = '\0';
+
+            bool ignoree = (ligne[0] == '\0' || ligne[0] == '#');
+            int res = commandes_executer_ligne(ligne, numero, sortie, head, max_id);
+            if (!ignoree) local.nb_commandes++;
+            if (res < 0) local.nb_erreurs++;
+            if (res > 0) {
+                fin = true;
+                break;
+            }
+        }
+        fflush(sortie);
+    }
+    free(ligne);
+
+    if (bilan != NULL) *bilan = local;
+    return (local.nb_erreurs == 0) ? 0 : -1;
+}
@@ -0,0 +1,37 @@
+#ifndef _COMMANDES_H
+#define _COMMANDES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Mode commandes (./bgrs --commandes [fichier]) : une commande par ligne,
+    sans menu ni invite, pour les scripts et les imports en volume.
+    - Les champs d'un produit sont séparés par '|' comme dans la sauvegarde :
+        add nom|description|categorie|quantite|prix|date|note
+        mod ID nom|description|categorie|quantite|prix|date|note  (champ vide = inchangé)
+        del ID, get ID, find TEXTE, cat CATEGORIE, categories, list [DEBUT [LIMITE]],
+        top prix|quantite|peremption [LIMITE [desc]], expiring DEBUT FIN, summary,
+        stats [export], purge, save, load, quit
+    - Chaque commande répond par ses lignes de données puis "ok ..." ou
+      "erreur LIGNE : message". Les lignes vides et celles en '#' sont ignorées.
+    - Les commandes sont traitées par lots de COMMANDES_PAR_LOT : la date de
+      référence des péremptions n'est relevée et les périmés retirés qu'une fois
+      par lot, et la sortie n'est vidée qu'en fin de lot.
+*/
+
+#define COMMANDES_PAR_LOT 4096
+
+typedef struct {
+    size_t nb_commandes;
+    size_t nb_erreurs;
+    size_t nb_perimes;
+} BilanCommandes;
+
+int commandes_executer_ligne(char* ligne, size_t numero, FILE* sortie, Produit** head, uint32_t* max_id);
+int commandes_executer(FILE* entree, FILE* sortie, Produit** head, uint32_t* max_id, BilanCommandes* bilan);
+
+#endif
@@ -0,0 +1,228 @@
+/*
+Nom du fichier : echeancier.c
+Fait par : Erwann GIRAULT
+But : Tas minimum des dates de péremption, pour savoir en O(1) si un produit
+      est périmé et retirer les k produits concernés en O(k log n)
+*/
+
+
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "echeancier.h"
+
+#define CAPACITE_INITIALE 64
+
+typedef struct {
+    time_t date;       // copie de la clé pour les comparaisons
+    Produit* produit;
+} Echeance;
+
+static Echeance* tas = NULL;
+static size_t capacite = 0;
+static size_t nb_elements = 0;
+
+static void placer(size_t pos, Echeance e) {
+    /*
+    Argument:
+        pos: Indice de la case dans le tas
+        e: Échéance à y ranger
+    But:
+        Écrire l'échéance et mettre à jour le rang mémorisé dans le produit
+    Retour:
+        Aucun
+    */
+    tas[pos] = e;
+    e.produit->rang_peremption = pos + 1; // 0 est réservé à "absent du tas"
+}
+
+static void remonter(size_t pos) {
+    /*
+    Argument:
+        pos: Indice de l'élément à faire remonter
+    But:
+        Rétablir l'ordre du tas quand une clé a diminué
+    Retour:
+        Aucun
+    */
+    Echeance e = tas[pos];
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (tas[parent].date <= e.date) break;
+        placer(pos, tas[parent]);
+        pos = parent;
+    }
+    placer(pos, e);
+}
+
+static void descendre(size_t pos) {
+    /*
+    Argument:
+        pos: Indice de l'élément à faire descendre
+    But:
+        Rétablir l'ordre du tas quand une clé a augmenté
+    Retour:
+        Aucun
+    */
+    Echeance e = tas[pos];
+    while (1) {
+        size_t enfant = 2 * pos + 1;
+        if (enfant >= nb_elements) break;
+        if (enfant + 1 < nb_elements && tas[enfant + 1].date < tas[enfant].date) {
+            enfant++;
+        }
+        if (e.date <= tas[enfant].date) break;
+        placer(pos, tas[enfant]);
+        pos = enfant;
+    }
+    placer(pos, e);
+}
+
+int echeancier_planifier(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit dont la date de péremption vient d'être fixée ou modifiée
+    But:
+        Ajouter le produit au tas, le repositionner s'il y est déjà,
+        ou l'en retirer si sa date vaut 0 (pas de péremption)
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (produit == NULL) return -1;
+
+    if (produit->date_peremption == 0) {
+        echeancier_retirer(produit);
+        return 0;
+    }
+
+    if (produit->rang_peremption != 0) {
+        size_t pos = produit->rang_peremption - 1;
+        time_t ancienne = tas[pos].date;
+        tas[pos].date = produit->date_peremption;
+        if (produit->date_peremption < ancienne) {
+            remonter(pos);
+        } else {
+            descendre(pos);
+        }
+        return 0;
+    }
+
+    if (nb_elements == capacite) {
+        size_t nouvelle_capacite = (capacite == 0) ? CAPACITE_INITIALE : capacite * 2;
+        Echeance* nouveau = (Echeance*)realloc(tas, nouvelle_capacite * sizeof(Echeance));
+        if (nouveau == NULL) return -1;
+        tas = nouveau;
+        capacite = nouvelle_capacite;
+    }
+
+    Echeance e = { produit->date_peremption, produit };
+    placer(nb_elements, e);
+    nb_elements++;
+    remonter(nb_elements - 1);
+    return 0;
+}
+
+int echeancier_planifier_lot(Produit* premier) {
+    /*
+    Argument:
+        premier: Début d'une chaîne de produits absents du tas (chargement en masse)
+    But:
+        Ajouter tous les produits datés de la chaîne en une fois, puis reconstruire
+        le tas par le bas (O(n) au lieu de n insertions en O(log n))
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (le tas reste inchangé)
+    */
+    size_t nb_dates = 0;
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+        if (actu->date_peremption != 0) nb_dates++;
+    }
+    if (nb_dates == 0) return 0;
+
+    if (nb_elements + nb_dates > capacite) {
+        size_t nouvelle_capacite = (capacite == 0) ? CAPACITE_INITIALE : capacite;
+        while (nouvelle_capacite < nb_elements + nb_dates) nouvelle_capacite *= 2;
+        Echeance* nouveau = (Echeance*)realloc(tas, nouvelle_capacite * sizeof(Echeance));
+        if (nouveau == NULL) return -1;
+        tas = nouveau;
+        capacite = nouvelle_capacite;
+    }
+
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+        if (actu->date_peremption == 0) continue;
+        Echeance e = { actu->date_peremption, actu };
+        placer(nb_elements, e);
+        nb_elements++;
+    }
+
+    // Reconstruction de Floyd : on fait descendre chaque noeud interne
+    for (size_t pos = nb_elements / 2; pos > 0; pos--) {
+        descendre(pos - 1);
+    }
+    return 0;
+}
+
+void echeancier_retirer(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit à retirer du tas (sans effet s'il n'y figure pas)
+    But:
+        Remplacer l'élément par le dernier du tas puis rétablir l'ordre
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->rang_peremption == 0) return;
+
+    size_t pos = produit->rang_peremption - 1;
+    produit->rang_peremption = 0;
+    nb_elements--;
+
+    if (pos == nb_elements) return; // c'était le dernier
+
+    time_t ancienne = tas[pos].date;
+    placer(pos, tas[nb_elements]);
+    if (tas[pos].date < ancienne) {
+        remonter(pos);
+    } else {
+        descendre(pos);
+    }
+}
+
+Produit* echeancier_prochain(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Consulter le produit dont la péremption est la plus proche
+    Retour:
+        Pointeur vers ce produit, ou NULL si aucun produit n'a de date
+    */
+    return (nb_elements > 0) ? tas[0].produit : NULL;
+}
+
+size_t echeancier_taille(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Connaître le nombre de produits ayant une date de péremption
+    Retour:
+        Nombre d'éléments dans le tas
+    */
+    return nb_elements;
+}
+
+void echeancier_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer le tas (appelé quand toute la liste est libérée)
+    Retour:
+        Aucun
+    */
+    free(tas);
+    tas = NULL;
+    capacite = 0;
+    nb_elements = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef _ECHEANCIER_H
+#define _ECHEANCIER_H
+
+#include <time.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Échéancier des péremptions : tas binaire minimum sur date_peremption.
+    - Seuls les produits avec une date (différente de 0) y figurent.
+    - Chaque produit garde sa position dans le tas (rang_peremption) pour
+      pouvoir être retiré ou replanifié en O(log n).
+    - Consulter la prochaine échéance coûte O(1).
+*/
+
+int echeancier_planifier(Produit* produit);
+int echeancier_planifier_lot(Produit* premier);
+void echeancier_retirer(Produit* produit);
+Produit* echeancier_prochain(void);
+size_t echeancier_taille(void);
+void echeancier_liberer(void);
+
+#endif
@@ -0,0 +1,79 @@
+/*
+Nom du fichier : formatage.c
+Fait par : Erwann GIRAULT
+But : Conversions rapides des entiers et des prix en texte, pour la
+      sauvegarde et le rendu de l'inventaire
+*/
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "formatage.h"
+
+#define LIMITE_CENTIMES 1e15 // au-delà, snprintf : entier / 100 reste loin de la limite d'un uint64_t
+
+char* formatage_entier(char* p, uint64_t valeur, int chiffres_min) {
+    /*
+    Argument:
+        p: Position d'écriture
+        valeur: Nombre à écrire en décimal
+        chiffres_min: Complété par des zéros à gauche jusqu'à ce nombre de chiffres
+    But:
+        Écrire un entier en décimal, comme "%llu" (ou "%0*llu")
+    Retour:
+        Position après le dernier chiffre
+    */
+    char chiffres[20];
+    int n = 0;
+    do {
+        chiffres[n++] = (char)('0' + valeur % 10);
+        valeur /= 10;
+    } while (valeur != 0);
+    while (n < chiffres_min) chiffres[n++] = '0';
+    while (n > 0) *p++ = chiffres[--n];
+    return p;
+}
+
+char* formatage_signe(char* p, int64_t valeur) {
+    /*
+    Argument:
+        p: Position d'écriture
+        valeur: Entier signé
+    But:
+        Écrire un entier signé en décimal, comme "%ld"
+    Retour:
+        Position suivante
+    */
+    if (valeur < 0) {
+        *p++ = '-';
+        return formatage_entier(p, (uint64_t)0 - (uint64_t)valeur, 1);
+    }
+    return formatage_entier(p, (uint64_t)valeur, 1);
+}
+
+char* formatage_prix(char* p, float prix) {
+    /*
+    Argument:
+        p: Position d'écriture (au moins TAILLE_PRIX_FORMATE octets disponibles)
+        prix: Prix à écrire
+    But:
+        Écrire le prix comme "%.2f". Un float a 24 bits de mantisse : prix * 100
+        est exact en double, il suffit d'arrondir au plus proche (égalité vers le
+        pair, comme printf). Les valeurs hors de ce cas passent par snprintf
+    Retour:
+        Position suivante
+    */
+    double centimes = (double)prix * 100.0;
+    if (!(centimes >= 0.0 && centimes < LIMITE_CENTIMES)) {
+        return p + snprintf(p, TAILLE_PRIX_FORMATE, "%.2f", prix); // négatif, énorme ou NaN
+    }
+    uint64_t entier = (uint64_t)centimes;
+    double reste = centimes - (double)entier;
+    if (reste > 0.5 || (reste == 0.5 && (entier & 1) != 0)) entier++;
+
+    p = formatage_entier(p, entier / 100, 1);
+    *p++ = '.';
+    return formatage_entier(p, entier % 100, 2);
+}
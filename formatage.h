@@ -0,0 +1,21 @@
+#ifndef _FORMATAGE_H
+#define _FORMATAGE_H
+
+#include <stdint.h>
+
+/*
+    Écriture des nombres en décimal sans printf, partagée par la sauvegarde
+    texte (gestion_db.c) et le rendu de l'inventaire (rendu.c) :
+    - Chaque fonction écrit à la position donnée et renvoie la position
+      suivante, sans '\0'.
+    - formatage_prix donne le même texte que "%.2f" ; les prix négatifs,
+      énormes ou NaN passent par snprintf (au plus TAILLE_PRIX_FORMATE octets).
+*/
+
+#define TAILLE_PRIX_FORMATE 64
+
+char* formatage_entier(char* p, uint64_t valeur, int chiffres_min);
+char* formatage_signe(char* p, int64_t valeur);
+char* formatage_prix(char* p, float prix);
+
+#endif
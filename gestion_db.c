@@ -11,141 +11,1055 @@ But : Gère la persistance des données. Contient les fonctions pour sauvegarder
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
 
 
 #include "gestion_produit.h"
 #include "gestion_db.h"
+#include "analyseur.h"
+#include "formatage.h"
+#include "index_id.h"
+#include "memoire.h"
+#include "stats.h"
 
-#define DELIMITER "|"
-#define MAX_LINE_LENGTH 2048 // taille nécessaire pour contenir une ligne complète 
+#define DELIMITEUR '|'
+#define NB_CHAMPS 8
+#define TAILLE_LIGNE_INITIALE 2048 // agrandie si besoin, plus de limite de longueur de ligne
+#define MAX_THREADS_CHARGEMENT 256
+#define TAILLE_MIN_TRANCHE (1024 * 1024) // en dessous, un thread de plus coûte plus qu'il ne rapporte
+#define TAILLE_TAMPON_SAUVEGARDE (4 * 1024 * 1024) // un write par tranche de 4 Mo
+#define SUFFIXE_TEMPORAIRE ".XXXXXX" // modèle de mkstemp
+#define MARGE_LIGNE 128 // nombres et séparateurs d'une ligne de sauvegarde
 
-char *separateur_chaine(char** str, const char* delim) {
+typedef struct {
+    char* donnees;
+    size_t taille;
+    bool projete; // true : mmap, false : copie en mémoire (fichier non projetable)
+} ContenuFichier;
+
+typedef enum {
+    LIGNE_PRODUIT,
+    LIGNE_CORROMPUE,
+    LIGNE_ECHEC_CREATION
+} TypeLigne;
+
+typedef struct {
+    TypeLigne type;
+    int ligne;         // numéro de ligne relatif au début de la tranche
+    Produit* produit;  // NULL sauf pour LIGNE_PRODUIT
+} EvenementLigne;
+
+typedef struct {
+    const char* debut;
+    const char* fin;
+    int nb_lignes;
+    EvenementLigne* evenements;
+    size_t nb_evenements;
+    size_t capacite;
+    bool evenements_perdus;
+} TrancheChargement;
+
+typedef struct {
+    int fd;
+    char* donnees;
+    size_t utilise;
+    size_t capacite;
+    size_t total;           // octets déjà envoyés au fichier
+    bool erreur;
+    char* chemin_temporaire;
+    struct timespec debut;
+} TamponSauvegarde;
+
+static unsigned int nb_threads_chargement = 0; // 0 = un thread par coeur
+static bool synchroniser_sauvegarde = true;
+static bool sauvegarde_en_binaire = false;
+
+/*
+    Instantané binaire (ordre des octets de la machine, vérifié à la lecture) :
+    - EnteteInstantane (64 octets)
+    - nb_produits x EnregistrementInstantane (72 octets, valeurs numériques exactes)
+    - Tas des chaînes : nom, description, catégorie, note, chacune suivie de '\0'
+    La somme de contrôle couvre les enregistrements et le tas.
+*/
+#define MAGIE_INSTANTANE "BGRSINST"
+#define VERSION_INSTANTANE 1
+#define MARQUEUR_BOUTISME 0x01020304u
+
+typedef struct {
+    char magie[8];
+    uint32_t version;
+    uint32_t boutisme;
+    uint64_t nb_produits;
+    uint64_t taille_tas;
+    uint64_t somme_controle;
+    uint32_t taille_enregistrement;
+    uint32_t reserve[5];
+} EnteteInstantane;
+
+typedef struct {
+    uint32_t id;
+    int32_t quantite;
+    float prix_unitaire;
+    uint32_t reserve;
+    int64_t date_peremption;
+    uint64_t positions[4];   // nom, description, catégorie, note (décalage dans le tas)
+    uint32_t longueurs[4];   // sans le '\0'
+} EnregistrementInstantane;
+
+typedef struct {
+    uint64_t valeur;
+    unsigned char en_attente[8];
+    size_t nb_en_attente;
+} SommeControle;
+
+_Static_assert(sizeof(EnteteInstantane) == 64, "en-tete d'instantane : 64 octets");
+_Static_assert(sizeof(EnregistrementInstantane) == 72, "enregistrement d'instantane : 72 octets");
+
+static int ouvrir_contenu(const char* nom_fichier, ContenuFichier* contenu) {
     /*
     Argument:
-        str: pointeur d'un pointeur vers le debut d'une chaine
-        delim: pointeur vers le délimiteur
+        nom_fichier: Chemin du fichier à lire
+        contenu: Zone mémoire correspondant au fichier
     But:
-        à partir d'une chaine, on remplace les délimiteur par des \0 pour separer les élément entre eux
+        Projeter le fichier en mémoire (mmap) pour le parcourir sans copie
+        Si la projection échoue, le fichier est lu entièrement dans un tampon
     Retour:
-        Aucun
+        0 si succès, -1 si le fichier ne peut pas être ouvert ou lu
     */
-    char *start = *str;
-    char *p;
+    contenu->donnees = NULL;
+    contenu->taille = 0;
+    contenu->projete = false;
+
+    int fd = open(nom_fichier, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
 
-    if (start == NULL) {
-        return NULL;
+    struct stat infos;
+    if (fstat(fd, &infos) != 0) {
+        close(fd);
+        return -1;
     }
-    p = strpbrk(start, delim);
 
-    if (p == NULL) {
-        // cas du dernier token
-        *str = NULL; 
+    if (S_ISREG(infos.st_mode) && infos.st_size > 0) {
+        void* zone = mmap(NULL, (size_t)infos.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (zone != MAP_FAILED) {
+            posix_madvise(zone, (size_t)infos.st_size, POSIX_MADV_SEQUENTIAL);
+            contenu->donnees = (char*)zone;
+            contenu->taille = (size_t)infos.st_size;
+            contenu->projete = true;
+            close(fd);
+            STATS_OCTETS_LUS(contenu->taille); // pages lues au fil de l'analyse
+            return 0;
+        }
+    }
+
+    // Repli : lecture complète (fichier spécial ou mmap indisponible)
+    size_t capacite = 0;
+    while (1) {
+        if (contenu->taille == capacite) {
+            size_t nouvelle_capacite = (capacite == 0) ? 65536 : capacite * 2;
+            char* nouveau = (char*)realloc(contenu->donnees, nouvelle_capacite);
+            if (nouveau == NULL) {
+                free(contenu->donnees);
+                contenu->donnees = NULL;
+                close(fd);
+                return -1;
+            }
+            contenu->donnees = nouveau;
+            capacite = nouvelle_capacite;
+        }
+        ssize_t n = read(fd, contenu->donnees + contenu->taille, capacite - contenu->taille);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            free(contenu->donnees);
+            contenu->donnees = NULL;
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break;
+        contenu->taille += (size_t)n;
+    }
+    close(fd);
+    STATS_OCTETS_LUS(contenu->taille);
+    return 0;
+}
+
+static void fermer_contenu(ContenuFichier* contenu) {
+    /*
+    Argument:
+        contenu: Zone ouverte par ouvrir_contenu
+    But:
+        Libérer la projection ou le tampon
+    Retour:
+        Aucun
+    */
+    if (contenu->projete) {
+        munmap(contenu->donnees, contenu->taille);
     } else {
-        // Délimiteur trouvé => on le remplace par \0 pour le "couper"
+        free(contenu->donnees);
+    }
+    contenu->donnees = NULL;
+    contenu->taille = 0;
+}
+
+static int decouper_champs(char* ligne, size_t taille, char* champs[NB_CHAMPS]) {
+    /*
+    Argument:
+        ligne: Ligne terminée par '\0' (modifiée : les délimiteurs deviennent des '\0')
+        taille: Longueur de la ligne
+        champs: Tableau recevant le début de chaque champ
+    But:
+        Découper la ligne sur '|' avec la recherche vectorisée
+        Le dernier champ s'arrête au délimiteur suivant s'il y en a un (champs en trop ignorés)
+    Retour:
+        Nombre de champs trouvés (NB_CHAMPS si la ligne est complète)
+    */
+    char* p = ligne;
+    char* fin = ligne + taille;
+    int n = 0;
+
+    while (n < NB_CHAMPS) {
+        champs[n++] = p;
+        const char* delimiteur = chercher_octet(p, fin, DELIMITEUR);
+        if (delimiteur == NULL) break; // cas du dernier champ
+        p += delimiteur - p;
         *p = '\0';
-        *str = p + 1;
+        p++;
     }
+    return n;
+}
+
+static TypeLigne analyser_ligne(char* ligne, size_t taille, Produit** produit) {
+    /*
+    Argument:
+        ligne: Ligne terminée par '\0', sans le '\n'
+        taille: Longueur de la ligne
+        produit: Reçoit le produit créé (si la ligne est valide)
+    But:
+        Découper la ligne et convertir les champs, sans rien afficher
+        (appelé depuis les threads de chargement)
+    Retour:
+        Nature de la ligne : produit, ligne corrompue ou échec de création
+    */
+    char* champs[NB_CHAMPS];
+    *produit = NULL;
 
-    return start;
+    // Un '\0' dans la ligne la termine, comme avec les fonctions de chaîne
+    taille = strnlen(ligne, taille);
+
+    // Si un des champs obligatoires manque, la ligne est corrompue donc abandonnée
+    if (decouper_champs(ligne, taille, champs) < NB_CHAMPS) {
+        return LIGNE_CORROMPUE;
+    }
+
+    uint32_t id = analyser_u32(champs[0]);
+    int quantite = analyser_int(champs[4]);
+    float prix = analyser_float(champs[5]);
+    time_t date_peremption = (time_t)analyser_long(champs[6]);
+
+    *produit = creer_produit(id, champs[1], champs[2], champs[3], quantite, prix, date_peremption, champs[7]);
+    return (*produit != NULL) ? LIGNE_PRODUIT : LIGNE_ECHEC_CREATION;
 }
 
-void sauvegarde(Produit* head, const char* nom_fichier) {
+static int noter_evenement(TrancheChargement* tranche, TypeLigne type, int ligne, Produit* produit) {
+    /*
+    Argument:
+        tranche: Tranche en cours d'analyse
+        type: Nature de la ligne
+        ligne: Numéro de la ligne dans la tranche
+        produit: Produit créé (NULL pour un avertissement)
+    But:
+        Mémoriser le résultat d'une ligne pour le restituer dans l'ordre du fichier
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (tranche->nb_evenements == tranche->capacite) {
+        size_t nouvelle_capacite = (tranche->capacite == 0) ? 1024 : tranche->capacite * 2;
+        EvenementLigne* nouveau = (EvenementLigne*)realloc(tranche->evenements, nouvelle_capacite * sizeof(EvenementLigne));
+        if (nouveau == NULL) return -1;
+        tranche->evenements = nouveau;
+        tranche->capacite = nouvelle_capacite;
+    }
+    EvenementLigne* e = &tranche->evenements[tranche->nb_evenements++];
+    e->type = type;
+    e->ligne = ligne;
+    e->produit = produit;
+    return 0;
+}
+
+static void* analyser_tranche(void* arg) {
+    /*
+    Argument:
+        arg: TrancheChargement à traiter (commence en début de ligne)
+    But:
+        Analyser toutes les lignes de la tranche et créer les produits
+        Rien n'est affiché ni inséré ici : les résultats sont notés dans la tranche
+    Retour:
+        NULL
+    */
+    TrancheChargement* tranche = (TrancheChargement*)arg;
+    size_t capacite_ligne = TAILLE_LIGNE_INITIALE;
+    char* ligne = (char*)malloc(capacite_ligne);
+
+    const char* actu = tranche->debut;
+    while (actu < tranche->fin) {
+        tranche->nb_lignes++;
+
+        const char* fin_ligne = chercher_octet(actu, tranche->fin, '\n');
+        if (fin_ligne == NULL) fin_ligne = tranche->fin; // dernière ligne sans '\n'
+        size_t taille = (size_t)(fin_ligne - actu);
+
+        // Copie dans un tampon modifiable (la projection est en lecture seule)
+        if (ligne != NULL && taille + 1 > capacite_ligne) {
+            while (taille + 1 > capacite_ligne) capacite_ligne *= 2;
+            char* nouvelle = (char*)realloc(ligne, capacite_ligne);
+            if (nouvelle == NULL) {
+                free(ligne);
+            }
+            ligne = nouvelle;
+        }
+
+        Produit* produit = NULL;
+        TypeLigne type = LIGNE_ECHEC_CREATION;
+        if (ligne != NULL) {
+            memcpy(ligne, actu, taille);
+            ligne[taille] = '\0';
+            type = analyser_ligne(ligne, taille, &produit);
+        } else {
+            capacite_ligne = TAILLE_LIGNE_INITIALE;
+            ligne = (char*)malloc(capacite_ligne); // nouvel essai à la ligne suivante
+        }
+
+        if (noter_evenement(tranche, type, tranche->nb_lignes, produit) != 0) {
+            liberer_produit(produit);
+            tranche->evenements_perdus = true;
+        }
+        actu = fin_ligne + 1;
+    }
+
+    free(ligne);
+    return NULL;
+}
+
+static unsigned int choisir_nb_threads(size_t taille_fichier) {
+    /*
+    Argument:
+        taille_fichier: Taille du fichier à charger
+    But:
+        Un thread par coeur (ou le nombre configuré), sans descendre sous
+        TAILLE_MIN_TRANCHE octets par thread : les petits fichiers restent séquentiels
+    Retour:
+        Nombre de threads à utiliser (au moins 1)
+    */
+    unsigned int nb = nb_threads_chargement;
+    if (nb == 0) {
+        long coeurs = sysconf(_SC_NPROCESSORS_ONLN);
+        nb = (coeurs > 0) ? (unsigned int)coeurs : 1;
+    }
+    if (nb > MAX_THREADS_CHARGEMENT) nb = MAX_THREADS_CHARGEMENT;
+
+    size_t max_utile = taille_fichier / TAILLE_MIN_TRANCHE;
+    if (max_utile < nb) nb = (unsigned int)max_utile;
+    return (nb == 0) ? 1 : nb;
+}
+
+void charger_fichier_configurer_threads(unsigned int nb_threads) {
+    /*
+    Argument:
+        nb_threads: Nombre de threads de chargement (0 = un par coeur)
+    But:
+        Régler le parallélisme de charger_fichier
+    Retour:
+        Aucun
+    */
+    nb_threads_chargement = nb_threads;
+}
+
+static const char* champ_ou_defaut(const char* champ, const char* defaut) {
+    /*
+    Argument:
+        champ: Chaîne du produit (peut être NULL)
+        defaut: Valeur de remplacement
+    But:
+        Valeur écrite pour un champ absent (sauvegardes texte et binaire)
+    Retour:
+        La chaîne à écrire
+    */
+    return (champ != NULL) ? champ : defaut;
+}
+
+void sauvegarde_configurer_fsync(bool synchroniser) {
+    /*
+    Argument:
+        synchroniser: false pour ne pas attendre l'écriture physique (plus rapide,
+                      mais une coupure de courant peut perdre la dernière sauvegarde)
+    But:
+        Régler la synchronisation disque des sauvegardes complètes
+    Retour:
+        Aucun
+    */
+    synchroniser_sauvegarde = synchroniser;
+}
+
+static int tampon_ouvrir(TamponSauvegarde* tampon, const char* nom_fichier) {
+    /*
+    Argument:
+        tampon: Tampon à préparer
+        nom_fichier: Fichier de destination (on écrit dans "<nom_fichier>.XXXXXX")
+    But:
+        Créer un fichier temporaire au nom unique (mkstemp) dans le dossier de
+        la destination, pour que le renommage reste atomique et que deux
+        sauvegardes simultanées n'écrivent pas dans le même fichier, puis
+        allouer le tampon d'écriture ; la destination n'est pas touchée avant
+        tampon_publier
+    Retour:
+        0 si succès, -1 sinon
+    */
+    memset(tampon, 0, sizeof(TamponSauvegarde));
+    tampon->fd = -1;
+    clock_gettime(CLOCK_MONOTONIC, &tampon->debut);
+
+    size_t longueur = strlen(nom_fichier);
+    tampon->chemin_temporaire = (char*)malloc(longueur + sizeof(SUFFIXE_TEMPORAIRE));
+    tampon->donnees = (char*)malloc(TAILLE_TAMPON_SAUVEGARDE);
+    if (tampon->chemin_temporaire == NULL || tampon->donnees == NULL) {
+        free(tampon->chemin_temporaire);
+        free(tampon->donnees);
+        fprintf(stderr, "[!] Erreur : Echec allocation mémoire pour la sauvegarde.\n");
+        return -1;
+    }
+    memcpy(tampon->chemin_temporaire, nom_fichier, longueur);
+    memcpy(tampon->chemin_temporaire + longueur, SUFFIXE_TEMPORAIRE, sizeof(SUFFIXE_TEMPORAIRE));
+    tampon->capacite = TAILLE_TAMPON_SAUVEGARDE;
+
+    tampon->fd = mkstemp(tampon->chemin_temporaire);
+    if (tampon->fd >= 0) fcntl(tampon->fd, F_SETFD, FD_CLOEXEC);
+    if (tampon->fd < 0) {
+        fprintf(stderr, "[!] Erreur : Impossible d'ouvrir %s pour écriture.\n", tampon->chemin_temporaire);
+        free(tampon->chemin_temporaire);
+        free(tampon->donnees);
+        return -1;
+    }
+    return 0;
+}
+
+static void tampon_vider(TamponSauvegarde* tampon) {
+    /*
+    Argument:
+        tampon: Tampon en cours
+    But:
+        Envoyer le contenu du tampon au fichier temporaire (un write dans le cas normal)
+    Retour:
+        Aucun (tampon->erreur est positionné en cas d'échec)
+    */
+    const char* p = tampon->donnees;
+    size_t reste = tampon->utilise;
+    while (reste > 0 && !tampon->erreur) {
+        ssize_t n = write(tampon->fd, p, reste);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            tampon->erreur = true;
+            break;
+        }
+        STATS_OCTETS_ECRITS((size_t)n);
+        p += n;
+        reste -= (size_t)n;
+    }
+    tampon->total += tampon->utilise;
+    tampon->utilise = 0;
+}
+
+static char* tampon_reserver(TamponSauvegarde* tampon, size_t taille) {
+    /*
+    Argument:
+        tampon: Tampon en cours
+        taille: Nombre d'octets que l'appelant va écrire au maximum
+    But:
+        Garantir la place disponible (vidage, ou agrandissement pour une ligne
+        plus grande que le tampon)
+    Retour:
+        Position d'écriture, ou NULL en cas d'erreur
+    */
+    if (tampon->capacite - tampon->utilise < taille) {
+        tampon_vider(tampon);
+        if (tampon->capacite < taille) {
+            char* plus_grand = (char*)realloc(tampon->donnees, taille);
+            if (plus_grand == NULL) {
+                tampon->erreur = true;
+                return NULL;
+            }
+            tampon->donnees = plus_grand;
+            tampon->capacite = taille;
+        }
+    }
+    return tampon->erreur ? NULL : tampon->donnees + tampon->utilise;
+}
+
+static void tampon_ajouter(TamponSauvegarde* tampon, const void* donnees, size_t taille) {
+    /*
+    Argument:
+        tampon: Tampon en cours
+        donnees, taille: Octets à ajouter
+    But:
+        Copier un bloc dans le tampon
+    Retour:
+        Aucun
+    */
+    char* p = tampon_reserver(tampon, taille);
+    if (p == NULL) return;
+    memcpy(p, donnees, taille);
+    tampon->utilise += taille;
+}
+
+static void synchroniser_dossier(const char* nom_fichier) {
+    /*
+    Argument:
+        nom_fichier: Fichier qui vient d'être renommé
+    But:
+        Synchroniser le dossier parent, pour que le renommage lui-même survive
+        à une coupure de courant
+    Retour:
+        Aucun
+    */
+    const char* barre = strrchr(nom_fichier, '/');
+    char dossier[4096] = ".";
+    if (barre != NULL) {
+        size_t longueur = (size_t)(barre - nom_fichier);
+        if (longueur == 0) longueur = 1; // racine
+        if (longueur >= sizeof(dossier)) return;
+        memcpy(dossier, nom_fichier, longueur);
+        dossier[longueur] = '\0';
+    }
+    int fd = open(dossier, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+static int tampon_publier(TamponSauvegarde* tampon, const char* nom_fichier) {
+    /*
+    Argument:
+        tampon: Tampon rempli
+        nom_fichier: Fichier de destination
+    But:
+        Vider le tampon, synchroniser le fichier temporaire (si activé), puis le
+        renommer sur la destination : celle-ci contient toujours soit l'ancienne,
+        soit la nouvelle sauvegarde complète. Affiche le débit obtenu
+    Retour:
+        0 si succès, -1 sinon (le fichier temporaire est supprimé)
+    */
+    tampon_vider(tampon);
+
+    // mkstemp crée le fichier en 0600 : la sauvegarde garde les droits de
+    // celle qu'elle remplace, ou 0644 pour une première sauvegarde
+    struct stat cible;
+    mode_t mode = (stat(nom_fichier, &cible) == 0) ? (cible.st_mode & 07777) : 0644;
+    if (!tampon->erreur && fchmod(tampon->fd, mode) != 0) tampon->erreur = true;
+
+    if (!tampon->erreur && synchroniser_sauvegarde && fsync(tampon->fd) != 0) tampon->erreur = true;
+    if (close(tampon->fd) != 0) tampon->erreur = true;
+    if (!tampon->erreur && rename(tampon->chemin_temporaire, nom_fichier) != 0) tampon->erreur = true;
+
+    int res = 0;
+    if (tampon->erreur) {
+        fprintf(stderr, "[!] Erreur : Ecriture de %s incomplete, ancienne sauvegarde conservée.\n", nom_fichier);
+        unlink(tampon->chemin_temporaire);
+        res = -1;
+    } else {
+        if (synchroniser_sauvegarde) synchroniser_dossier(nom_fichier);
+
+        struct timespec fin;
+        clock_gettime(CLOCK_MONOTONIC, &fin);
+        double secondes = (double)(fin.tv_sec - tampon->debut.tv_sec) + (double)(fin.tv_nsec - tampon->debut.tv_nsec) / 1e9;
+        double mo = (double)tampon->total / (1024.0 * 1024.0);
+        printf("[i] %.2f Mo ecrits en %.3f s (%.1f Mo/s%s)\n", mo, secondes,
+               (secondes > 0) ? mo / secondes : 0.0, synchroniser_sauvegarde ? ", fsync" : "");
+    }
+    free(tampon->chemin_temporaire);
+    free(tampon->donnees);
+    return res;
+}
+
+void sauvegarde_configurer_format(bool binaire) {
+    /*
+    Argument:
+        binaire: true pour écrire les sauvegardes complètes en instantané binaire
+    But:
+        Choisir le format des sauvegardes complètes (le chargement reconnaît
+        les deux formats tout seul)
+    Retour:
+        Aucun
+    */
+    sauvegarde_en_binaire = binaire;
+}
+
+int sauvegarde(Produit* head, const char* nom_fichier) {
     /*
     Argument:
         head: Pointeur vers la tête de la liste à sauvegarder
         nom_fichier: Chemin du fichier de destination
     But:
-        Sérialiser l'inventaire dans un fichier texte 
+        Sérialiser l'inventaire dans un fichier texte. Les lignes sont formatées
+        dans un grand tampon envoyé par quelques gros write vers un fichier
+        temporaire, qui remplace la destination par rename : une interruption
+        ne laisse jamais de sauvegarde tronquée. Écrit un instantané binaire
+        à la place si sauvegarde_configurer_format l'a demandé
     Retour:
-        Aucun 
+        0 si succès, -1 si le fichier n'a pas pu être écrit
     */
-    FILE* fichier = fopen(nom_fichier, "w"); 
-    if (fichier == NULL) {
-        fprintf(stderr, "[!] Erreur : Impossible d'ouvrir %s pour écriture.\n", nom_fichier);
-        return;
+    if (sauvegarde_en_binaire) {
+        return sauvegarde_binaire(head, nom_fichier);
     }
 
-    Produit* actu = head;
-    while (actu != NULL) {
-        fprintf(fichier, "%u|%s|%s|%s|%d|%.2f|%ld|%s\n", 
-                actu->id, 
-                (actu->nom ? actu->nom : "Inconnu"), 
-                (actu->description ? actu->description : ""), 
-                (actu->categorie ? actu->categorie : "Divers"), 
-                actu->quantite, 
-                actu->prix_unitaire, 
-                (long)actu->date_peremption, 
-                (actu->note ? actu->note : ""));
-        
-        actu = actu->suivant;
+    TamponSauvegarde tampon;
+    if (tampon_ouvrir(&tampon, nom_fichier) != 0) return -1;
+
+    for (Produit* actu = head; actu != NULL && !tampon.erreur; actu = actu->suivant) {
+        const char* chaines[4] = {
+            champ_ou_defaut(actu->nom, "Inconnu"),
+            champ_ou_defaut(actu->description, ""),
+            champ_ou_defaut(actu->categorie, "Divers"),
+            champ_ou_defaut(actu->note, "")
+        };
+        size_t longueurs[4];
+        size_t taille_max = MARGE_LIGNE;
+        for (int i = 0; i < 4; i++) {
+            longueurs[i] = strlen(chaines[i]);
+            taille_max += longueurs[i];
+        }
+
+        char* debut = tampon_reserver(&tampon, taille_max);
+        if (debut == NULL) break;
+        char* p = formatage_entier(debut, actu->id, 1);
+        for (int i = 0; i < 3; i++) {
+            *p++ = DELIMITEUR;
+            memcpy(p, chaines[i], longueurs[i]);
+            p += longueurs[i];
+        }
+        *p++ = DELIMITEUR;
+        p = formatage_signe(p, actu->quantite);
+        *p++ = DELIMITEUR;
+        p = formatage_prix(p, actu->prix_unitaire);
+        *p++ = DELIMITEUR;
+        p = formatage_signe(p, (int64_t)actu->date_peremption);
+        *p++ = DELIMITEUR;
+        memcpy(p, chaines[3], longueurs[3]);
+        p += longueurs[3];
+        *p++ = '\n';
+        tampon.utilise += (size_t)(p - debut);
     }
 
-    fclose(fichier);
+    return tampon_publier(&tampon, nom_fichier);
 }
 
-void charger_fichier(Produit** head, char* nom_fichier) {
+static int charger_contenu_binaire(Produit** head, const char* nom_fichier, ContenuFichier* contenu, uint32_t* max_id);
+
+void charger_fichier(Produit** head, char* nom_fichier, uint32_t* max_id) {
     /*
     Argument:
         head: pointeur d'un pointeur vers la tête de la liste (pour insertion)
         nom_fichier: Chemin du fichier source à lire
+        max_id: Compteur d'ID global, relevé au plus grand ID lu (peut être NULL)
     But:
-        Lire un fichier ligne par ligne, parser les champs et reconstruire la liste chaînée
+        Projeter le fichier en mémoire, le découper en tranches analysées en parallèle
+        (une par thread), puis reconstruire la liste chaînée en un seul lot : ordre du
+        fichier et numéros de ligne conservés, une seule entrée dans le journal,
+        pas de limite de longueur de ligne
         Gère les erreurs de formatage et les lignes corrompues
     Retour:
         Aucun
     */
-    FILE* fichier = fopen(nom_fichier, "r");
-    if (fichier == NULL) {
+    ContenuFichier contenu;
+    if (ouvrir_contenu(nom_fichier, &contenu) != 0) {
         printf("[i] Info : Aucun fichier de sauvegarde trouvé ou erreur d'ouverture.\n");
         return; 
     }
 
-    char buffer[MAX_LINE_LENGTH];
-    int ligne_count = 0;
-
-    while (fgets(buffer, MAX_LINE_LENGTH, fichier)) {
-        ligne_count++;
-        
-        // strcspn retourne l'indice de \n dans le buffer
-        buffer[strcspn(buffer, "\n")] = 0;
-        char* temp = buffer;
-        
-
-        // On extrait les champs un par un
-        char* token_id = separateur_chaine(&temp, DELIMITER);
-        char* token_nom = separateur_chaine(&temp, DELIMITER);
-        char* token_desc = separateur_chaine(&temp, DELIMITER);
-        char* token_cat = separateur_chaine(&temp, DELIMITER);
-        char* token_qte = separateur_chaine(&temp, DELIMITER);
-        char* token_prix = separateur_chaine(&temp, DELIMITER);
-        char* token_date = separateur_chaine(&temp, DELIMITER);
-        char* token_note = separateur_chaine(&temp, DELIMITER);
-
-        // Si un des champs obligatoires est NULL, la ligne est corrompue donc abandonnée
-        if (!token_id || !token_nom || !token_desc || !token_cat || !token_qte || !token_prix || !token_date || !token_note) {
-            printf("Warning : Ligne %d corrompue (champs manquants), ignorée.\n", ligne_count);
-            continue;
-        }
-        uint32_t id = (uint32_t)strtoul(token_id, NULL, 10);
-        int quantite = (int)strtol(token_qte, NULL, 10);
-        float prix = strtof(token_prix, NULL);
-        
-        time_t date_peremption = 0;
-        if (token_date) {
-            date_peremption = (time_t)strtol(token_date, NULL, 10);
-        }
-
-        char* note_safe = (token_note != NULL) ? token_note : "";
-
-        Produit* nouveau_produit = creer_produit(id, token_nom, token_desc, token_cat, quantite, prix, date_peremption, note_safe);
-        
-        if (nouveau_produit != NULL) {
-            insertion(head, nouveau_produit);
+    // Instantané binaire (BGRS_FORMAT=binaire) : reconnu à sa signature
+    if (contenu.taille >= sizeof(EnteteInstantane)
+        && memcmp(contenu.donnees, MAGIE_INSTANTANE, strlen(MAGIE_INSTANTANE)) == 0) {
+        charger_contenu_binaire(head, nom_fichier, &contenu, max_id);
+        return;
+    }
+
+    // Découpage en tranches qui commencent toutes en début de ligne
+    unsigned int nb_tranches = choisir_nb_threads(contenu.taille);
+    TrancheChargement tranches[MAX_THREADS_CHARGEMENT];
+    pthread_t threads[MAX_THREADS_CHARGEMENT];
+    bool thread_lance[MAX_THREADS_CHARGEMENT];
+
+    const char* fin = contenu.donnees + contenu.taille;
+    const char* debut = contenu.donnees;
+    for (unsigned int i = 0; i < nb_tranches; i++) {
+        const char* limite = fin;
+        if (i + 1 < nb_tranches) {
+            limite = chercher_octet(contenu.donnees + contenu.taille / nb_tranches * (i + 1), fin, '\n');
+            limite = (limite != NULL) ? limite + 1 : fin;
+            if (limite < debut) limite = debut;
+        }
+        memset(&tranches[i], 0, sizeof(TrancheChargement));
+        tranches[i].debut = debut;
+        tranches[i].fin = limite;
+        debut = limite;
+    }
+
+    // La première tranche est traitée par le thread appelant
+    for (unsigned int i = 1; i < nb_tranches; i++) {
+        thread_lance[i] = (pthread_create(&threads[i], NULL, analyser_tranche, &tranches[i]) == 0);
+    }
+    analyser_tranche(&tranches[0]);
+    for (unsigned int i = 1; i < nb_tranches; i++) {
+        if (thread_lance[i]) {
+            pthread_join(threads[i], NULL);
         } else {
-            fprintf(stderr, "[!] Erreur : Echec allocation mémoire pour la ligne %d.\n", ligne_count);
+            analyser_tranche(&tranches[i]);
+        }
+    }
+
+    // Restitution dans l'ordre du fichier : avertissements et doublons
+    // s'affichent exactement comme en lecture séquentielle
+    size_t total_produits = 0;
+    for (unsigned int i = 0; i < nb_tranches; i++) {
+        total_produits += tranches[i].nb_evenements;
+    }
+    index_id_reserver(index_id_taille() + total_produits);
+
+    LotProduits lot;
+    lot_initialiser(&lot);
+    int ligne_base = 0;
+    bool evenements_perdus = false;
+
+    for (unsigned int i = 0; i < nb_tranches; i++) {
+        TrancheChargement* tranche = &tranches[i];
+        for (size_t j = 0; j < tranche->nb_evenements; j++) {
+            EvenementLigne* e = &tranche->evenements[j];
+            int numero = ligne_base + e->ligne;
+
+            if (e->type == LIGNE_CORROMPUE) {
+                printf("Warning : Ligne %d corrompue (champs manquants), ignorée.\n", numero);
+            } else if (e->type == LIGNE_ECHEC_CREATION) {
+                fprintf(stderr, "[!] Erreur : Echec allocation mémoire pour la ligne %d.\n", numero);
+            } else if (lot_ajouter(&lot, e->produit) != 0) {
+                printf("Warning : Ligne %d ignorée (ID %u déjà présent).\n", numero, e->produit->id);
+                liberer_produit(e->produit);
+            }
+        }
+        evenements_perdus = evenements_perdus || tranche->evenements_perdus;
+        ligne_base += tranche->nb_lignes;
+        free(tranche->evenements);
+    }
+    if (evenements_perdus) {
+        fprintf(stderr, "[!] Erreur : Echec allocation mémoire, certaines lignes n'ont pas été chargées.\n");
+    }
+
+    fermer_contenu(&contenu);
+
+    size_t nb_charges = lot.nombre;
+    uint32_t lot_max_id = lot.max_id;
+    if (insertion_lot(head, &lot) != 0) {
+        fprintf(stderr, "[!] Erreur : Echec allocation des index, chargement de %s annule.\n", nom_fichier);
+        return;
+    }
+    if (max_id != NULL && lot_max_id > *max_id) {
+        *max_id = lot_max_id;
+    }
+    if (nb_charges > 0) {
+        ajouter_log(HISTORIQUE_CHARGEMENT, nb_charges, 0, nom_fichier);
+    }
+}
+
+
+static void somme_melanger(SommeControle* somme, uint64_t mot) {
+    /*
+    Argument:
+        somme: État de la somme de contrôle
+        mot: 8 octets à intégrer
+    But:
+        Étape FNV-1a appliquée à un mot de 8 octets (8 fois moins d'itérations
+        qu'octet par octet), suivie d'un repli des bits de poids fort
+    Retour:
+        Aucun
+    */
+    somme->valeur = (somme->valeur ^ mot) * 0x100000001B3ULL;
+    somme->valeur ^= somme->valeur >> 29;
+}
+
+static void somme_initialiser(SommeControle* somme) {
+    /*
+    Argument:
+        somme: État à initialiser
+    But:
+        Préparer une somme de contrôle vide
+    Retour:
+        Aucun
+    */
+    somme->valeur = 0xCBF29CE484222325ULL;
+    somme->nb_en_attente = 0;
+}
+
+static void somme_ajouter(SommeControle* somme, const void* donnees, size_t taille) {
+    /*
+    Argument:
+        somme: État de la somme de contrôle
+        donnees: Octets à intégrer
+        taille: Nombre d'octets
+    But:
+        Intégrer un bloc ; les octets qui ne complètent pas un mot sont gardés
+        en attente, le résultat ne dépend donc pas du découpage en blocs
+    Retour:
+        Aucun
+    */
+    const unsigned char* p = (const unsigned char*)donnees;
+
+    while (taille > 0 && somme->nb_en_attente > 0) {
+        somme->en_attente[somme->nb_en_attente++] = *p++;
+        taille--;
+        if (somme->nb_en_attente == 8) {
+            uint64_t mot;
+            memcpy(&mot, somme->en_attente, 8);
+            somme_melanger(somme, mot);
+            somme->nb_en_attente = 0;
         }
     }
+    while (taille >= 8) {
+        uint64_t mot;
+        memcpy(&mot, p, 8);
+        somme_melanger(somme, mot);
+        p += 8;
+        taille -= 8;
+    }
+    while (taille > 0) {
+        somme->en_attente[somme->nb_en_attente++] = *p++;
+        taille--;
+    }
+}
 
-    fclose(fichier);
+static uint64_t somme_terminer(SommeControle* somme) {
+    /*
+    Argument:
+        somme: État de la somme de contrôle
+    But:
+        Intégrer les derniers octets (complétés par des zéros) et la longueur du reste
+    Retour:
+        Valeur finale de la somme
+    */
+    uint64_t mot = 0;
+    memcpy(&mot, somme->en_attente, somme->nb_en_attente);
+    somme_melanger(somme, mot ^ ((uint64_t)somme->nb_en_attente << 56));
+    somme->nb_en_attente = 0;
+    return somme->valeur;
+}
+
+int sauvegarde_binaire(Produit* head, const char* nom_fichier) {
+    /*
+    Argument:
+        head: Pointeur vers la tête de la liste à sauvegarder
+        nom_fichier: Chemin du fichier de destination
+    But:
+        Écrire un instantané binaire : en-tête, enregistrements de taille fixe
+        (valeurs numériques exactes, prix compris), puis tas des chaînes.
+        Deux parcours de la liste : les enregistrements, puis les chaînes ;
+        l'en-tête et sa somme de contrôle sont écrits en dernier
+    Retour:
+        0 si succès, -1 sinon
+    */
+    TamponSauvegarde tampon;
+    if (tampon_ouvrir(&tampon, nom_fichier) != 0) return -1;
+
+    EnteteInstantane entete;
+    memset(&entete, 0, sizeof(entete));
+    memcpy(entete.magie, MAGIE_INSTANTANE, sizeof(entete.magie));
+    entete.version = VERSION_INSTANTANE;
+    entete.boutisme = MARQUEUR_BOUTISME;
+    entete.taille_enregistrement = sizeof(EnregistrementInstantane);
+
+    tampon_ajouter(&tampon, &entete, sizeof(entete)); // réécrit à la fin
+    SommeControle somme;
+    somme_initialiser(&somme);
+    uint64_t position_tas = 0;
+
+    for (Produit* actu = head; actu != NULL && !tampon.erreur; actu = actu->suivant) {
+        const char* chaines[4] = {
+            champ_ou_defaut(actu->nom, "Inconnu"),
+            champ_ou_defaut(actu->description, ""),
+            champ_ou_defaut(actu->categorie, "Divers"),
+            champ_ou_defaut(actu->note, "")
+        };
+        EnregistrementInstantane e;
+        memset(&e, 0, sizeof(e));
+        e.id = actu->id;
+        e.quantite = actu->quantite;
+        e.prix_unitaire = actu->prix_unitaire;
+        e.date_peremption = (int64_t)actu->date_peremption;
+        for (int i = 0; i < 4; i++) {
+            e.longueurs[i] = (uint32_t)strlen(chaines[i]);
+            e.positions[i] = position_tas;
+            position_tas += e.longueurs[i] + 1; // '\0' conservé dans le tas
+        }
+        somme_ajouter(&somme, &e, sizeof(e));
+        tampon_ajouter(&tampon, &e, sizeof(e));
+        entete.nb_produits++;
+    }
+
+    for (Produit* actu = head; actu != NULL && !tampon.erreur; actu = actu->suivant) {
+        const char* chaines[4] = {
+            champ_ou_defaut(actu->nom, "Inconnu"),
+            champ_ou_defaut(actu->description, ""),
+            champ_ou_defaut(actu->categorie, "Divers"),
+            champ_ou_defaut(actu->note, "")
+        };
+        for (int i = 0; i < 4; i++) {
+            size_t taille = strlen(chaines[i]) + 1;
+            somme_ajouter(&somme, chaines[i], taille);
+            tampon_ajouter(&tampon, chaines[i], taille);
+        }
+    }
+
+    entete.taille_tas = position_tas;
+    entete.somme_controle = somme_terminer(&somme);
+    tampon_vider(&tampon);
+    if (!tampon.erreur && pwrite(tampon.fd, &entete, sizeof(entete), 0) != (ssize_t)sizeof(entete)) {
+        tampon.erreur = true;
+    }
+    return tampon_publier(&tampon, nom_fichier);
 }
 
+int charger_binaire(Produit** head, const char* nom_fichier, uint32_t* max_id) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste
+        nom_fichier: Instantané écrit par sauvegarde_binaire
+        max_id: Compteur d'ID global, relevé au plus grand ID lu (peut être NULL)
+    But:
+        Projeter l'instantané puis le charger (voir charger_contenu_binaire)
+    Retour:
+        0 si succès, -1 si le fichier est absent, incompatible ou corrompu,
+        ou si la mémoire manque (inventaire inchangé)
+    */
+    ContenuFichier contenu;
+    if (ouvrir_contenu(nom_fichier, &contenu) != 0) {
+        printf("[i] Info : Aucun instantané trouvé ou erreur d'ouverture.\n");
+        return -1;
+    }
+    return charger_contenu_binaire(head, nom_fichier, &contenu, max_id);
+}
+
+static int charger_contenu_binaire(Produit** head, const char* nom_fichier, ContenuFichier* fichier, uint32_t* max_id) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste
+        nom_fichier: Nom de l'instantané (messages et historique)
+        fichier: Instantané projeté en mémoire, refermé avant le retour
+        max_id: Compteur d'ID global, relevé au plus grand ID lu (peut être NULL)
+    But:
+        Vérifier l'en-tête, la taille et la somme de contrôle, puis reconstruire
+        les produits directement depuis les enregistrements : aucune conversion
+        de texte, et les produits adoptent leurs chaînes dans la copie du tas
+        faite en un bloc
+    Retour:
+        0 si succès, -1 si le fichier est incompatible ou corrompu,
+        ou si la mémoire manque (inventaire inchangé)
+    */
+    ContenuFichier contenu = *fichier;
+
+    EnteteInstantane entete;
+    if (contenu.taille < sizeof(entete)) {
+        fprintf(stderr, "[!] Erreur : %s n'est pas un instantané BGRS.\n", nom_fichier);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+    memcpy(&entete, contenu.donnees, sizeof(entete));
+
+    if (memcmp(entete.magie, MAGIE_INSTANTANE, sizeof(entete.magie)) != 0
+        || entete.boutisme != MARQUEUR_BOUTISME
+        || entete.taille_enregistrement != sizeof(EnregistrementInstantane)) {
+        fprintf(stderr, "[!] Erreur : %s n'est pas un instantané BGRS compatible.\n", nom_fichier);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+    if (entete.version != VERSION_INSTANTANE) {
+        fprintf(stderr, "[!] Erreur : Version d'instantané %u non supportée.\n", entete.version);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+
+    size_t taille_donnees = contenu.taille - sizeof(entete);
+    // nb_produits est borné avant la multiplication et le tas est comparé au
+    // reste du fichier : un en-tête forgé ne peut pas faire déborder le calcul
+    if (entete.nb_produits > taille_donnees / sizeof(EnregistrementInstantane)
+        || entete.taille_tas != taille_donnees - entete.nb_produits * sizeof(EnregistrementInstantane)) {
+        fprintf(stderr, "[!] Erreur : %s est tronqué ou corrompu (taille incohérente).\n", nom_fichier);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+    SommeControle somme;
+    somme_initialiser(&somme);
+    somme_ajouter(&somme, contenu.donnees + sizeof(entete), taille_donnees);
+    if (somme_terminer(&somme) != entete.somme_controle) {
+        fprintf(stderr, "[!] Erreur : %s est corrompu (somme de contrôle invalide).\n", nom_fichier);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+
+    const char* enregistrements = contenu.donnees + sizeof(entete);
+
+    // Le tas est recopié une seule fois dans l'arène : les produits pointent
+    // directement dessus, sans copie chaîne par chaîne
+    char* tas = memoire_tas(entete.taille_tas);
+    if (tas == NULL) {
+        fprintf(stderr, "[!] Erreur : Echec allocation mémoire pour %s.\n", nom_fichier);
+        fermer_contenu(&contenu);
+        return -1;
+    }
+    memcpy(tas, enregistrements + entete.nb_produits * sizeof(EnregistrementInstantane), entete.taille_tas);
+
+    index_id_reserver(index_id_taille() + entete.nb_produits);
+    LotProduits lot;
+    lot_initialiser(&lot);
+
+    for (uint64_t i = 0; i < entete.nb_produits; i++) {
+        EnregistrementInstantane e;
+        memcpy(&e, enregistrements + i * sizeof(e), sizeof(e));
+
+        char* chaines[4];
+        bool valide = true;
+        for (int j = 0; j < 4; j++) {
+            // Chaque chaîne doit tenir dans le tas et se terminer par son '\0'
+            if (e.positions[j] >= entete.taille_tas || e.longueurs[j] >= entete.taille_tas - e.positions[j]
+                || tas[e.positions[j] + e.longueurs[j]] != '\0') {
+                valide = false;
+                break;
+            }
+            chaines[j] = tas + e.positions[j];
+        }
+
+        Produit* produit = valide ? adopter_produit(e.id, chaines[0], chaines[1], chaines[2], e.quantite,
+                                                    e.prix_unitaire, (time_t)e.date_peremption, chaines[3]) : NULL;
+        if (produit == NULL) {
+            printf("Warning : Enregistrement %llu invalide, ignoré.\n", (unsigned long long)(i + 1));
+        } else if (lot_ajouter(&lot, produit) != 0) {
+            printf("Warning : Enregistrement %llu ignoré (ID %u déjà présent).\n", (unsigned long long)(i + 1), e.id);
+            liberer_produit(produit);
+        }
+    }
+    fermer_contenu(&contenu);
+
+    size_t nb_charges = lot.nombre;
+    uint32_t lot_max_id = lot.max_id;
+    if (insertion_lot(head, &lot) != 0) {
+        fprintf(stderr, "[!] Erreur : Echec allocation des index, chargement de %s annule.\n", nom_fichier);
+        return -1;
+    }
+    if (max_id != NULL && lot_max_id > *max_id) {
+        *max_id = lot_max_id;
+    }
+    if (nb_charges > 0) {
+        ajouter_log(HISTORIQUE_CHARGEMENT_INSTANTANE, nb_charges, 0, nom_fichier);
+    }
+    return 0;
+}
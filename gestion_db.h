@@ -3,9 +3,26 @@
 
 #include "gestion_produit.h"
 
-void charger_fichier(Produit** head, char* nom_fichier);
+void charger_fichier(Produit** head, char* nom_fichier, uint32_t* max_id);
+void charger_fichier_configurer_threads(unsigned int nb_threads);
 
-void sauvegarde(Produit* head, const char* nom_fichier);
+/*
+    Sauvegarde texte : écrite dans "<fichier>.XXXXXX" (mkstemp) par gros blocs puis renommée
+    sur la destination (jamais de fichier tronqué). fsync activé par défaut.
+*/
+int sauvegarde(Produit* head, const char* nom_fichier);
+void sauvegarde_configurer_fsync(bool synchroniser);
+
+/*
+    Instantané binaire : enregistrements de taille fixe et tas de chaînes,
+    valeurs exactes (prix compris) et rechargement sans conversion de texte.
+    La sauvegarde texte reste le format lisible par un humain et celui par
+    défaut ; sauvegarde_configurer_format(true) fait écrire des instantanés
+    à sauvegarde, et charger_fichier reconnaît les deux formats.
+*/
+void sauvegarde_configurer_format(bool binaire);
+int sauvegarde_binaire(Produit* head, const char* nom_fichier);
+int charger_binaire(Produit** head, const char* nom_fichier, uint32_t* max_id);
 
 
 #endif
\ No newline at end of file
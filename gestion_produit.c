@@ -13,89 +13,320 @@ But : Contient la logique pour la manipulation de la structure Produit
 #include <time.h>
 #include <string.h>
 #include <stdbool.h>
-#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #include "gestion_produit.h"
-
-void ajouter_log(const char *format, ...) {
+#include "index_id.h"
+#include "echeancier.h"
+#include "colonnes.h"
+#include "index_nom.h"
+#include "journal.h"
+#include "journal_ops.h"
+#include "memoire.h"
+#include "cle_recherche.h"
+#include "categories.h"
+#include "index_tri.h"
+#include "rendu.h"
+#include "stats.h"
+
+#define NB_CHAINES 4 // nom, description, note et clé de recherche du nom (la catégorie est internée)
+#define CHAINE_CLE 3
+
+static bool journalisation_active = true;
+
+static pthread_rwlock_t verrou_inventaire = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t porte_ecrivains = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint ecrivains_en_attente = 0;
+
+void inventaire_verrouiller_lecture(void) {
     /*
     Argument:
-        format : Chaîne de caractère 
-        ...    : Arguments variables 
+        Aucun
     But:
-        Ouvrir "historique.log" en mode ajout (append), générer un horodatage actuel,
-        et écrire le message formaté directement dans le fichier.
+        Entrer en lecture : les lecteurs ne s'attendent pas entre eux. Si un
+        écrivain attend, le nouveau lecteur passe après lui (sinon un flot
+        continu de lectures affamerait les écritures)
     Retour:
         Aucun
     */
-    FILE *f = fopen("historique.log", "a");
-    if (f == NULL) {
-        fprintf(stderr, "Impossible d'ecrire dans historique.log\n");
-        return;
+    if (atomic_load_explicit(&ecrivains_en_attente, memory_order_relaxed) != 0) {
+        pthread_mutex_lock(&porte_ecrivains);
+        pthread_mutex_unlock(&porte_ecrivains);
     }
+    pthread_rwlock_rdlock(&verrou_inventaire);
+}
 
-    time_t now = time(NULL);
-    char *date_str = ctime(&now);
-    date_str[strcspn(date_str, "\n")] = 0; // Retire le \n du ctime
-    
-    fprintf(f, "[%s] ", date_str);
+void inventaire_verrouiller_ecriture(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Entrer en écriture : attendre la fin des lectures en cours en
+        retenant les nouvelles à la porte
+    Retour:
+        Aucun
+    */
+    atomic_fetch_add_explicit(&ecrivains_en_attente, 1, memory_order_relaxed);
+    pthread_mutex_lock(&porte_ecrivains);
+    pthread_rwlock_wrlock(&verrou_inventaire);
+    pthread_mutex_unlock(&porte_ecrivains);
+    atomic_fetch_sub_explicit(&ecrivains_en_attente, 1, memory_order_relaxed);
+}
+
+void inventaire_deverrouiller(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Sortir de la lecture ou de l'écriture
+    Retour:
+        Aucun
+    */
+    pthread_rwlock_unlock(&verrou_inventaire);
+}
+
+void ajouter_log(TypeHistorique type, uint64_t id, int64_t quantite, const char* texte) {
+    /*
+    Argument:
+        type : Nature de l'action (HISTORIQUE_*)
+        id : ID du produit, ou nombre de produits / d'opérations
+        quantite : Quantité (ajout), 0 sinon
+        texte : Nom du produit ou fichier concerné
+    But:
+        Ajouter un événement daté à l'historique binaire via le journal bufferisé
+        (le fichier reste ouvert, l'écriture disque est faite par le thread de vidage)
+    Retour:
+        Aucun
+    */
+    if (!journalisation_active) return;
 
-    va_list args;
-    va_start(args, format);
-    vfprintf(f, format, args);
-    va_end(args);
+    EvenementHistorique evenement = {type, 0, id, quantite, texte, strlen(texte)};
+    journal_ecrire(&evenement);
+}
 
-    fprintf(f, "\n");
-    fclose(f);
+void activer_journalisation(bool active) {
+    /*
+    Argument:
+        active: false pendant le rejeu du journal des opérations
+    But:
+        Suspendre l'historique et le journal des opérations, pour ne pas
+        réécrire des opérations qui y figurent déjà
+    Retour:
+        Aucun
+    */
+    journalisation_active = active;
 }
 
-int insertion(Produit** head, Produit* nouveau_produit) {
+static int inserer(Produit** head, Produit* nouveau_produit) {
     /*
     Argument:
         head: pointeur d'un pointeur vers la tête de la liste des produits
         nouveau_produit: Pointeur vers le nouveau produit à insérer
     But:
-        Insérer le nouveau produit au début de la liste chaînée
+        Insérer le nouveau produit au début de la liste chaînée et le référencer dans l'index d'ID
     Retour:
-        0 si l'insertion a réussi, -1 sinon
+        0 si l'insertion a réussi, -1 sinon (ID déjà présent ou erreur d'allocation)
     */
     if (head == NULL || nouveau_produit == NULL) {
         return -1; 
     }
     else {
+        if (index_id_inserer(nouveau_produit) != 0) {
+            return -1;
+        }
+        if (echeancier_planifier(nouveau_produit) != 0) {
+            index_id_retirer(nouveau_produit->id);
+            return -1;
+        }
+        if (colonnes_ajouter(nouveau_produit) != 0) {
+            echeancier_retirer(nouveau_produit);
+            index_id_retirer(nouveau_produit->id);
+            return -1;
+        }
+        if (index_nom_ajouter(nouveau_produit) != 0) {
+            index_nom_retirer(nouveau_produit);
+            colonnes_retirer(nouveau_produit);
+            echeancier_retirer(nouveau_produit);
+            index_id_retirer(nouveau_produit->id);
+            return -1;
+        }
+        if (categories_ajouter(nouveau_produit) != 0) {
+            index_nom_retirer(nouveau_produit);
+            colonnes_retirer(nouveau_produit);
+            echeancier_retirer(nouveau_produit);
+            index_id_retirer(nouveau_produit->id);
+            return -1;
+        }
+        if (index_tri_ajouter(nouveau_produit) != 0) {
+            categories_retirer(nouveau_produit);
+            index_nom_retirer(nouveau_produit);
+            colonnes_retirer(nouveau_produit);
+            echeancier_retirer(nouveau_produit);
+            index_id_retirer(nouveau_produit->id);
+            return -1;
+        }
         nouveau_produit->suivant = *head; // Le nouveau pointe vers l'ancien premier
+        nouveau_produit->precedent = NULL;
+        if (*head != NULL) {
+            (*head)->precedent = nouveau_produit;
+        }
         *head = nouveau_produit; // La tête pointe vers le nouveau
 
-        ajouter_log("[+] Ajout du produit ID %u : %s (Qte: %d)", 
-                    nouveau_produit->id, 
-                    nouveau_produit->nom, 
-                    nouveau_produit->quantite);
+        ajouter_log(HISTORIQUE_AJOUT, nouveau_produit->id, nouveau_produit->quantite, nouveau_produit->nom);
+        if (journalisation_active) {
+            journal_ops_insertion(nouveau_produit);
+        }
     
     }
     return 0; 
 }
 
+int insertion(Produit** head, Produit* nouveau_produit) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste des produits
+        nouveau_produit: Pointeur vers le nouveau produit à insérer
+    But:
+        Insérer le produit (voir inserer) en mesurant la durée de l'ajout
+    Retour:
+        0 si l'insertion a réussi, -1 sinon (ID déjà présent ou erreur d'allocation)
+    */
+    STATS_DEBUT(debut);
+    int res = inserer(head, nouveau_produit);
+    STATS_FIN(STATS_AJOUT, debut);
+    return res;
+}
+
+void lot_initialiser(LotProduits* lot) {
+    /*
+    Argument:
+        lot: Lot à préparer
+    But:
+        Initialiser un lot vide
+    Retour:
+        Aucun
+    */
+    lot->premier = NULL;
+    lot->dernier = NULL;
+    lot->nombre = 0;
+    lot->max_id = 0;
+    lot->inverser = false;
+}
+
+int lot_ajouter(LotProduits* lot, Produit* produit) {
+    /*
+    Argument:
+        lot: Lot en cours de construction
+        produit: Produit à ajouter en fin de lot
+    But:
+        Référencer le produit dans l'index d'ID et l'accrocher en fin de chaîne,
+        sans journalisation ni mise à jour de l'échéancier (faites par insertion_lot)
+    Retour:
+        0 si succès, -1 si l'ID est déjà présent ou en cas d'erreur d'allocation
+    */
+    if (lot == NULL || produit == NULL) return -1;
+    if (index_id_inserer(produit) != 0) return -1;
+
+    produit->suivant = NULL;
+    produit->precedent = lot->dernier;
+    if (lot->dernier != NULL) {
+        lot->dernier->suivant = produit;
+    } else {
+        lot->premier = produit;
+    }
+    lot->dernier = produit;
+    lot->nombre++;
+    if (produit->id > lot->max_id) lot->max_id = produit->id;
+    return 0;
+}
+
+static void abandonner_lot(LotProduits* lot) {
+    /*
+    Argument:
+        lot: Lot dont l'indexation a échoué, pas encore raccordé à la liste
+    But:
+        Retirer chaque produit du lot de tous les index (ceux qui n'y figurent
+        pas sont ignorés), puis le rendre à la réserve mémoire
+    Retour:
+        Aucun
+    */
+    for (Produit* actu = lot->premier; actu != NULL;) {
+        Produit* suivant = actu->suivant;
+        index_tri_retirer(actu);
+        categories_retirer(actu);
+        index_nom_retirer(actu);
+        colonnes_retirer(actu);
+        echeancier_retirer(actu);
+        index_id_retirer(actu->id);
+        liberer_produit(actu);
+        actu = suivant;
+    }
+    lot_initialiser(lot);
+}
+
+int insertion_lot(Produit** head, LotProduits* lot) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste des produits
+        lot: Lot construit par lot_ajouter (vidé après l'appel)
+    But:
+        Planifier toutes les péremptions du lot en une seule reconstruction du tas,
+        le recopier dans les colonnes, indexer les noms, les catégories et les
+        vues triées, puis
+        raccorder le lot entier en tête de liste en conservant son ordre
+        (ou à l'envers si lot->inverser)
+    Retour:
+        0 si succès, -1 si l'échéancier, les colonnes ou l'un des index n'ont
+        pas pu être alloués : le lot est alors retiré des index et libéré, la
+        liste reste inchangée
+    */
+    if (head == NULL || lot == NULL || lot->premier == NULL) return 0;
+
+    // Avant le raccord : la chaîne du lot se termine encore par NULL
+    if (echeancier_planifier_lot(lot->premier) != 0
+        || colonnes_ajouter_lot(lot->premier) != 0
+        || index_nom_ajouter_lot(lot->premier) != 0
+        || categories_ajouter_lot(lot->premier) != 0
+        || index_tri_ajouter_lot(lot->premier) != 0) {
+        abandonner_lot(lot);
+        return -1;
+    }
+
+    // Après l'indexation : les index préfèrent les ID croissants de la chaîne
+    if (lot->inverser) {
+        Produit* ancien_premier = lot->premier;
+        for (Produit* actu = lot->premier; actu != NULL;) {
+            Produit* suivant = actu->suivant;
+            actu->suivant = actu->precedent;
+            actu->precedent = suivant;
+            actu = suivant;
+        }
+        lot->premier = lot->dernier;
+        lot->dernier = ancien_premier;
+    }
+
+    lot->dernier->suivant = *head;
+    if (*head != NULL) {
+        (*head)->precedent = lot->dernier;
+    }
+    *head = lot->premier;
+
+    lot_initialiser(lot);
+    return 0;
+}
+
 int affichage(Produit** head) {
     /*
     Argument:
         head: pointeur du pointeur vers le premier élément de la liste
     But:
-        Afficher tous les produits de la liste sur la sortie standard
+        Afficher tous les produits de la liste sur la sortie standard (rendu
+        bufferisé de rendu.c, champs de l'affichage historique)
     Retour:
         0 si l'affichage a réussi
     */
-    Produit* actu = *head;
-    while (actu != NULL) {
-        printf("ID: %u\n", actu->id);
-        printf("Nom: %s\n", actu->nom);
-        printf("Categorie: %s\n", actu->categorie);
-        printf("Description: %s\n", actu->description);    
-        printf("Prix Unitaire: %.2f\n", actu->prix_unitaire);    
-        printf("Quantite: %d\n", actu->quantite);             
-        printf("Date de Peremption: %s", ctime(&actu->date_peremption)); // ctime ajoute déjà un \n
-        printf("-------------------------\n");
-        actu = actu->suivant;
-    }
+    rendu_produits(stdout, *head, 0, 0, RENDU_DEFAUT, NULL);
     return 0; 
 }
 
@@ -105,24 +336,17 @@ Produit* rechercher_par_id(Produit* head, uint32_t id) {
         head: Pointeur vers le premier élément de la liste
         id: Identifiant du produit à rechercher
     But:
-        Rechercher un produit spécifique grâce à son identifiant unique
+        Rechercher un produit spécifique grâce à son identifiant unique (via l'index d'ID)
     Retour:
         Pointeur vers le produit trouvé, ou NULL si non trouvé
     */
-    if (id <= 0) {
+    if (id <= 0 || head == NULL) {
         return NULL; 
     }
-    Produit* actu = head;
-    while (actu != NULL) {
-        if (actu->id == id) {
-            return actu; 
-        }
-        actu = actu->suivant;
-    }
-    return NULL; 
+    return index_id_chercher(id);
 }
 
-int suppression_par_id(Produit** head, uint32_t id) {
+static int supprimer(Produit** head, uint32_t id) {
     /*
     Argument:
         head: pointeur d'un pointeur vers la tête de la liste
@@ -136,38 +360,119 @@ int suppression_par_id(Produit** head, uint32_t id) {
         return -1; 
     }
 
-    Produit* actu = *head;
-    Produit* actu_moins_1 = NULL; 
-
     // Recherche du produit a supprimer
-    while (actu != NULL && actu->id != id) {
-        actu_moins_1 = actu;       
-        actu = actu->suivant;      
-    }
+    Produit* actu = index_id_chercher(id);
 
     // Si le produit n'a pas ete trouve
     if (actu == NULL) {
         return -1; 
     }
-    ajouter_log("[-] Suppression du produit ID %u : %s", actu->id, actu->nom);
-
-    if (actu_moins_1 == NULL) {
+    ajouter_log(HISTORIQUE_SUPPRESSION, actu->id, 0, actu->nom);
+    if (journalisation_active) {
+        journal_ops_suppression(id);
+    }
+    index_id_retirer(id);
+    echeancier_retirer(actu);
+    colonnes_retirer(actu);
+    index_nom_retirer(actu);
+    categories_retirer(actu);
+    index_tri_retirer(actu);
+
+    if (actu->precedent == NULL) {
         // cas ou le produit a supprimer est le premier de la liste
         *head = actu->suivant; 
     } else {
         // cas general
-        actu_moins_1->suivant = actu->suivant; 
+        actu->precedent->suivant = actu->suivant; 
+    }
+    if (actu->suivant != NULL) {
+        actu->suivant->precedent = actu->precedent;
     }
 
     // Libération de la mémoire
-    free(actu->nom);
-    free(actu->description);
-    free(actu->categorie);
-    free(actu->note);
-    free(actu); 
+    liberer_produit(actu);
     return 0; 
 }
 
+int suppression_par_id(Produit** head, uint32_t id) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste
+        id: Identifiant du produit à supprimer
+    But:
+        Supprimer le produit (voir supprimer) en mesurant la durée de la suppression
+    Retour:
+        0 si la suppression a réussi, -1 sinon (liste vide ou ID introuvable)
+    */
+    STATS_DEBUT(debut);
+    int res = supprimer(head, id);
+    STATS_FIN(STATS_SUPPRESSION, debut);
+    return res;
+}
+
+size_t supprimer_perimes(Produit** head, time_t maintenant, bool afficher) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste
+        maintenant: Date de référence (un appel à time par lot d'opérations suffit)
+        afficher: true pour annoncer chaque suppression sur la sortie standard
+    But:
+        Supprimer les produits dont la date de péremption est dépassée.
+        L'échéancier donne directement le produit le plus proche de sa péremption :
+        rien à parcourir tant qu'aucun produit n'est périmé
+    Retour:
+        Nombre de produits supprimés
+    */
+    STATS_DEBUT(debut);
+    size_t count = 0;
+    Produit* actu;
+
+    // Si date existe (>0, seuls ces produits sont dans l'échéancier) ET date passée (< maintenant)
+    while ((actu = echeancier_prochain()) != NULL && actu->date_peremption < maintenant) {
+        if (afficher) {
+            printf("[-] Suppression du produit perime ID %u (%s)\n", actu->id, actu->nom);
+        }
+        if (suppression_par_id(head, actu->id) != 0) {
+            echeancier_retirer(actu); // produit hors inventaire, on ne boucle pas dessus
+            continue;
+        }
+        count++;
+    }
+    if (count > 0) STATS_FIN(STATS_PURGE, debut); // les passages sans suppression ne sont pas comptés
+    return count;
+}
+
+void liberer_produit(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit isolé (déjà retiré de la liste et de l'index, ou jamais inséré)
+    But:
+        Rendre le nœud et sa zone de chaînes à la réserve mémoire
+    Retour:
+        Aucun
+    */
+    memoire_rendre_produit(produit);
+}
+
+static void copier_champs(char* zone, const char* sources[NB_CHAINES], const size_t longueurs[NB_CHAINES], char* champs[NB_CHAINES]) {
+    /*
+    Argument:
+        zone: Zone de l'arène assez grande pour les quatre chaînes et leurs '\0'
+        sources: Chaînes à copier (nom, description, note, clé du nom)
+        longueurs: Longueurs des chaînes
+        champs: Pointeurs vers les copies
+    But:
+        Ranger les quatre chaînes d'un produit côte à côte
+    Retour:
+        Aucun
+    */
+    for (int i = 0; i < NB_CHAINES; i++) {
+        champs[i] = zone;
+        memcpy(zone, sources[i], longueurs[i] + 1);
+        zone += longueurs[i] + 1;
+    }
+}
+
 Produit* creer_produit(uint32_t id, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note) {
     /*
     Argument:
@@ -178,6 +483,8 @@ Produit* creer_produit(uint32_t id, const char* nom, const char* description, co
         date_peremption: Timestamp 
     But:
         Allouer et initialiser un nouveau produit avec une copie des chaînes
+        et la clé de recherche du nom (nœud pris dans la réserve, chaînes côte
+        à côte dans l'arène, catégorie internée)
     Retour:
         Pointeur vers le nouveau produit créé, ou NULL en cas d'erreur d'allocation ou de paramètre invalide
     */
@@ -185,124 +492,242 @@ Produit* creer_produit(uint32_t id, const char* nom, const char* description, co
     if (quantite < 0 || prix_unitaire < 0) {
         return NULL; 
     }
-    if (strlen(nom) > 64 || strlen(description) > 1024) return NULL;
-    Produit* np = (Produit*)calloc(1, sizeof(Produit));
+    if (strlen(nom) > 64) return NULL;
+    char cle[65];
+    const char* sources[NB_CHAINES] = {nom, description, note, cle};
+    size_t longueurs[NB_CHAINES];
+    size_t total = 0;
+    longueurs[CHAINE_CLE] = cle_normaliser(nom, cle);
+    for (int i = 0; i < NB_CHAINES; i++) {
+        if (i != CHAINE_CLE) longueurs[i] = strlen(sources[i]);
+        total += longueurs[i] + 1;
+    }
+    if (longueurs[1] > 1024) return NULL;
+
+    // Un nœud de la réserve, une seule zone d'arène pour les quatre chaînes
+    // et le libellé partagé de la catégorie
+    Produit* np = memoire_produit();
     if (np == NULL) return NULL;
-    
-    // Allocation dynamique des champs string (+1 pour le \0)
-    np->nom = (char*)malloc((strlen(nom) + 1) * sizeof(char));
-    np->description = (char*)malloc((strlen(description) + 1) * sizeof(char));
-    np->categorie = (char*)malloc((strlen(categorie) + 1) * sizeof(char));
-    np->note = (char*)malloc((strlen(note) + 1) * sizeof(char));
-
-    // Vérification atomique des allocations
-    if (np->nom == NULL || np->description == NULL || np->categorie == NULL || np->note == NULL) {
-        free(np->nom);
-        free(np->description);
-        free(np->categorie);
-        free(np->note);
-        free(np);
+    np->id_categorie = categories_interner(categorie, &np->categorie);
+    char* zone = (np->id_categorie != 0) ? memoire_chaines(total) : NULL;
+    if (zone == NULL) {
+        memoire_rendre_produit(np);
         return NULL;
     }
-
-    // Copie des données
-    snprintf(np->nom, strlen(nom) + 1, "%s", nom);
-    snprintf(np->description, strlen(description) + 1, "%s", description);
-    snprintf(np->categorie, strlen(categorie) + 1, "%s", categorie);
-    snprintf(np->note, strlen(note) + 1, "%s", note);
-    
+    char* champs[NB_CHAINES];
+    copier_champs(zone, sources, longueurs, champs);
+    np->nom = champs[0];
+    np->description = champs[1];
+    np->note = champs[2];
+    np->cle_nom = champs[CHAINE_CLE];
+    np->longueur_cle = (uint32_t)longueurs[CHAINE_CLE];
+    np->zone = zone;
+    np->taille_zone = total;
 
     np->id = id;
     np->quantite = quantite;
     np->prix_unitaire = prix_unitaire;
     np->date_peremption = date_peremption;
     np->suivant = NULL;
+    np->precedent = NULL;
+    np->rang_peremption = 0;
 
     return np; 
 }
 
-Produit* modifier_produit(Produit* produit, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note) {
+Produit* adopter_produit(uint32_t id, char* nom, char* description, char* categorie, int quantite, float prix_unitaire, time_t date_peremption, char* note) {
+    /*
+    Argument:
+        id: Identifiant unique
+        nom, description, categorie, note: Chaînes déjà rangées dans l'arène
+                                           (memoire_chaines), reprises sans copie
+        quantite, prix_unitaire, date_peremption: Comme creer_produit
+    But:
+        Créer un produit autour de chaînes déjà en mémoire (tas d'un instantané binaire).
+        Seule la clé de recherche du nom est calculée et rangée dans l'arène
+        (c'est la seule zone dont le produit est propriétaire, le tas est
+        partagé) ; la catégorie est internée (la copie du tas n'est plus utilisée)
+    Retour:
+        Pointeur vers le nouveau produit, ou NULL en cas d'erreur d'allocation ou de paramètre invalide
+    */
+    if (quantite < 0 || prix_unitaire < 0) return NULL;
+    size_t longueur_nom = strlen(nom);
+    if (longueur_nom > 64 || strlen(description) > 1024) return NULL;
+
+    Produit* np = memoire_produit();
+    if (np == NULL) return NULL;
+    np->id_categorie = categories_interner(categorie, &np->categorie);
+    np->cle_nom = (np->id_categorie != 0) ? memoire_chaines(longueur_nom + 1) : NULL;
+    if (np->cle_nom == NULL) {
+        memoire_rendre_produit(np);
+        return NULL;
+    }
+    np->longueur_cle = (uint32_t)cle_normaliser(nom, np->cle_nom);
+    np->zone = np->cle_nom;
+    np->taille_zone = longueur_nom + 1;
+    np->id = id;
+    np->nom = nom;
+    np->description = description;
+    np->note = note;
+    np->quantite = quantite;
+    np->prix_unitaire = prix_unitaire;
+    np->date_peremption = date_peremption;
+    return np;
+}
+
+static Produit* modifier(Produit* produit, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note) {
     /*
     Argument:
         produit: Pointeur vers le produit à modifier
         nom, description, categorie, note: Nouvelles données textuelles
         quantite, prix_unitaire, date_peremption: Nouvelles données numériques
     But:
-        Modifier les informations d'un produit existant 
+        Modifier les informations d'un produit existant et recalculer la clé de
+        recherche du nom. Une chaîne qui n'est pas plus longue que l'ancienne est
+        réécrite sur place, sinon les quatre chaînes sont recopiées dans une
+        nouvelle zone de l'arène et l'ancienne est rendue. Une nouvelle
+        catégorie est internée et le produit change de liste
     Retour:
         Pointeur vers le produit modifié, ou NULL en cas d'erreur
     */
 
     // Phase de vérification 
     if (produit == NULL) return NULL;
-    if (strlen(nom) > 64 || strlen(description) > 1024) return NULL;
     if (quantite < 0 || prix_unitaire < 0) {
         return NULL; 
     }
+    if (strlen(nom) > 64) return NULL;
+    char cle[65];
+    const char* sources[NB_CHAINES] = {nom, description, note, cle};
+    char** champs[NB_CHAINES] = {&produit->nom, &produit->description, &produit->note, &produit->cle_nom};
+    size_t longueurs[NB_CHAINES];
+    size_t total = 0;
+    bool en_place = true;
+    longueurs[CHAINE_CLE] = cle_normaliser(nom, cle);
+    for (int i = 0; i < NB_CHAINES; i++) {
+        if (i != CHAINE_CLE) longueurs[i] = strlen(sources[i]);
+        total += longueurs[i] + 1;
+        if (*champs[i] == NULL || longueurs[i] > strlen(*champs[i])) en_place = false;
+    }
+    if (longueurs[1] > 1024) return NULL;
 
-    // Allocation temporaire pour garantir l'ancien produit
-    char* temp_nom = (char*)malloc((strlen(nom) + 1) * sizeof(char));
-    char* temp_desc = (char*)malloc((strlen(description) + 1) * sizeof(char));
-    char* temp_cat = (char*)malloc((strlen(categorie) + 1) * sizeof(char));
-    char* temp_note = (char*)malloc((strlen(note) + 1) * sizeof(char));
-
-    if (!temp_nom || !temp_desc || !temp_cat || !temp_note) {
-        free(temp_nom);
-        free(temp_desc);
-        free(temp_cat);
-        free(temp_note);
-        return NULL;
+    // Nouvelle zone pour les quatre champs, l'ancienne reste intacte en cas d'échec
+    char* zone = NULL;
+    if (!en_place) {
+        zone = memoire_chaines(total);
+        if (zone == NULL) return NULL;
+    }
+    char* libelle = produit->categorie;
+    uint32_t id_categorie = produit->id_categorie;
+    if (produit->categorie == NULL || strcmp(produit->categorie, categorie) != 0) {
+        id_categorie = categories_interner(categorie, &libelle);
+        if (id_categorie == 0) {
+            memoire_rendre_chaines(zone, total); // zone NULL si réécriture en place
+            return NULL;
+        }
     }
 
-    snprintf(temp_nom, strlen(nom) + 1, "%s", nom);
-    snprintf(temp_desc, strlen(description) + 1, "%s", description);
-    snprintf(temp_cat, strlen(categorie) + 1, "%s", categorie);
-    snprintf(temp_note, strlen(note) + 1, "%s", note);
+    // L'index des noms doit retirer les trigrammes de l'ancien nom avant sa réécriture
+    bool indexe = (index_id_chercher(produit->id) == produit);
+    bool nom_change = (produit->nom == NULL || strcmp(produit->nom, nom) != 0);
+    if (indexe && nom_change) {
+        index_nom_retirer(produit);
+    }
 
-    // Phase de remplacement (libération ancienne mémoire)
-    free(produit->nom);
-    free(produit->description);
-    free(produit->categorie);
-    free(produit->note);
+    if (en_place) {
+        // Chaque nouvelle valeur tient dans l'ancienne : aucune allocation
+        for (int i = 0; i < NB_CHAINES; i++) {
+            memmove(*champs[i], sources[i], longueurs[i] + 1);
+        }
+    } else {
+        char* copies[NB_CHAINES];
+        copier_champs(zone, sources, longueurs, copies);
+        for (int i = 0; i < NB_CHAINES; i++) {
+            *champs[i] = copies[i];
+        }
+        // Les sources ont pu être les anciennes chaînes : rendues après la copie
+        memoire_rendre_chaines(produit->zone, produit->taille_zone);
+        produit->zone = zone;
+        produit->taille_zone = total;
+    }
+    produit->longueur_cle = (uint32_t)longueurs[CHAINE_CLE];
 
-    produit->nom = temp_nom;
-    produit->description = temp_desc;
-    produit->categorie = temp_cat;
-    produit->note = temp_note;
+    bool categorie_change = (id_categorie != produit->id_categorie);
+    if (indexe && categorie_change) {
+        categories_retirer(produit);
+    }
+    produit->categorie = libelle;
+    produit->id_categorie = id_categorie;
 
+    // Les vues triées et les agrégats de la catégorie partent des anciennes valeurs
+    if (indexe) {
+        index_tri_retirer(produit);
+        if (!categorie_change) categories_mettre_a_jour(produit, quantite, prix_unitaire);
+    }
     produit->quantite = quantite;
     produit->prix_unitaire = prix_unitaire;
     produit->date_peremption = date_peremption;
+
+    // Replanification et journal seulement si le produit fait partie de l'inventaire
+    if (indexe) {
+        if (echeancier_planifier(produit) != 0) {
+            fprintf(stderr, "[!] Erreur : Echec allocation de l'echeancier, le produit %u ne sera pas retire a sa peremption.\n", produit->id);
+        }
+        colonnes_mettre_a_jour(produit);
+        if (categorie_change && categories_ajouter(produit) != 0) {
+            fprintf(stderr, "[!] Erreur : Echec allocation de l'index des categories, le produit %u n'apparaitra pas dans sa categorie.\n", produit->id);
+        }
+        if (nom_change && index_nom_ajouter(produit) != 0) {
+            fprintf(stderr, "[!] Erreur : Echec allocation de l'index des noms, le produit %u ne sera pas trouve par la recherche.\n", produit->id);
+        }
+        if (index_tri_ajouter(produit) != 0) {
+            fprintf(stderr, "[!] Erreur : Echec allocation des vues triees, le produit %u n'y apparaitra pas.\n", produit->id);
+        }
+        if (journalisation_active) {
+            journal_ops_modification(produit);
+        }
+    }
     
-    ajouter_log("[~] Modification du produit ID %u (Nouveau Nom: %s)", produit->id, produit->nom);
+    ajouter_log(HISTORIQUE_MODIFICATION, produit->id, 0, produit->nom);
 
     return produit;
 }
 
+Produit* modifier_produit(Produit* produit, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note) {
+    /*
+    Argument:
+        produit, nom, description, categorie, note, quantite, prix_unitaire,
+        date_peremption: Voir modifier
+    But:
+        Modifier le produit (voir modifier) en mesurant la durée de la modification
+    Retour:
+        Pointeur vers le produit modifié, ou NULL en cas d'erreur
+    */
+    STATS_DEBUT(debut);
+    Produit* res = modifier(produit, nom, description, categorie, quantite, prix_unitaire, date_peremption, note);
+    STATS_FIN(STATS_MODIFICATION, debut);
+    return res;
+}
+
 Produit* free_struct_produit(Produit* head) {
     /*
     Argument:
         head: Pointeur vers le premier élément de la liste
     But:
-        Libérer toute la mémoire de la liste (structure + champs dynamiques) pour éviter les fuites
+        Libérer toute la mémoire de l'inventaire (structure + champs dynamiques) pour éviter les fuites.
+        Tous les produits viennent de la réserve mémoire : elle est rendue en bloc,
+        sans parcourir la liste
     Retour:
         NULL (Pour réinitialiser le pointeur de tête)
     */
-    Produit* actu = head;
-    Produit* temp_suivant = NULL;
-
-    while (actu != NULL) {
-        temp_suivant = actu->suivant; // On "sauve" l'addresse pour continuer la suppression
-
-        free(actu->nom);
-        free(actu->description);
-        free(actu->categorie);
-        free(actu->note);
-
-        free(actu);
-
-        actu = temp_suivant;
-    }
+    (void)head;
+    memoire_liberer_tout();
+    index_id_liberer();
+    echeancier_liberer();
+    colonnes_liberer();
+    index_nom_liberer();
+    categories_liberer();
+    index_tri_liberer();
 
     return NULL; 
 }
@@ -2,40 +2,108 @@
 #define _GESTION_PRODUIT_H
 
 #include <stdint.h> 
+#include <stddef.h>
 #include <time.h>
+#include <stdbool.h>
 #include <stdarg.h> // Nécessaire si on expose des variadiques, sinon pour le prototype simple c'est optionnel
 
+#include "historique.h"
+
 /*
     Description de la structure Produit :
     - id : Identifiant unique (uint32_t).
     - nom : Chaîne allouée dynamiquement (max 64 chars).
+    - cle_nom : Nom normalisé pour la recherche (cle_recherche.c), de longueur longueur_cle.
+    - Le nœud vient de la réserve mémoire (memoire.c) et les quatre autres
+      chaînes de son arène : ne jamais les passer à free.
+    - zone, taille_zone : Zone de l'arène dont le produit est propriétaire
+      (ses chaînes, ou seulement cle_nom pour un produit adopté), rendue à la
+      réserve quand le produit est libéré ou que ses chaînes déménagent.
     - description : Description libre (max 1024 chars).
-    - categorie : Type de produit (potion, etc.).
+    - categorie : Type de produit (potion, etc.), libellé partagé de la table
+      des catégories (categories.c), d'ID id_categorie.
     - quantite : Stock disponible.
     - prix_unitaire : Prix en flottant.
     - date_peremption : Timestamp (0 si non applicable).
     - note : Commentaire libre.
     - suivant : Pointeur vers le maillon suivant.
+    - precedent : Pointeur vers le maillon précédent (retrait en O(1) via l'index d'ID).
+    - rang_peremption : Position dans l'échéancier des péremptions (0 si absent).
+    - rang_colonne : Position dans le stockage en colonnes (0 si absent).
+    - rang_categorie : Position dans la liste de sa catégorie (0 si absent).
 */
 typedef struct Produit {
     uint32_t id;              
     char *nom;
+    char *cle_nom;
+    uint32_t longueur_cle;
+    char *zone;
+    size_t taille_zone;
     char *description;  
     char *categorie;       
+    uint32_t id_categorie;
     int quantite;            
     float prix_unitaire;    
     char *note;  
     time_t date_peremption;
     struct Produit *suivant;  
+    struct Produit *precedent;
+    size_t rang_peremption;
+    size_t rang_colonne;
+    size_t rang_categorie;
 } Produit;
 
+/*
+    Lot de produits construit par un chargement en masse :
+    - Chaîne dans l'ordre d'ajout (premier -> dernier).
+    - Les ID sont indexés au fur et à mesure pour détecter les doublons.
+    - Rien n'est journalisé avant insertion_lot.
+    - inverser : raccorder le lot du dernier au premier, comme l'auraient fait
+      des insertions une par une (reprise du journal des opérations).
+*/
+typedef struct {
+    Produit* premier;
+    Produit* dernier;
+    size_t nombre;
+    uint32_t max_id;
+    bool inverser;
+} LotProduits;
+
+/*
+    Accès concurrent à l'inventaire (liste, index, échéancier, colonnes,
+    catégories) :
+    - Les fonctions ci-dessous ne verrouillent rien elles-mêmes : un programme
+      qui partage l'inventaire entre threads encadre chaque opération par
+      inventaire_verrouiller_lecture ou inventaire_verrouiller_ecriture, puis
+      inventaire_deverrouiller.
+    - Lecture : rechercher_par_id, index_id_chercher, index_nom_rechercher,
+      parcours de la liste ou d'une catégorie, agrégats des colonnes,
+      affichage. Plusieurs lecteurs avancent ensemble.
+    - Écriture : tout le reste, y compris creer_produit et adopter_produit
+      (ils internent la catégorie) et supprimer_perimes. Les threads de
+      chargement de gestion_db travaillent sous l'écriture de l'appelant.
+    - Un Produit* obtenu sous le verrou ne doit plus être lu après
+      inventaire_deverrouiller : une écriture peut le libérer et la réserve
+      mémoire réutiliser son nœud.
+*/
+void inventaire_verrouiller_lecture(void);
+void inventaire_verrouiller_ecriture(void);
+void inventaire_deverrouiller(void);
+
 Produit* modifier_produit(Produit* produit, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note);
 Produit* creer_produit(uint32_t id, const char* nom, const char* description, const char* categorie, int quantite, float prix_unitaire, time_t date_peremption, const char* note);
+Produit* adopter_produit(uint32_t id, char* nom, char* description, char* categorie, int quantite, float prix_unitaire, time_t date_peremption, char* note);
 int suppression_par_id(Produit** head, uint32_t id);
 int insertion(Produit** head, Produit* nouveau_produit);
+void lot_initialiser(LotProduits* lot);
+int lot_ajouter(LotProduits* lot, Produit* produit);
+int insertion_lot(Produit** head, LotProduits* lot);
 int affichage(Produit** head);
 Produit* rechercher_par_id(Produit* head, uint32_t id);
+size_t supprimer_perimes(Produit** head, time_t maintenant, bool afficher);
 Produit* free_struct_produit(Produit* head);
-void ajouter_log(const char *format, ...);
+void liberer_produit(Produit* produit);
+void ajouter_log(TypeHistorique type, uint64_t id, int64_t quantite, const char* texte);
+void activer_journalisation(bool active);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,347 @@
+/*
+Nom du fichier : historique.c
+Fait par : Erwann GIRAULT
+But : Encodage binaire des événements de l'historique et lecteur en flux :
+      filtre par produit ou par période et rendu au format texte
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "historique.h"
+#include "rendu.h"
+#include "stats.h"
+
+#define TAILLE_SORTIE (256 * 1024)
+#define TAILLE_LIGNE (TAILLE_MAX_TEXTE_HISTORIQUE + 128)
+#define TAILLE_CHEMIN 4096
+
+static unsigned char* ecrire_varint(unsigned char* p, uint64_t valeur) {
+    /*
+    Argument:
+        p: Position d'écriture (10 octets au plus)
+        valeur: Entier à encoder
+    But:
+        Encodage LEB128 : 7 bits par octet, bit de poids fort = octet suivant
+    Retour:
+        Position après l'entier
+    */
+    while (valeur >= 0x80) {
+        *p++ = (unsigned char)(valeur | 0x80);
+        valeur >>= 7;
+    }
+    *p++ = (unsigned char)valeur;
+    return p;
+}
+
+static bool lire_varint(const unsigned char** p, const unsigned char* fin, uint64_t* valeur) {
+    /*
+    Argument:
+        p: Position de lecture, avancée après l'entier
+        fin: Fin de la zone lisible
+        valeur: Entier décodé
+    But:
+        Décoder un entier LEB128 sans dépasser fin
+    Retour:
+        false si l'entier est incomplet ou trop long
+    */
+    uint64_t resultat = 0;
+    for (unsigned int decalage = 0; decalage < 64 && *p < fin; decalage += 7) {
+        unsigned char octet = *(*p)++;
+        resultat |= (uint64_t)(octet & 0x7F) << decalage;
+        if ((octet & 0x80) == 0) {
+            *valeur = resultat;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t historique_encoder(const EvenementHistorique* evenement, unsigned char* tampon) {
+    /*
+    Argument:
+        evenement: Événement à enregistrer
+        tampon: Au moins TAILLE_MAX_EVENEMENT octets
+    But:
+        Encoder l'enregistrement complet, longueur en tête
+    Retour:
+        Taille de l'enregistrement
+    */
+    size_t longueur_texte = evenement->longueur_texte;
+    if (longueur_texte > TAILLE_MAX_TEXTE_HISTORIQUE) longueur_texte = TAILLE_MAX_TEXTE_HISTORIQUE;
+
+    unsigned char corps[48]; // type + 4 varints de 10 octets au plus
+    unsigned char* p = corps;
+    *p++ = (unsigned char)evenement->type;
+    p = ecrire_varint(p, (uint64_t)evenement->date);
+    p = ecrire_varint(p, evenement->id);
+    p = ecrire_varint(p, ((uint64_t)evenement->quantite << 1) ^ (uint64_t)(evenement->quantite >> 63)); // zigzag
+    p = ecrire_varint(p, longueur_texte);
+    size_t taille_corps = (size_t)(p - corps);
+
+    unsigned char* q = ecrire_varint(tampon, taille_corps + longueur_texte);
+    memcpy(q, corps, taille_corps);
+    q += taille_corps;
+    memcpy(q, evenement->texte, longueur_texte);
+    return (size_t)(q - tampon) + longueur_texte;
+}
+
+size_t historique_decoder(const unsigned char* donnees, size_t taille, EvenementHistorique* evenement) {
+    /*
+    Argument:
+        donnees: Début d'un enregistrement
+        taille: Octets disponibles
+        evenement: Événement décodé (le texte pointe dans donnees)
+    But:
+        Décoder un enregistrement. Un enregistrement illisible mais complet
+        (type inconnu, champs incohérents) reçoit le type 0 et est sauté
+    Retour:
+        Taille de l'enregistrement, ou 0 s'il est incomplet (fin du fichier
+        pendant une écriture)
+    */
+    const unsigned char* p = donnees;
+    const unsigned char* fin = donnees + taille;
+    uint64_t longueur;
+    if (!lire_varint(&p, fin, &longueur) || longueur > (uint64_t)(fin - p)) return 0;
+    fin = p + longueur;
+    size_t consommes = (size_t)(fin - donnees);
+
+    evenement->type = 0;
+    if (p == fin) return consommes;
+    unsigned char type = *p++;
+    uint64_t date, id, zigzag, longueur_texte;
+    if (!lire_varint(&p, fin, &date) || !lire_varint(&p, fin, &id) || !lire_varint(&p, fin, &zigzag)
+        || !lire_varint(&p, fin, &longueur_texte) || longueur_texte > (uint64_t)(fin - p)) {
+        return consommes;
+    }
+    if (type < HISTORIQUE_AJOUT || type > HISTORIQUE_REPRISE) return consommes;
+
+    evenement->type = (TypeHistorique)type;
+    evenement->date = (time_t)date;
+    evenement->id = id;
+    evenement->quantite = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    evenement->texte = (const char*)p;
+    evenement->longueur_texte = (size_t)longueur_texte;
+    return consommes;
+}
+
+void historique_entete(unsigned char entete[TAILLE_ENTETE_HISTORIQUE]) {
+    /*
+    Argument:
+        entete: En-tête à remplir
+    But:
+        Préparer l'en-tête d'un nouveau fichier d'historique
+    Retour:
+        Aucun
+    */
+    uint32_t version = VERSION_HISTORIQUE;
+    uint32_t reserve = 0;
+    memcpy(entete, MAGIE_HISTORIQUE, 8);
+    memcpy(entete + 8, &version, 4);
+    memcpy(entete + 12, &reserve, 4);
+}
+
+size_t historique_formater(const EvenementHistorique* evenement, char* ligne, size_t taille) {
+    /*
+    Argument:
+        evenement: Événement décodé
+        ligne: Tampon de sortie
+        taille: Taille du tampon
+    But:
+        Rendre l'événement comme une ligne de l'ancien historique.log :
+        "[date au format ctime] message\n"
+    Retour:
+        Longueur écrite (tronquée à taille - 1)
+    */
+    char date[TAILLE_DATE_RENDU];
+    rendu_date(evenement->date, date);
+    int texte = (int)evenement->longueur_texte;
+    unsigned long long id = (unsigned long long)evenement->id;
+    int n;
+    switch (evenement->type) {
+        case HISTORIQUE_AJOUT:
+            n = snprintf(ligne, taille, "[%s] [+] Ajout du produit ID %llu : %.*s (Qte: %lld)\n",
+                         date, id, texte, evenement->texte, (long long)evenement->quantite);
+            break;
+        case HISTORIQUE_SUPPRESSION:
+            n = snprintf(ligne, taille, "[%s] [-] Suppression du produit ID %llu : %.*s\n", date, id, texte, evenement->texte);
+            break;
+        case HISTORIQUE_MODIFICATION:
+            n = snprintf(ligne, taille, "[%s] [~] Modification du produit ID %llu (Nouveau Nom: %.*s)\n", date, id, texte, evenement->texte);
+            break;
+        case HISTORIQUE_CHARGEMENT:
+            n = snprintf(ligne, taille, "[%s] [+] Chargement de %llu produits depuis %.*s\n", date, id, texte, evenement->texte);
+            break;
+        case HISTORIQUE_CHARGEMENT_INSTANTANE:
+            n = snprintf(ligne, taille, "[%s] [+] Chargement de %llu produits depuis l'instantané %.*s\n", date, id, texte, evenement->texte);
+            break;
+        case HISTORIQUE_REPRISE:
+            n = snprintf(ligne, taille, "[%s] [~] Reprise de %llu operations non sauvegardees depuis %.*s\n", date, id, texte, evenement->texte);
+            break;
+        default:
+            n = 0;
+            ligne[0] = '\0';
+    }
+    if (n < 0) return 0;
+    return ((size_t)n < taille) ? (size_t)n : taille - 1;
+}
+
+int historique_date_depuis_chaine(const char* texte, time_t* date) {
+    /*
+    Argument:
+        texte: Date epoch ("1760000000") ou locale ("AAAA-MM-JJ" ou
+               "AAAA-MM-JJ HH:MM:SS", 'T' accepté à la place de l'espace)
+        date: Date convertie
+    But:
+        Lire une borne de période pour le lecteur d'historique
+    Retour:
+        0 si le texte est valide, -1 sinon
+    */
+    char* fin;
+    errno = 0;
+    long long epoch = strtoll(texte, &fin, 10);
+    if (fin != texte && *fin == '\0') {
+        if (errno != 0 || epoch < 0) return -1;
+        *date = (time_t)epoch;
+        return 0;
+    }
+
+    struct tm tm_local;
+    memset(&tm_local, 0, sizeof(tm_local));
+    int lus = 0;
+    if (sscanf(texte, "%d-%d-%d%n", &tm_local.tm_year, &tm_local.tm_mon, &tm_local.tm_mday, &lus) != 3) return -1;
+    const char* reste = texte + lus;
+    if (*reste == ' ' || *reste == 'T') {
+        int lus_heure = 0;
+        if (sscanf(reste + 1, "%d:%d:%d%n", &tm_local.tm_hour, &tm_local.tm_min, &tm_local.tm_sec, &lus_heure) != 3) return -1;
+        reste += 1 + lus_heure;
+    }
+    if (*reste != '\0' || tm_local.tm_mon < 1 || tm_local.tm_mon > 12 || tm_local.tm_mday < 1 || tm_local.tm_mday > 31) return -1;
+    tm_local.tm_year -= 1900;
+    tm_local.tm_mon -= 1;
+    tm_local.tm_isdst = -1;
+    time_t resultat = mktime(&tm_local);
+    if (resultat == (time_t)-1) return -1;
+    *date = resultat;
+    return 0;
+}
+
+static bool retenir(const EvenementHistorique* evenement, const FiltreHistorique* filtre) {
+    /*
+    Argument:
+        evenement: Événement décodé
+        filtre: Produit et période demandés
+    But:
+        Appliquer le filtre. Le filtre par produit ne garde que les ajouts,
+        suppressions et modifications de ce produit
+    Retour:
+        true si l'événement doit être rendu
+    */
+    if (evenement->type == 0) return false;
+    if (filtre->debut != 0 && evenement->date < filtre->debut) return false;
+    if (filtre->fin != 0 && evenement->date >= filtre->fin) return false;
+    if (filtre->id != 0) {
+        bool produit = (evenement->type == HISTORIQUE_AJOUT || evenement->type == HISTORIQUE_SUPPRESSION
+                        || evenement->type == HISTORIQUE_MODIFICATION);
+        if (!produit || evenement->id != filtre->id) return false;
+    }
+    return true;
+}
+
+static int lire_fichier(const char* chemin, const FiltreHistorique* filtre, FILE* sortie, char* tampon,
+                        size_t* utilise, size_t* nb_lus, size_t* nb_rendus) {
+    /*
+    Argument:
+        chemin: Fichier d'historique (courant ou archive)
+        filtre: Produit et période demandés
+        sortie, tampon, utilise: Flux de sortie et tampon de rendu partagé
+        nb_lus, nb_rendus: Compteurs d'événements, complétés
+    But:
+        Projeter le fichier en mémoire et rendre ses événements retenus
+    Retour:
+        0 si le fichier a été lu, -1 s'il n'existe pas ou n'est pas un historique
+    */
+    int fd = open(chemin, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat infos;
+    if (fstat(fd, &infos) != 0 || (size_t)infos.st_size < TAILLE_ENTETE_HISTORIQUE) {
+        close(fd);
+        return -1;
+    }
+    size_t taille = (size_t)infos.st_size;
+    unsigned char* donnees = (unsigned char*)mmap(NULL, taille, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (donnees == MAP_FAILED) return -1;
+    posix_madvise(donnees, taille, POSIX_MADV_SEQUENTIAL);
+
+    if (memcmp(donnees, MAGIE_HISTORIQUE, 8) != 0) {
+        fprintf(stderr, "[!] %s n'est pas un historique BGRS, ignore.\n", chemin);
+        munmap(donnees, taille);
+        return -1;
+    }
+    STATS_OCTETS_LUS(taille);
+
+    size_t position = TAILLE_ENTETE_HISTORIQUE;
+    while (position < taille) {
+        EvenementHistorique evenement;
+        size_t consommes = historique_decoder(donnees + position, taille - position, &evenement);
+        if (consommes == 0) break; // enregistrement coupé par un arrêt brutal
+        position += consommes;
+        (*nb_lus)++;
+        if (!retenir(&evenement, filtre)) continue;
+
+        if (TAILLE_SORTIE - *utilise < TAILLE_LIGNE) {
+            fwrite(tampon, 1, *utilise, sortie);
+            *utilise = 0;
+        }
+        *utilise += historique_formater(&evenement, tampon + *utilise, TAILLE_LIGNE);
+        (*nb_rendus)++;
+    }
+    munmap(donnees, taille);
+    return 0;
+}
+
+int historique_lire(const char* chemin, const FiltreHistorique* filtre, FILE* sortie, size_t* nb_lus, size_t* nb_rendus) {
+    /*
+    Argument:
+        chemin: Fichier d'historique courant (ses archives sont chemin.1 à chemin.N)
+        filtre: Produit et période demandés
+        sortie: Flux de sortie du texte
+        nb_lus, nb_rendus: Nombre d'événements décodés et rendus
+    But:
+        Parcourir les archives de la plus ancienne à la plus récente puis le
+        fichier courant, et rendre les événements retenus au format texte
+    Retour:
+        0 si au moins un fichier a été lu, -1 sinon
+    */
+    *nb_lus = 0;
+    *nb_rendus = 0;
+    char* tampon = (char*)malloc(TAILLE_SORTIE);
+    if (tampon == NULL) return -1;
+    size_t utilise = 0;
+    bool trouve = false;
+
+    for (int i = NB_ARCHIVES_HISTORIQUE; i >= 0; i--) {
+        char nom[TAILLE_CHEMIN];
+        if (i > 0) {
+            if (snprintf(nom, sizeof(nom), "%s.%d", chemin, i) >= (int)sizeof(nom)) continue;
+        } else {
+            snprintf(nom, sizeof(nom), "%s", chemin);
+        }
+        if (lire_fichier(nom, filtre, sortie, tampon, &utilise, nb_lus, nb_rendus) == 0) trouve = true;
+    }
+    fwrite(tampon, 1, utilise, sortie);
+    free(tampon);
+    return trouve ? 0 : -1;
+}
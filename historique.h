@@ -0,0 +1,62 @@
+#ifndef _HISTORIQUE_H
+#define _HISTORIQUE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+/*
+    Format binaire de l'historique des actions (historique.bin) :
+    - En-tête de fichier : "BGRSHIST", version (u32), réservé (u32).
+    - Un événement par enregistrement : longueur du reste (varint), type
+      (u8), date epoch (varint), ID du produit ou nombre de produits
+      (varint), quantité (varint zigzag), texte (longueur varint + octets,
+      sans '\0'). Un lecteur saute les champs ou les types qu'il ne connaît
+      pas grâce à la longueur.
+    - Le fichier courant est archivé en historique.bin.1 (puis .2 ...) quand
+      il dépasse la taille de rotation : voir journal.h.
+    - historique_lire parcourt les archives de la plus ancienne au fichier
+      courant, filtre par produit et par période, et rend chaque événement
+      dans le format texte de l'ancien historique.log.
+*/
+
+#define MAGIE_HISTORIQUE "BGRSHIST"
+#define VERSION_HISTORIQUE 1
+#define TAILLE_ENTETE_HISTORIQUE 16
+#define TAILLE_MAX_TEXTE_HISTORIQUE 4096 // les textes plus longs sont tronqués
+#define TAILLE_MAX_EVENEMENT (TAILLE_MAX_TEXTE_HISTORIQUE + 64)
+#define NB_ARCHIVES_HISTORIQUE 9
+
+typedef enum {
+    HISTORIQUE_AJOUT = 1,
+    HISTORIQUE_SUPPRESSION,
+    HISTORIQUE_MODIFICATION,
+    HISTORIQUE_CHARGEMENT,
+    HISTORIQUE_CHARGEMENT_INSTANTANE,
+    HISTORIQUE_REPRISE
+} TypeHistorique;
+
+typedef struct {
+    TypeHistorique type;
+    time_t date;
+    uint64_t id;          // ID du produit, ou nombre de produits / d'opérations
+    int64_t quantite;     // ajout seulement
+    const char* texte;    // nom du produit ou fichier (pas de '\0' en lecture)
+    size_t longueur_texte;
+} EvenementHistorique;
+
+typedef struct {
+    uint64_t id;          // 0 = tous les événements
+    time_t debut;         // 0 = depuis le début
+    time_t fin;           // exclue ; 0 = jusqu'à la fin
+} FiltreHistorique;
+
+size_t historique_encoder(const EvenementHistorique* evenement, unsigned char* tampon);
+size_t historique_decoder(const unsigned char* donnees, size_t taille, EvenementHistorique* evenement);
+void historique_entete(unsigned char entete[TAILLE_ENTETE_HISTORIQUE]);
+size_t historique_formater(const EvenementHistorique* evenement, char* ligne, size_t taille);
+int historique_date_depuis_chaine(const char* texte, time_t* date);
+int historique_lire(const char* chemin, const FiltreHistorique* filtre, FILE* sortie, size_t* nb_lus, size_t* nb_rendus);
+
+#endif
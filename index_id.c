@@ -0,0 +1,213 @@
+/*
+Nom du fichier : index_id.c
+Fait par : Erwann GIRAULT
+But : Index de hachage sur l'identifiant des produits, pour que la recherche,
+      la suppression et la modification par ID se fassent en temps constant
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "index_id.h"
+
+#define CAPACITE_INITIALE 64 // doit rester une puissance de 2
+
+typedef struct {
+    uint32_t id;       // copie de la clé, évite de déréférencer le produit à chaque sondage
+    Produit* produit;  // NULL = case libre
+} CaseIndex;
+
+static CaseIndex* table = NULL;
+static size_t capacite = 0;
+static unsigned int bits = 0;
+static size_t nb_elements = 0;
+
+static size_t position_ideale(uint32_t id) {
+    /*
+    Argument:
+        id: Identifiant à placer
+    But:
+        Hachage de Fibonacci : on garde les bits de poids fort du produit,
+        ce qui disperse bien les ID consécutifs
+    Retour:
+        Indice de la case de départ du sondage
+    */
+    return (size_t)(((uint64_t)id * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+static int redimensionner(size_t nouvelle_capacite) {
+    /*
+    Argument:
+        nouvelle_capacite: Nombre de cases (puissance de 2)
+    But:
+        Allouer une nouvelle table et y réinsérer tous les éléments
+    Retour:
+        0 si succès, -1 si l'allocation échoue (l'ancienne table reste valide)
+    */
+    CaseIndex* nouvelle = (CaseIndex*)calloc(nouvelle_capacite, sizeof(CaseIndex));
+    if (nouvelle == NULL) return -1;
+
+    CaseIndex* ancienne = table;
+    size_t ancienne_capacite = capacite;
+
+    table = nouvelle;
+    capacite = nouvelle_capacite;
+    bits = 0;
+    while (((size_t)1 << bits) < capacite) bits++;
+
+    for (size_t i = 0; i < ancienne_capacite; i++) {
+        if (ancienne[i].produit == NULL) continue;
+        size_t pos = position_ideale(ancienne[i].id);
+        while (table[pos].produit != NULL) {
+            pos = (pos + 1) & (capacite - 1);
+        }
+        table[pos] = ancienne[i];
+    }
+    free(ancienne);
+    return 0;
+}
+
+int index_id_inserer(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit à référencer
+    But:
+        Ajouter le produit dans l'index (agrandit la table au-delà de 70% de remplissage)
+    Retour:
+        0 si succès, -1 si l'ID est déjà présent ou en cas d'erreur d'allocation
+    */
+    if (produit == NULL) return -1;
+
+    if (capacite == 0 || (nb_elements + 1) * 10 > capacite * 7) {
+        if (redimensionner(capacite == 0 ? CAPACITE_INITIALE : capacite * 2) != 0) {
+            return -1;
+        }
+    }
+
+    size_t pos = position_ideale(produit->id);
+    while (table[pos].produit != NULL) {
+        if (table[pos].id == produit->id) {
+            return -1; // ID en double
+        }
+        pos = (pos + 1) & (capacite - 1);
+    }
+    table[pos].id = produit->id;
+    table[pos].produit = produit;
+    nb_elements++;
+    return 0;
+}
+
+int index_id_reserver(size_t nb_elements_prevus) {
+    /*
+    Argument:
+        nb_elements_prevus: Nombre total d'éléments attendus (chargement en masse)
+    But:
+        Agrandir la table une seule fois avant une série d'insertions,
+        plutôt que de la redimensionner plusieurs fois en cours de route
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    size_t nouvelle_capacite = (capacite == 0) ? CAPACITE_INITIALE : capacite;
+    while (nb_elements_prevus * 10 > nouvelle_capacite * 7) nouvelle_capacite *= 2;
+    if (nouvelle_capacite == capacite) return 0;
+    return redimensionner(nouvelle_capacite);
+}
+
+static CaseIndex* trouver_case(uint32_t id) {
+    /*
+    Argument:
+        id: Identifiant recherché
+    But:
+        Sonder la table à partir de la position idéale jusqu'à une case libre
+    Retour:
+        Pointeur vers la case contenant l'ID, ou NULL si absent
+    */
+    if (capacite == 0) return NULL;
+
+    size_t pos = position_ideale(id);
+    while (table[pos].produit != NULL) {
+        if (table[pos].id == id) {
+            return &table[pos];
+        }
+        pos = (pos + 1) & (capacite - 1);
+    }
+    return NULL;
+}
+
+Produit* index_id_chercher(uint32_t id) {
+    /*
+    Argument:
+        id: Identifiant recherché
+    But:
+        Retrouver un produit par son ID sans parcourir la liste
+    Retour:
+        Pointeur vers le produit, ou NULL si absent
+    */
+    CaseIndex* c = trouver_case(id);
+    return (c != NULL) ? c->produit : NULL;
+}
+
+int index_id_retirer(uint32_t id) {
+    /*
+    Argument:
+        id: Identifiant à retirer
+    But:
+        Vider la case de l'ID puis recaler les éléments suivants de la même
+        grappe pour qu'aucun sondage ne s'arrête trop tôt
+    Retour:
+        0 si l'ID a été retiré, -1 s'il était absent
+    */
+    CaseIndex* c = trouver_case(id);
+    if (c == NULL) return -1;
+
+    size_t masque = capacite - 1;
+    size_t trou = (size_t)(c - table);
+    size_t j = trou;
+
+    while (1) {
+        j = (j + 1) & masque;
+        if (table[j].produit == NULL) break;
+
+        size_t ideal = position_ideale(table[j].id);
+        // L'élément j peut combler le trou si sa position idéale n'est pas
+        // comprise (circulairement) dans l'intervalle ]trou, j]
+        if (((j - ideal) & masque) >= ((j - trou) & masque)) {
+            table[trou] = table[j];
+            trou = j;
+        }
+    }
+    table[trou].produit = NULL;
+    table[trou].id = 0;
+    nb_elements--;
+    return 0;
+}
+
+size_t index_id_taille(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Connaître le nombre de produits indexés
+    Retour:
+        Nombre d'éléments dans l'index
+    */
+    return nb_elements;
+}
+
+void index_id_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer la table (appelé quand toute la liste est libérée)
+    Retour:
+        Aucun
+    */
+    free(table);
+    table = NULL;
+    capacite = 0;
+    bits = 0;
+    nb_elements = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef _INDEX_ID_H
+#define _INDEX_ID_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Index de hachage (adressage ouvert, sondage linéaire) sur Produit.id.
+    - Une seule instance par processus : l'inventaire du BGRS.
+    - Maintenu par insertion, suppression_par_id et free_struct_produit.
+    - Les suppressions décalent les cases suivantes (pas de pierre tombale),
+      la longueur des sondages reste donc stable dans le temps.
+*/
+
+int index_id_inserer(Produit* produit);
+int index_id_reserver(size_t nb_elements_prevus);
+Produit* index_id_chercher(uint32_t id);
+int index_id_retirer(uint32_t id);
+size_t index_id_taille(void);
+void index_id_liberer(void);
+
+#endif
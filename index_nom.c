@@ -0,0 +1,553 @@
+/*
+Nom du fichier : index_nom.c
+Fait par : Erwann GIRAULT
+But : Index inversé des trigrammes des noms, pour que la recherche par sous-chaîne
+      ne vérifie que quelques candidats au lieu de parcourir tout l'inventaire
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "index_nom.h"
+#include "index_id.h"
+#include "colonnes.h"
+#include "cle_recherche.h"
+#include "stats.h"
+
+#define CAPACITE_INITIALE 1024 // doit rester une puissance de 2
+#define TRIGRAMMES_LOCAUX 64   // un nom de 64 caractères a au plus 62 trigrammes
+
+typedef struct {
+    uint32_t trigramme;  // 0 = case libre (un trigramme ne contient jamais '\0')
+    uint32_t taille;
+    uint32_t capacite;
+    bool trie;           // false pendant un chargement en lot
+    uint32_t* ids;
+} ListeTrigramme;
+
+static ListeTrigramme* table = NULL;
+static size_t capacite = 0;
+static unsigned int bits = 0;
+static size_t nb_listes = 0;
+
+static int extraire_trigrammes(const char* texte, uint32_t* local, uint32_t** trigrammes, size_t* nb_distincts) {
+    /*
+    Argument:
+        texte: Clé de recherche (nom ou motif déjà normalisé)
+        local: Tableau de TRIGRAMMES_LOCAUX cases, utilisé si le texte est court
+        trigrammes: Tableau résultat (local, ou alloué si le texte est plus long)
+        nb_distincts: Nombre de trigrammes (0 si le texte fait moins de 3 caractères)
+    But:
+        Calculer les trigrammes distincts de la clé, triés
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    size_t longueur = strlen(texte);
+    *trigrammes = local;
+    *nb_distincts = 0;
+    if (longueur < 3) return 0;
+
+    size_t nb = longueur - 2;
+    if (nb > TRIGRAMMES_LOCAUX) {
+        *trigrammes = (uint32_t*)malloc(nb * sizeof(uint32_t));
+        if (*trigrammes == NULL) {
+            *trigrammes = local;
+            return -1;
+        }
+    }
+    uint32_t* t = *trigrammes;
+    const unsigned char* octets = (const unsigned char*)texte;
+    uint32_t cle = ((uint32_t)octets[0] << 8) | octets[1];
+    for (size_t i = 0; i < nb; i++) {
+        cle = ((cle << 8) | octets[i + 2]) & 0xFFFFFF;
+        t[i] = cle;
+    }
+
+    // Tri par insertion (quelques dizaines d'éléments) puis suppression des doublons
+    for (size_t i = 1; i < nb; i++) {
+        uint32_t v = t[i];
+        size_t j = i;
+        while (j > 0 && t[j - 1] > v) {
+            t[j] = t[j - 1];
+            j--;
+        }
+        t[j] = v;
+    }
+    size_t distincts = 1;
+    for (size_t i = 1; i < nb; i++) {
+        if (t[i] != t[distincts - 1]) t[distincts++] = t[i];
+    }
+    *nb_distincts = distincts;
+    return 0;
+}
+
+static size_t position_ideale(uint32_t trigramme) {
+    /*
+    Argument:
+        trigramme: Clé à placer
+    But:
+        Hachage de Fibonacci, comme l'index d'ID
+    Retour:
+        Indice de la case de départ du sondage
+    */
+    return (size_t)(((uint64_t)trigramme * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+static int redimensionner(size_t nouvelle_capacite) {
+    /*
+    Argument:
+        nouvelle_capacite: Nombre de cases (puissance de 2)
+    But:
+        Allouer une nouvelle table et y replacer toutes les listes
+    Retour:
+        0 si succès, -1 si l'allocation échoue (l'ancienne table reste valide)
+    */
+    ListeTrigramme* nouvelle = (ListeTrigramme*)calloc(nouvelle_capacite, sizeof(ListeTrigramme));
+    if (nouvelle == NULL) return -1;
+
+    ListeTrigramme* ancienne = table;
+    size_t ancienne_capacite = capacite;
+    table = nouvelle;
+    capacite = nouvelle_capacite;
+    bits = 0;
+    while (((size_t)1 << bits) < capacite) bits++;
+
+    for (size_t i = 0; i < ancienne_capacite; i++) {
+        if (ancienne[i].trigramme == 0) continue;
+        size_t pos = position_ideale(ancienne[i].trigramme);
+        while (table[pos].trigramme != 0) {
+            pos = (pos + 1) & (capacite - 1);
+        }
+        table[pos] = ancienne[i];
+    }
+    free(ancienne);
+    return 0;
+}
+
+static ListeTrigramme* trouver_liste(uint32_t trigramme, bool creer) {
+    /*
+    Argument:
+        trigramme: Clé recherchée
+        creer: true pour créer la liste si elle n'existe pas
+    But:
+        Sonder la table à partir de la position idéale
+    Retour:
+        La liste, ou NULL si absente (ou création impossible)
+    */
+    if (creer && (capacite == 0 || (nb_listes + 1) * 10 > capacite * 7)) {
+        if (redimensionner(capacite == 0 ? CAPACITE_INITIALE : capacite * 2) != 0) return NULL;
+    }
+    if (capacite == 0) return NULL;
+
+    size_t pos = position_ideale(trigramme);
+    while (table[pos].trigramme != 0) {
+        if (table[pos].trigramme == trigramme) return &table[pos];
+        pos = (pos + 1) & (capacite - 1);
+    }
+    if (!creer) return NULL;
+
+    table[pos].trigramme = trigramme;
+    table[pos].trie = true;
+    nb_listes++;
+    return &table[pos];
+}
+
+static size_t borne_inferieure(const uint32_t* ids, size_t debut, size_t fin, uint32_t id) {
+    /*
+    Argument:
+        ids: Liste triée
+        debut, fin: Zone de recherche [debut, fin[
+        id: Valeur cherchée
+    But:
+        Recherche dichotomique de la première case >= id
+    Retour:
+        Indice trouvé (fin si toutes les valeurs sont plus petites)
+    */
+    while (debut < fin) {
+        size_t milieu = debut + (fin - debut) / 2;
+        if (ids[milieu] < id) {
+            debut = milieu + 1;
+        } else {
+            fin = milieu;
+        }
+    }
+    return debut;
+}
+
+static int liste_ajouter(ListeTrigramme* liste, uint32_t id, bool en_lot) {
+    /*
+    Argument:
+        liste: Liste d'un trigramme
+        id: Identifiant à ajouter
+        en_lot: true pour ajouter en fin sans garder l'ordre (trié en fin de lot)
+    But:
+        Ajouter l'ID ; dans le cas courant (ID croissants) c'est un ajout en fin
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (liste->taille == liste->capacite) {
+        uint32_t nouvelle = (liste->capacite == 0) ? 4 : liste->capacite * 2;
+        uint32_t* ids = (uint32_t*)realloc(liste->ids, (size_t)nouvelle * sizeof(uint32_t));
+        if (ids == NULL) return -1;
+        liste->ids = ids;
+        liste->capacite = nouvelle;
+    }
+
+    if (liste->taille == 0 || liste->ids[liste->taille - 1] < id || (en_lot && !liste->trie)) {
+        liste->ids[liste->taille++] = id;
+        return 0;
+    }
+    if (en_lot) {
+        liste->ids[liste->taille++] = id;
+        liste->trie = false;
+        return 0;
+    }
+
+    size_t pos = borne_inferieure(liste->ids, 0, liste->taille, id);
+    if (pos < liste->taille && liste->ids[pos] == id) return 0;
+    memmove(liste->ids + pos + 1, liste->ids + pos, (liste->taille - pos) * sizeof(uint32_t));
+    liste->ids[pos] = id;
+    liste->taille++;
+    return 0;
+}
+
+static int ajouter_produit(const Produit* produit, bool en_lot) {
+    /*
+    Argument:
+        produit: Produit à indexer
+        en_lot: Voir liste_ajouter
+    But:
+        Ajouter l'ID du produit à la liste de chacun des trigrammes de sa clé
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    uint32_t local[TRIGRAMMES_LOCAUX];
+    uint32_t* trigrammes;
+    size_t nb;
+    int res = extraire_trigrammes(produit->cle_nom, local, &trigrammes, &nb);
+    for (size_t i = 0; i < nb && res == 0; i++) {
+        ListeTrigramme* liste = trouver_liste(trigrammes[i], true);
+        if (liste == NULL || liste_ajouter(liste, produit->id, en_lot) != 0) res = -1;
+    }
+    if (trigrammes != local) free(trigrammes);
+    return res;
+}
+
+int index_nom_ajouter(const Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui entre dans l'inventaire (ou dont le nom a changé)
+    But:
+        Indexer les trigrammes de son nom
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (index incomplet, à retirer)
+    */
+    if (produit == NULL || produit->cle_nom == NULL) return -1;
+    return ajouter_produit(produit, false);
+}
+
+static int comparer_ids(const void* a, const void* b) {
+    /*
+    Argument:
+        a, b: Pointeurs vers deux ID
+    But:
+        Ordre croissant pour qsort
+    Retour:
+        Négatif, zéro ou positif
+    */
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+int index_nom_ajouter_lot(const Produit* premier) {
+    /*
+    Argument:
+        premier: Premier produit d'une chaîne terminée par NULL (lot de chargement)
+    But:
+        Ajouter tout le lot en fin de listes, puis trier une seule fois chaque
+        liste touchée (les fichiers sont souvent dans l'ordre des ID décroissants)
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    int res = 0;
+    for (const Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+        if (actu->cle_nom != NULL && ajouter_produit(actu, true) != 0) res = -1;
+    }
+    for (size_t i = 0; i < capacite; i++) {
+        if (table[i].trigramme != 0 && !table[i].trie) {
+            qsort(table[i].ids, table[i].taille, sizeof(uint32_t), comparer_ids);
+            table[i].trie = true;
+        }
+    }
+    return res;
+}
+
+static void supprimer_liste(ListeTrigramme* liste) {
+    /*
+    Argument:
+        liste: Liste devenue vide
+    But:
+        Libérer la liste et vider sa case, puis ramener dans le trou les
+        listes suivantes de la même série de sondage (suppression par
+        décalage arrière : pas de case "supprimée" qui ralentirait le sondage)
+    Retour:
+        Aucun
+    */
+    free(liste->ids);
+    size_t trou = (size_t)(liste - table);
+    size_t pos = trou;
+    while (1) {
+        pos = (pos + 1) & (capacite - 1);
+        if (table[pos].trigramme == 0) break;
+        size_t ideale = position_ideale(table[pos].trigramme);
+        // La liste reste en place si sa position idéale est entre le trou (exclu) et elle
+        bool reste = (trou <= pos) ? (trou < ideale && ideale <= pos) : (trou < ideale || ideale <= pos);
+        if (reste) continue;
+        table[trou] = table[pos];
+        trou = pos;
+    }
+    memset(&table[trou], 0, sizeof(ListeTrigramme));
+    nb_listes--;
+}
+
+void index_nom_retirer(const Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui quitte l'inventaire (ou avant un changement de nom)
+    But:
+        Retirer son ID des listes des trigrammes de sa clé actuelle. Une liste
+        vide est supprimée et une liste peu remplie rend la moitié de sa place :
+        ajouts et suppressions en boucle ne font pas grandir l'index
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || produit->cle_nom == NULL) return;
+    uint32_t local[TRIGRAMMES_LOCAUX];
+    uint32_t* trigrammes;
+    size_t nb;
+    if (extraire_trigrammes(produit->cle_nom, local, &trigrammes, &nb) != 0) return; // clé d'un nom : jamais plus de TRIGRAMMES_LOCAUX
+
+    for (size_t i = 0; i < nb; i++) {
+        ListeTrigramme* liste = trouver_liste(trigrammes[i], false);
+        if (liste == NULL) continue;
+        size_t pos = borne_inferieure(liste->ids, 0, liste->taille, produit->id);
+        if (pos < liste->taille && liste->ids[pos] == produit->id) {
+            memmove(liste->ids + pos, liste->ids + pos + 1, (liste->taille - pos - 1) * sizeof(uint32_t));
+            liste->taille--;
+        }
+        if (liste->taille == 0) {
+            supprimer_liste(liste);
+        } else if (liste->capacite > 16 && liste->taille < liste->capacite / 4) {
+            uint32_t* reduite = (uint32_t*)realloc(liste->ids, (size_t)(liste->capacite / 2) * sizeof(uint32_t));
+            if (reduite != NULL) {
+                liste->ids = reduite;
+                liste->capacite /= 2;
+            }
+        }
+    }
+    if (trigrammes != local) free(trigrammes);
+}
+
+static bool ajouter_resultat(Produit*** resultats, size_t* nb, size_t* cap, Produit* produit) {
+    /*
+    Argument:
+        resultats, nb, cap: Tableau de résultats et sa taille
+        produit: Produit trouvé
+    But:
+        Ajouter un résultat (tableau agrandi au besoin)
+    Retour:
+        false en cas d'erreur d'allocation
+    */
+    if (*nb == *cap) {
+        size_t nouvelle = (*cap == 0) ? 16 : *cap * 2;
+        Produit** agrandi = (Produit**)realloc(*resultats, nouvelle * sizeof(Produit*));
+        if (agrandi == NULL) return false;
+        *resultats = agrandi;
+        *cap = nouvelle;
+    }
+    (*resultats)[(*nb)++] = produit;
+    return true;
+}
+
+static int comparer_listes(const void* a, const void* b) {
+    /*
+    Argument:
+        a, b: Pointeurs vers deux listes
+    But:
+        Ordre croissant de taille : l'intersection part de la plus courte
+    Retour:
+        Négatif, zéro ou positif
+    */
+    uint32_t x = (*(ListeTrigramme* const*)a)->taille;
+    uint32_t y = (*(ListeTrigramme* const*)b)->taille;
+    return (x > y) - (x < y);
+}
+
+static int comparer_produits(const void* a, const void* b) {
+    /*
+    Argument:
+        a, b: Pointeurs vers deux produits
+    But:
+        Ordre croissant d'ID pour les résultats du parcours complet
+    Retour:
+        Négatif, zéro ou positif
+    */
+    uint32_t x = (*(Produit* const*)a)->id;
+    uint32_t y = (*(Produit* const*)b)->id;
+    return (x > y) - (x < y);
+}
+
+static bool intersecter(const uint32_t* trigrammes, size_t nb_trigrammes, const char* motif_min, size_t longueur,
+                        Produit*** resultats, size_t* nb, size_t* cap);
+
+static int rechercher(const char* motif, Produit*** resultats, size_t* nb_resultats) {
+    /*
+    Argument:
+        motif: Texte recherché (insensible à la casse et aux accents)
+        resultats: Tableau des produits trouvés, par ID croissant (à libérer avec free)
+        nb_resultats: Nombre de produits trouvés
+    But:
+        Normaliser le motif comme les noms, intersecter les listes de ses
+        trigrammes en partant de la plus courte, puis vérifier chaque candidat
+        sur sa clé (cle_contient). Un motif de moins de 3 octets ne forme aucun
+        trigramme : tous les produits sont alors vérifiés
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (aucun résultat rendu :
+        une liste incomplète ne doit pas passer pour une réponse)
+    */
+    *resultats = NULL;
+    *nb_resultats = 0;
+    size_t nb = 0;
+    size_t cap = 0;
+    bool erreur = false;
+
+    char* motif_min = (char*)malloc(strlen(motif) + 1);
+    if (motif_min == NULL) return -1;
+    size_t longueur = cle_normaliser(motif, motif_min);
+
+    uint32_t local[TRIGRAMMES_LOCAUX];
+    uint32_t* trigrammes;
+    size_t nb_trigrammes;
+    if (extraire_trigrammes(motif_min, local, &trigrammes, &nb_trigrammes) != 0) {
+        free(motif_min);
+        return -1;
+    }
+
+    if (nb_trigrammes == 0) {
+        for (size_t i = 0; i < colonnes_taille() && !erreur; i++) {
+            Produit* p = colonnes_produit(i);
+            if (cle_contient(p->cle_nom, p->longueur_cle, motif_min, longueur) && !ajouter_resultat(resultats, &nb, &cap, p)) erreur = true;
+        }
+        if (nb > 1 && !erreur) qsort(*resultats, nb, sizeof(Produit*), comparer_produits);
+        free(motif_min);
+    } else {
+        erreur = !intersecter(trigrammes, nb_trigrammes, motif_min, longueur, resultats, &nb, &cap);
+        if (trigrammes != local) free(trigrammes);
+        free(motif_min);
+    }
+
+    if (erreur) {
+        free(*resultats);
+        *resultats = NULL;
+        return -1;
+    }
+    *nb_resultats = nb;
+    return 0;
+}
+
+static bool intersecter(const uint32_t* trigrammes, size_t nb_trigrammes, const char* motif_min, size_t longueur,
+                        Produit*** resultats, size_t* nb, size_t* cap) {
+    /*
+    Argument:
+        trigrammes, nb_trigrammes: Trigrammes distincts du motif (au moins un)
+        motif_min, longueur: Motif normalisé
+        resultats, nb, cap: Tableau de résultats et sa taille
+    But:
+        Parcourir la plus courte des listes des trigrammes, garder les ID
+        présents dans toutes les autres et vérifier leur clé
+    Retour:
+        false en cas d'erreur d'allocation
+    */
+    ListeTrigramme* pile[TRIGRAMMES_LOCAUX];
+    ListeTrigramme** listes = (nb_trigrammes <= TRIGRAMMES_LOCAUX) ? pile
+                            : (ListeTrigramme**)malloc(nb_trigrammes * sizeof(ListeTrigramme*));
+    size_t* curseurs = (size_t*)calloc(nb_trigrammes, sizeof(size_t));
+    if (listes == NULL || curseurs == NULL) {
+        if (listes != pile) free(listes);
+        free(curseurs);
+        return false;
+    }
+    bool absent = false;
+    bool ok = true;
+
+    for (size_t i = 0; i < nb_trigrammes && !absent; i++) {
+        listes[i] = trouver_liste(trigrammes[i], false);
+        if (listes[i] == NULL || listes[i]->taille == 0) absent = true; // aucun nom ne contient ce trigramme
+    }
+
+    if (!absent) {
+        qsort(listes, nb_trigrammes, sizeof(ListeTrigramme*), comparer_listes);
+        const ListeTrigramme* base = listes[0];
+        for (uint32_t k = 0; k < base->taille; k++) {
+            uint32_t id = base->ids[k];
+            bool partout = true;
+            for (size_t j = 1; j < nb_trigrammes && partout; j++) {
+                // Les ID de la base sont croissants : chaque curseur ne fait qu'avancer
+                curseurs[j] = borne_inferieure(listes[j]->ids, curseurs[j], listes[j]->taille, id);
+                partout = (curseurs[j] < listes[j]->taille && listes[j]->ids[curseurs[j]] == id);
+            }
+            if (!partout) continue;
+
+            Produit* p = index_id_chercher(id);
+            if (p != NULL && cle_contient(p->cle_nom, p->longueur_cle, motif_min, longueur) && !ajouter_resultat(resultats, nb, cap, p)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (listes != pile) free(listes);
+    free(curseurs);
+    return ok;
+}
+
+int index_nom_rechercher(const char* motif, Produit*** resultats, size_t* nb) {
+    /*
+    Argument:
+        motif: Texte recherché
+        resultats: Tableau des produits trouvés, par ID croissant (à libérer avec free)
+        nb: Nombre de produits trouvés
+    But:
+        Rechercher (voir rechercher) en mesurant la durée de la recherche
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (resultats NULL, nb 0)
+    */
+    STATS_DEBUT(debut);
+    int res = rechercher(motif, resultats, nb);
+    STATS_FIN(STATS_RECHERCHE, debut);
+    return res;
+}
+
+void index_nom_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer la table et toutes les listes (appelé quand toute la liste est libérée)
+    Retour:
+        Aucun
+    */
+    for (size_t i = 0; i < capacite; i++) {
+        free(table[i].ids);
+    }
+    free(table);
+    table = NULL;
+    capacite = 0;
+    bits = 0;
+    nb_listes = 0;
+}
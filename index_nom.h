@@ -0,0 +1,29 @@
+#ifndef _INDEX_NOM_H
+#define _INDEX_NOM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Index inversé des trigrammes de la clé de recherche du nom (cle_nom :
+    minuscules, sans accents) :
+    - Chaque trigramme présent dans au moins un nom a sa liste d'ID triée.
+    - Une recherche de 3 caractères ou plus ne vérifie que les ID communs à
+      toutes les listes de ses trigrammes ; en dessous, tous les produits sont
+      vérifiés (pas assez de caractères pour former un trigramme).
+    - Maintenu par insertion, insertion_lot, modifier_produit (si le nom change),
+      suppression_par_id et free_struct_produit. Une liste vidée par les
+      retraits est libérée et sa case rendue à la table.
+    - Une recherche qui manque de mémoire renvoie -1 sans résultat, jamais
+      une liste incomplète.
+*/
+
+int index_nom_ajouter(const Produit* produit);
+int index_nom_ajouter_lot(const Produit* premier);
+void index_nom_retirer(const Produit* produit);
+int index_nom_rechercher(const char* motif, Produit*** resultats, size_t* nb);
+void index_nom_liberer(void);
+
+#endif
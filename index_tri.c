@@ -0,0 +1,526 @@
+/*
+Nom du fichier : index_tri.c
+Fait par : Erwann GIRAULT
+But : Vues triées de l'inventaire par prix, quantité et date de péremption,
+      tenues à jour à chaque opération pour ne jamais trier la liste
+*/
+
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "index_tri.h"
+
+#define REMPLISSAGE_LOT (TAILLE_BLOC_TRI * 3 / 4) // place laissée dans chaque bloc après un chargement
+#define CAPACITE_REPERTOIRE_INITIALE 16
+
+typedef struct {
+    uint64_t cle;     // valeur du critère, transformée pour se comparer en entier non signé
+    uint32_t id;      // départage les valeurs égales
+    Produit* produit;
+} EntreeTri;
+
+typedef struct {
+    size_t taille;
+    EntreeTri entrees[TAILLE_BLOC_TRI];
+} BlocTri;
+
+typedef struct {
+    BlocTri** blocs;  // répertoire : blocs dans l'ordre, aucun bloc vide
+    size_t nb_blocs;
+    size_t capacite;
+    size_t taille;    // nombre total d'entrées
+} VueTriee;
+
+static VueTriee vues[NB_TRIS];
+
+static const char* const noms_criteres[NB_TRIS] = {"prix", "quantite", "peremption"};
+
+static uint64_t cle_entier(int64_t valeur) {
+    /*
+    Argument:
+        valeur: Entier signé (quantité, date)
+    But:
+        Inverser le bit de signe : l'ordre des entiers non signés obtenus est
+        celui des valeurs signées
+    Retour:
+        Clé de tri
+    */
+    return (uint64_t)valeur ^ ((uint64_t)1 << 63);
+}
+
+static uint64_t cle_flottant(float valeur) {
+    /*
+    Argument:
+        valeur: Prix unitaire
+    But:
+        Ordonner les flottants par leurs bits : un positif garde ses bits avec
+        le bit de signe levé, un négatif a tous ses bits inversés
+    Retour:
+        Clé de tri
+    */
+    uint32_t bits;
+    memcpy(&bits, &valeur, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return bits;
+}
+
+static bool entree_produit(CritereTri critere, Produit* produit, EntreeTri* entree) {
+    /*
+    Argument:
+        critere: Vue concernée
+        produit: Produit à ranger
+        entree: Entrée construite
+    But:
+        Calculer la clé du produit pour une vue
+    Retour:
+        false si le produit n'a pas sa place dans la vue (sans date de péremption)
+    */
+    switch (critere) {
+        case TRI_PRIX: entree->cle = cle_flottant(produit->prix_unitaire); break;
+        case TRI_QUANTITE: entree->cle = cle_entier(produit->quantite); break;
+        default:
+            if (produit->date_peremption == 0) return false;
+            entree->cle = cle_entier((int64_t)produit->date_peremption);
+            break;
+    }
+    entree->id = produit->id;
+    entree->produit = produit;
+    return true;
+}
+
+static bool avant(const EntreeTri* a, const EntreeTri* b) {
+    /*
+    Argument:
+        a, b: Entrées à comparer
+    But:
+        Ordre des vues : par clé, puis par ID
+    Retour:
+        true si a se range strictement avant b
+    */
+    return a->cle < b->cle || (a->cle == b->cle && a->id < b->id);
+}
+
+static int comparer_entrees(const void* a, const void* b) {
+    /*
+    Argument:
+        a, b: Entrées à comparer (qsort)
+    But:
+        Comparer deux entrées dans l'ordre des vues
+    Retour:
+        Négatif, nul ou positif
+    */
+    const EntreeTri* x = (const EntreeTri*)a;
+    const EntreeTri* y = (const EntreeTri*)b;
+    if (avant(x, y)) return -1;
+    return avant(y, x) ? 1 : 0;
+}
+
+static size_t chercher_bloc(const VueTriee* vue, const EntreeTri* entree) {
+    /*
+    Argument:
+        vue: Vue non vide
+        entree: Entrée cherchée ou à ranger
+    But:
+        Recherche dichotomique dans le répertoire du dernier bloc dont la
+        première entrée ne vient pas après l'entrée (le premier bloc si
+        l'entrée est plus petite que tout)
+    Retour:
+        Indice du bloc
+    */
+    size_t debut = 1, fin = vue->nb_blocs;
+    while (debut < fin) {
+        size_t milieu = debut + (fin - debut) / 2;
+        if (avant(entree, &vue->blocs[milieu]->entrees[0])) {
+            fin = milieu;
+        } else {
+            debut = milieu + 1;
+        }
+    }
+    return debut - 1;
+}
+
+static size_t borne_inferieure(const BlocTri* bloc, const EntreeTri* entree) {
+    /*
+    Argument:
+        bloc: Bloc trié
+        entree: Entrée cherchée
+    But:
+        Recherche dichotomique de la première entrée qui ne vient pas avant
+    Retour:
+        Position trouvée (taille du bloc si toutes les entrées viennent avant)
+    */
+    size_t debut = 0, fin = bloc->taille;
+    while (debut < fin) {
+        size_t milieu = debut + (fin - debut) / 2;
+        if (avant(&bloc->entrees[milieu], entree)) {
+            debut = milieu + 1;
+        } else {
+            fin = milieu;
+        }
+    }
+    return debut;
+}
+
+static BlocTri* ajouter_bloc(VueTriee* vue, size_t rang) {
+    /*
+    Argument:
+        vue: Vue à compléter
+        rang: Place du nouveau bloc dans le répertoire
+    But:
+        Allouer un bloc vide et l'insérer dans le répertoire
+    Retour:
+        Le bloc, ou NULL en cas d'erreur d'allocation (vue inchangée)
+    */
+    if (vue->nb_blocs == vue->capacite) {
+        size_t nouvelle = (vue->capacite == 0) ? CAPACITE_REPERTOIRE_INITIALE : vue->capacite * 2;
+        BlocTri** agrandi = (BlocTri**)realloc(vue->blocs, nouvelle * sizeof(BlocTri*));
+        if (agrandi == NULL) return NULL;
+        vue->blocs = agrandi;
+        vue->capacite = nouvelle;
+    }
+    BlocTri* bloc = (BlocTri*)malloc(sizeof(BlocTri));
+    if (bloc == NULL) return NULL;
+    bloc->taille = 0;
+
+    memmove(vue->blocs + rang + 1, vue->blocs + rang, (vue->nb_blocs - rang) * sizeof(BlocTri*));
+    vue->blocs[rang] = bloc;
+    vue->nb_blocs++;
+    return bloc;
+}
+
+static void vider(VueTriee* vue) {
+    /*
+    Argument:
+        vue: Vue à libérer
+    But:
+        Libérer les blocs et le répertoire d'une vue
+    Retour:
+        Aucun
+    */
+    for (size_t i = 0; i < vue->nb_blocs; i++) {
+        free(vue->blocs[i]);
+    }
+    free(vue->blocs);
+    vue->blocs = NULL;
+    vue->nb_blocs = 0;
+    vue->capacite = 0;
+    vue->taille = 0;
+}
+
+static int inserer_entree(VueTriee* vue, const EntreeTri* entree) {
+    /*
+    Argument:
+        vue: Vue à compléter
+        entree: Entrée à ranger
+    But:
+        Ranger l'entrée à sa place ; un bloc plein est d'abord coupé en deux
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation
+    */
+    if (vue->nb_blocs == 0 && ajouter_bloc(vue, 0) == NULL) return -1;
+
+    size_t rang = chercher_bloc(vue, entree);
+    BlocTri* bloc = vue->blocs[rang];
+    if (bloc->taille == TAILLE_BLOC_TRI) {
+        BlocTri* moitie = ajouter_bloc(vue, rang + 1);
+        if (moitie == NULL) return -1;
+        moitie->taille = TAILLE_BLOC_TRI / 2;
+        bloc->taille = TAILLE_BLOC_TRI - moitie->taille;
+        memcpy(moitie->entrees, bloc->entrees + bloc->taille, moitie->taille * sizeof(EntreeTri));
+        if (!avant(entree, &moitie->entrees[0])) bloc = moitie;
+    }
+
+    size_t pos = borne_inferieure(bloc, entree);
+    memmove(bloc->entrees + pos + 1, bloc->entrees + pos, (bloc->taille - pos) * sizeof(EntreeTri));
+    bloc->entrees[pos] = *entree;
+    bloc->taille++;
+    vue->taille++;
+    return 0;
+}
+
+static void retirer_entree(VueTriee* vue, const EntreeTri* entree) {
+    /*
+    Argument:
+        vue: Vue concernée
+        entree: Entrée à retirer (même clé et même ID qu'à l'ajout)
+    But:
+        Retirer l'entrée si elle est présente ; un bloc vidé quitte le répertoire
+    Retour:
+        Aucun
+    */
+    if (vue->nb_blocs == 0) return;
+    size_t rang = chercher_bloc(vue, entree);
+    BlocTri* bloc = vue->blocs[rang];
+    size_t pos = borne_inferieure(bloc, entree);
+    if (pos == bloc->taille || bloc->entrees[pos].id != entree->id || bloc->entrees[pos].cle != entree->cle) return;
+
+    memmove(bloc->entrees + pos, bloc->entrees + pos + 1, (bloc->taille - pos - 1) * sizeof(EntreeTri));
+    bloc->taille--;
+    vue->taille--;
+    if (bloc->taille == 0) {
+        free(bloc);
+        memmove(vue->blocs + rang, vue->blocs + rang + 1, (vue->nb_blocs - rang - 1) * sizeof(BlocTri*));
+        vue->nb_blocs--;
+    }
+}
+
+int index_tri_ajouter(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui entre dans l'inventaire
+    But:
+        Ranger le produit dans chaque vue où il a sa place
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (le produit n'est dans
+        aucune vue)
+    */
+    if (produit == NULL) return -1;
+    for (int c = 0; c < NB_TRIS; c++) {
+        EntreeTri entree;
+        if (!entree_produit((CritereTri)c, produit, &entree)) continue;
+        if (inserer_entree(&vues[c], &entree) != 0) {
+            for (int d = 0; d < c; d++) {
+                if (entree_produit((CritereTri)d, produit, &entree)) retirer_entree(&vues[d], &entree);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int fusionner(VueTriee* vue, const EntreeTri* lot, size_t nb) {
+    /*
+    Argument:
+        vue: Vue à compléter
+        lot: Entrées triées à ajouter
+        nb: Nombre d'entrées du lot
+    But:
+        Reconstruire la vue en fusionnant son contenu et le lot, en remplissant
+        les blocs aux trois quarts. La nouvelle vue remplace l'ancienne une fois
+        complète
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (vue inchangée)
+    */
+    VueTriee nouvelle = {NULL, 0, 0, 0};
+    BlocTri* actu = NULL;
+    size_t bloc = 0, pos = 0, i = 0;
+
+    while (true) {
+        while (bloc < vue->nb_blocs && pos == vue->blocs[bloc]->taille) {
+            bloc++;
+            pos = 0;
+        }
+        const EntreeTri* ancienne = (bloc < vue->nb_blocs) ? &vue->blocs[bloc]->entrees[pos] : NULL;
+        const EntreeTri* entree;
+        if (ancienne != NULL && (i == nb || !avant(&lot[i], ancienne))) {
+            entree = ancienne;
+            pos++;
+        } else if (i < nb) {
+            entree = &lot[i++];
+        } else {
+            break;
+        }
+
+        if (actu == NULL || actu->taille == REMPLISSAGE_LOT) {
+            actu = ajouter_bloc(&nouvelle, nouvelle.nb_blocs);
+            if (actu == NULL) {
+                vider(&nouvelle);
+                return -1;
+            }
+        }
+        actu->entrees[actu->taille++] = *entree;
+        nouvelle.taille++;
+    }
+
+    vider(vue);
+    *vue = nouvelle;
+    return 0;
+}
+
+int index_tri_ajouter_lot(Produit* premier) {
+    /*
+    Argument:
+        premier: Premier produit d'une chaîne terminée par NULL (lot de chargement)
+    But:
+        Pour chaque vue, trier les entrées du lot puis les fusionner avec la
+        vue en un seul passage (O(n + k log k) au lieu de k ajouts)
+    Retour:
+        0 si succès, -1 en cas d'erreur d'allocation (vue concernée inchangée)
+    */
+    size_t nb = 0;
+    for (Produit* actu = premier; actu != NULL; actu = actu->suivant) nb++;
+    if (nb == 0) return 0;
+
+    EntreeTri* lot = (EntreeTri*)malloc(nb * sizeof(EntreeTri));
+    if (lot == NULL) return -1;
+
+    int res = 0;
+    for (int c = 0; c < NB_TRIS; c++) {
+        size_t k = 0;
+        for (Produit* actu = premier; actu != NULL; actu = actu->suivant) {
+            if (entree_produit((CritereTri)c, actu, &lot[k])) k++;
+        }
+        if (k == 0) continue;
+        qsort(lot, k, sizeof(EntreeTri), comparer_entrees);
+        if (fusionner(&vues[c], lot, k) != 0) res = -1;
+    }
+    free(lot);
+    return res;
+}
+
+void index_tri_retirer(Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui quitte l'inventaire, ou dont le prix, la quantité
+                 ou la date vont changer (champs encore à leur ancienne valeur)
+    But:
+        Retirer le produit de chaque vue
+    Retour:
+        Aucun
+    */
+    if (produit == NULL) return;
+    for (int c = 0; c < NB_TRIS; c++) {
+        EntreeTri entree;
+        if (entree_produit((CritereTri)c, produit, &entree)) retirer_entree(&vues[c], &entree);
+    }
+}
+
+size_t index_tri_taille(CritereTri critere) {
+    /*
+    Argument:
+        critere: Vue concernée
+    But:
+        Donner le nombre de produits rangés dans une vue
+    Retour:
+        Nombre de produits (0 pour un critère inconnu)
+    */
+    return (critere < NB_TRIS) ? vues[critere].taille : 0;
+}
+
+int index_tri_critere_depuis_chaine(const char* texte, CritereTri* critere) {
+    /*
+    Argument:
+        texte: "prix", "quantite" ou "peremption"
+        critere: Critère reconnu
+    But:
+        Traduire le nom d'une vue (menu, commande "top")
+    Retour:
+        0 si le nom est connu, -1 sinon
+    */
+    for (int c = 0; c < NB_TRIS; c++) {
+        if (strcmp(texte, noms_criteres[c]) == 0) {
+            *critere = (CritereTri)c;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void index_tri_ouvrir(CritereTri critere, bool decroissant, CurseurTri* curseur) {
+    /*
+    Argument:
+        critere: Vue à parcourir
+        decroissant: true pour partir de la plus grande valeur
+        curseur: Curseur à placer
+    But:
+        Placer un curseur avant la première entrée de la vue dans l'ordre voulu
+    Retour:
+        Aucun
+    */
+    curseur->critere = critere;
+    curseur->decroissant = decroissant;
+    curseur->bloc = decroissant ? vues[critere].nb_blocs : 0;
+    curseur->position = 0;
+}
+
+void index_tri_placer(CritereTri critere, double valeur, CurseurTri* curseur) {
+    /*
+    Argument:
+        critere: Vue à parcourir
+        valeur: Borne basse dans l'unité du critère (prix, quantité, date epoch)
+        curseur: Curseur à placer
+    But:
+        Placer un curseur croissant avant le premier produit dont la valeur est
+        au moins la borne : recherche dichotomique dans le répertoire puis dans
+        un bloc, O(log n). Une requête d'intervalle avance ensuite avec
+        index_tri_suivant jusqu'à dépasser la borne haute : O(log n + k)
+    Retour:
+        Aucun
+    */
+    index_tri_ouvrir(critere, false, curseur);
+    const VueTriee* vue = &vues[critere];
+    if (vue->nb_blocs == 0) return;
+
+    EntreeTri borne = {0, 0, NULL};
+    borne.cle = (critere == TRI_PRIX) ? cle_flottant((float)valeur) : cle_entier((int64_t)valeur);
+    curseur->bloc = chercher_bloc(vue, &borne);
+    curseur->position = borne_inferieure(vue->blocs[curseur->bloc], &borne);
+}
+
+Produit* index_tri_suivant(CurseurTri* curseur) {
+    /*
+    Argument:
+        curseur: Curseur ouvert par index_tri_ouvrir
+    But:
+        Avancer d'une entrée. En ordre décroissant, position compte les
+        entrées du bloc courant qui restent à rendre
+    Retour:
+        Produit suivant, ou NULL en fin de vue
+    */
+    const VueTriee* vue = &vues[curseur->critere];
+    if (curseur->decroissant) {
+        while (curseur->position == 0) {
+            if (curseur->bloc == 0) return NULL;
+            curseur->bloc--;
+            curseur->position = vue->blocs[curseur->bloc]->taille;
+        }
+        return vue->blocs[curseur->bloc]->entrees[--curseur->position].produit;
+    }
+    while (curseur->bloc < vue->nb_blocs) {
+        const BlocTri* bloc = vue->blocs[curseur->bloc];
+        if (curseur->position < bloc->taille) return bloc->entrees[curseur->position++].produit;
+        curseur->bloc++;
+        curseur->position = 0;
+    }
+    return NULL;
+}
+
+size_t index_tri_premiers(CritereTri critere, bool decroissant, size_t k, Produit** sortie) {
+    /*
+    Argument:
+        critere: Vue concernée
+        decroissant: true pour les plus grandes valeurs
+        k: Nombre de produits voulus
+        sortie: Tableau d'au moins k cases
+    But:
+        Relever les k premiers produits de la vue (top-k) en O(k), sans tri
+    Retour:
+        Nombre de produits écrits (moins de k si la vue est plus petite)
+    */
+    CurseurTri curseur;
+    index_tri_ouvrir(critere, decroissant, &curseur);
+    size_t nb = 0;
+    Produit* p;
+    while (nb < k && (p = index_tri_suivant(&curseur)) != NULL) {
+        sortie[nb++] = p;
+    }
+    return nb;
+}
+
+void index_tri_liberer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Vider toutes les vues (fin de programme ou rechargement)
+    Retour:
+        Aucun
+    */
+    for (int c = 0; c < NB_TRIS; c++) {
+        vider(&vues[c]);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef _INDEX_TRI_H
+#define _INDEX_TRI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Vues triées de l'inventaire (prix, quantité, date de péremption) :
+    - Chaque vue est un tableau trié découpé en blocs d'au plus TAILLE_BLOC_TRI
+      entrées, plus un répertoire trié des blocs (arbre B à deux niveaux).
+      Ajout et retrait en O(log n) comparaisons plus le décalage d'un bloc ;
+      un bloc plein est coupé en deux.
+    - Les entrées sont triées par valeur puis par ID : l'ordre est stable et
+      un produit se retrouve sans parcours.
+    - Seuls les produits avec une date (différente de 0) figurent dans la vue
+      des péremptions.
+    - Maintenu par insertion, insertion_lot (tri du lot puis fusion),
+      modifier_produit, suppression_par_id et free_struct_produit.
+    - Un curseur parcourt une vue dans l'ordre croissant ou décroissant, ou à
+      partir d'une valeur (index_tri_placer : intervalle de dates en
+      O(log n + k)) ; il n'est plus valable après une écriture dans
+      l'inventaire.
+*/
+
+#define TAILLE_BLOC_TRI 128
+
+typedef enum {
+    TRI_PRIX,
+    TRI_QUANTITE,
+    TRI_PEREMPTION,
+    NB_TRIS
+} CritereTri;
+
+typedef struct {
+    CritereTri critere;
+    bool decroissant;
+    size_t bloc;
+    size_t position;
+} CurseurTri;
+
+int index_tri_ajouter(Produit* produit);
+int index_tri_ajouter_lot(Produit* premier);
+void index_tri_retirer(Produit* produit);
+size_t index_tri_taille(CritereTri critere);
+int index_tri_critere_depuis_chaine(const char* texte, CritereTri* critere);
+
+void index_tri_ouvrir(CritereTri critere, bool decroissant, CurseurTri* curseur);
+void index_tri_placer(CritereTri critere, double valeur, CurseurTri* curseur);
+Produit* index_tri_suivant(CurseurTri* curseur);
+size_t index_tri_premiers(CritereTri critere, bool decroissant, size_t k, Produit** sortie);
+void index_tri_liberer(void);
+
+#endif
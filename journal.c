@@ -0,0 +1,532 @@
+/*
+Nom du fichier : journal.c
+Fait par : Erwann GIRAULT
+But : Écriture bufferisée de historique.bin. Les événements passent par un
+      anneau mémoire et sont écrits en bloc par un thread de vidage, au lieu
+      d'un fopen/fclose par action. Rotation du fichier par taille
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "stats.h"
+
+#define TAILLE_ANNEAU (256 * 1024)
+#define TAILLE_CHEMIN 4096
+
+static char anneau[TAILLE_ANNEAU];
+static size_t tete = 0;   // position d'écriture (compteur croissant, modulo TAILLE_ANNEAU)
+static size_t queue = 0;  // tout ce qui est avant queue est déjà sur disque
+static unsigned int nb_en_attente = 0;
+static struct timespec echeance_vidage;
+
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond_travail = PTHREAD_COND_INITIALIZER;    // réveille le thread de vidage
+static pthread_cond_t cond_avancement = PTHREAD_COND_INITIALIZER; // queue a avancé
+static pthread_t thread_vidage;
+
+static ConfigJournal config_active;
+static int fd = -1;
+static bool ouvert = false;
+static bool echec_ouverture = false;
+static bool demande_vidage = false;
+static bool arret = false;
+static bool fermeture_enregistree = false;
+
+static char chemin_actif[TAILLE_CHEMIN];
+static uint64_t taille_fichier = 0; // tenue par le thread de vidage (après l'ouverture)
+static uint64_t octets_perdus = 0;   // écrits pendant que fd était fermé (rotation manquée)
+static bool rotation_en_echec = false;
+
+void journal_config_defaut(ConfigJournal* config) {
+    /*
+    Argument:
+        config: Configuration à remplir
+    But:
+        Politique par défaut : vidage tous les 64 événements ou au bout d'une
+        seconde, sans fsync, rotation à 64 Mo
+    Retour:
+        Aucun
+    */
+    config->politique = JOURNAL_PAR_LOT;
+    config->taille_lot = 64;
+    config->intervalle_ms = 1000;
+    config->synchroniser_disque = false;
+    config->taille_rotation = ROTATION_HISTORIQUE_DEFAUT;
+}
+
+int journal_config_depuis_chaine(const char* texte, ConfigJournal* config) {
+    /*
+    Argument:
+        texte: Politique sous forme "operation", "lot:N" ou "minuterie:MS",
+               éventuellement suivie d'options : ",fsync", ",rotation:MO"
+               (taille de rotation en Mo, 0 = jamais)
+        config: Configuration à compléter (inchangée en cas d'erreur)
+    But:
+        Interpréter la politique fournie par l'utilisateur (variable BGRS_JOURNAL)
+    Retour:
+        0 si le texte est valide, -1 sinon
+    */
+    if (texte == NULL) return -1;
+
+    ConfigJournal resultat = *config;
+    char copie[64];
+    snprintf(copie, sizeof(copie), "%s", texte);
+
+    char* options = strchr(copie, ',');
+    if (options != NULL) {
+        *options = '\0';
+        options++;
+    }
+    while (options != NULL) {
+        char* suivante = strchr(options, ',');
+        if (suivante != NULL) *suivante++ = '\0';
+        if (strcmp(options, "fsync") == 0) {
+            resultat.synchroniser_disque = true;
+        } else if (strncmp(options, "rotation:", 9) == 0) {
+            char* fin;
+            errno = 0;
+            long mo = strtol(options + 9, &fin, 10);
+            if (errno != 0 || fin == options + 9 || *fin != '\0' || mo < 0 || mo > 1024 * 1024) return -1;
+            resultat.taille_rotation = (uint64_t)mo * 1024 * 1024;
+        } else {
+            return -1;
+        }
+        options = suivante;
+    }
+
+    char* valeur = strchr(copie, ':');
+    long nombre = 0;
+    if (valeur != NULL) {
+        *valeur = '\0';
+        valeur++;
+        char* fin;
+        errno = 0;
+        nombre = strtol(valeur, &fin, 10);
+        if (errno != 0 || fin == valeur || *fin != '\0' || nombre <= 0 || nombre > 1000000) return -1;
+    }
+
+    if (strcmp(copie, "operation") == 0 && valeur == NULL) {
+        resultat.politique = JOURNAL_PAR_OPERATION;
+    } else if (strcmp(copie, "lot") == 0 && valeur != NULL) {
+        resultat.politique = JOURNAL_PAR_LOT;
+        resultat.taille_lot = (unsigned int)nombre;
+    } else if (strcmp(copie, "minuterie") == 0 && valeur != NULL) {
+        resultat.politique = JOURNAL_MINUTERIE;
+        resultat.intervalle_ms = (unsigned int)nombre;
+    } else {
+        return -1;
+    }
+
+    *config = resultat;
+    return 0;
+}
+
+static int pivoter(void);
+
+static void ecrire_tout(const char* donnees, size_t taille) {
+    /*
+    Argument:
+        donnees: Octets à écrire
+        taille: Nombre d'octets
+    But:
+        Écrire le bloc en entier (write peut n'en écrire qu'une partie)
+    Retour:
+        Aucun
+    */
+    if (fd < 0) {
+        octets_perdus += taille;
+        return;
+    }
+    while (taille > 0) {
+        ssize_t n = write(fd, donnees, taille);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Impossible d'ecrire dans %s\n", chemin_actif);
+            return;
+        }
+        STATS_OCTETS_ECRITS((size_t)n);
+        taille_fichier += (uint64_t)n;
+        donnees += n;
+        taille -= (size_t)n;
+    }
+}
+
+static void calculer_echeance(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Fixer la date limite de vidage du premier événement en attente
+    Retour:
+        Aucun
+    */
+    clock_gettime(CLOCK_REALTIME, &echeance_vidage);
+    echeance_vidage.tv_sec += config_active.intervalle_ms / 1000;
+    echeance_vidage.tv_nsec += (long)(config_active.intervalle_ms % 1000) * 1000000L;
+    if (echeance_vidage.tv_nsec >= 1000000000L) {
+        echeance_vidage.tv_sec++;
+        echeance_vidage.tv_nsec -= 1000000000L;
+    }
+}
+
+static bool vidage_necessaire(void) {
+    /*
+    Argument:
+        Aucun (appelé verrou pris)
+    But:
+        Décider si le thread de vidage doit écrire maintenant
+    Retour:
+        true s'il faut vider l'anneau
+    */
+    if (tete == queue) return false;
+    if (demande_vidage || arret) return true;
+    if (tete - queue > TAILLE_ANNEAU / 2) return true;
+    if (config_active.politique == JOURNAL_PAR_LOT && nb_en_attente >= config_active.taille_lot) return true;
+    return false;
+}
+
+static int ouvrir_fichier(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Ouvrir chemin_actif en ajout. Un fichier vide reçoit l'en-tête ; un
+        fichier qui n'est pas un historique (ancien format, autre contenu)
+        est archivé comme lors d'une rotation
+    Retour:
+        0 si succès, -1 sinon
+    */
+    fd = open(chemin_actif, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    struct stat infos;
+    if (fstat(fd, &infos) != 0) {
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    taille_fichier = (uint64_t)infos.st_size;
+    if (taille_fichier > 0) {
+        char magie[8];
+        if (pread(fd, magie, sizeof(magie), 0) == (ssize_t)sizeof(magie) && memcmp(magie, MAGIE_HISTORIQUE, 8) == 0) {
+            return 0;
+        }
+        fprintf(stderr, "[i] %s n'est pas un historique BGRS : archive en %s.1\n", chemin_actif, chemin_actif);
+        close(fd);
+        fd = -1;
+        return pivoter();
+    }
+    unsigned char entete[TAILLE_ENTETE_HISTORIQUE];
+    historique_entete(entete);
+    ecrire_tout((const char*)entete, sizeof(entete));
+    return 0;
+}
+
+static int pivoter(void) {
+    /*
+    Argument:
+        Aucun (fichier courant déjà fermé)
+    But:
+        Décaler les archives (chemin.N-1 devient chemin.N, la plus ancienne
+        est écrasée), archiver le fichier courant en chemin.1 et en ouvrir un
+        nouveau
+    Retour:
+        0 si succès, -1 sinon
+    */
+    char ancien[TAILLE_CHEMIN + 16];
+    char nouveau[TAILLE_CHEMIN + 16];
+    for (int i = NB_ARCHIVES_HISTORIQUE - 1; i >= 1; i--) {
+        snprintf(ancien, sizeof(ancien), "%s.%d", chemin_actif, i);
+        snprintf(nouveau, sizeof(nouveau), "%s.%d", chemin_actif, i + 1);
+        rename(ancien, nouveau); // archive absente : rien à décaler
+    }
+    snprintf(nouveau, sizeof(nouveau), "%s.1", chemin_actif);
+    if (rename(chemin_actif, nouveau) != 0) return -1;
+    return ouvrir_fichier();
+}
+
+static void reprendre_fichier(void) {
+    /*
+    Argument:
+        Aucun (thread de vidage, fd fermé par une rotation manquée)
+    But:
+        Rouvrir le fichier courant avant d'écrire : celui qui n'a pas pu être
+        archivé, ou un nouveau si l'archivage a réussi mais pas l'ouverture.
+        Prévient une fois de la perte et une fois de la reprise
+    Retour:
+        Aucun
+    */
+    if (ouvrir_fichier() != 0) {
+        if (octets_perdus == 0) {
+            fprintf(stderr, "[!] %s ne peut pas etre rouvert, evenements perdus jusqu'au prochain essai.\n", chemin_actif);
+        }
+        return;
+    }
+    if (octets_perdus > 0) {
+        fprintf(stderr, "[i] Historique %s rouvert (%llu octets d'evenements perdus).\n", chemin_actif, (unsigned long long)octets_perdus);
+        octets_perdus = 0;
+    }
+}
+
+static void* boucle_vidage(void* arg) {
+    /*
+    Argument:
+        arg: Inutilisé
+    But:
+        Attendre qu'un vidage soit nécessaire (politique, minuterie ou demande explicite),
+        écrire hors verrou la portion en attente de l'anneau, puis libérer la place
+    Retour:
+        NULL
+    */
+    (void)arg;
+    pthread_mutex_lock(&verrou);
+    while (true) {
+        if (!vidage_necessaire()) {
+            if (arret && tete == queue) break;
+            demande_vidage = false;
+            if (tete != queue && config_active.intervalle_ms > 0) {
+                if (pthread_cond_timedwait(&cond_travail, &verrou, &echeance_vidage) == ETIMEDOUT) {
+                    demande_vidage = (tete != queue);
+                }
+            } else {
+                pthread_cond_wait(&cond_travail, &verrou);
+            }
+            continue;
+        }
+
+        size_t debut = queue;
+        size_t fin = tete;
+        demande_vidage = false;
+        nb_en_attente = 0;
+        pthread_mutex_unlock(&verrou);
+
+        // Les producteurs n'écrivent jamais dans [queue, tete[ : lecture sans verrou
+        size_t pos = debut % TAILLE_ANNEAU;
+        size_t taille = fin - debut;
+        size_t premier_morceau = (pos + taille > TAILLE_ANNEAU) ? TAILLE_ANNEAU - pos : taille;
+        if (fd < 0) reprendre_fichier();
+        ecrire_tout(anneau + pos, premier_morceau);
+        ecrire_tout(anneau, taille - premier_morceau);
+        if (config_active.synchroniser_disque && fd >= 0) {
+            fsync(fd);
+        }
+        if (fd >= 0 && config_active.taille_rotation > 0 && taille_fichier >= config_active.taille_rotation) {
+            close(fd);
+            fd = -1;
+            if (pivoter() == 0) {
+                rotation_en_echec = false;
+            } else {
+                // Le fichier courant est rouvert au prochain vidage, qui retentera la rotation
+                if (!rotation_en_echec) {
+                    fprintf(stderr, "[!] Rotation de %s impossible (%s), nouvel essai au prochain vidage.\n", chemin_actif, strerror(errno));
+                    rotation_en_echec = true;
+                }
+            }
+        }
+
+        pthread_mutex_lock(&verrou);
+        queue = fin;
+        pthread_cond_broadcast(&cond_avancement);
+    }
+    pthread_mutex_unlock(&verrou);
+    return NULL;
+}
+
+static int ouvrir_verrouille(const char* chemin, const ConfigJournal* config) {
+    /*
+    Argument:
+        chemin: Fichier journal
+        config: Politique de vidage (NULL pour la politique par défaut)
+    But:
+        Ouvrir le fichier en ajout et démarrer le thread de vidage (verrou pris)
+    Retour:
+        0 si succès, -1 sinon
+    */
+    if (ouvert) return 0;
+
+    if (config != NULL) {
+        config_active = *config;
+    } else {
+        journal_config_defaut(&config_active);
+    }
+    if (config_active.taille_lot == 0) config_active.taille_lot = 1;
+
+    if (snprintf(chemin_actif, sizeof(chemin_actif), "%s", chemin) >= (int)sizeof(chemin_actif) || ouvrir_fichier() != 0) {
+        if (!echec_ouverture) {
+            fprintf(stderr, "Impossible d'ecrire dans %s\n", chemin);
+        }
+        echec_ouverture = true;
+        return -1;
+    }
+
+    arret = false;
+    demande_vidage = false;
+    if (pthread_create(&thread_vidage, NULL, boucle_vidage, NULL) != 0) {
+        close(fd);
+        fd = -1;
+        echec_ouverture = true;
+        return -1;
+    }
+    ouvert = true;
+    echec_ouverture = false;
+
+    if (!fermeture_enregistree) {
+        atexit(journal_fermer); // filet de sécurité si le programme sort sans passer par le menu
+        fermeture_enregistree = true;
+    }
+    return 0;
+}
+
+int journal_ouvrir(const char* chemin, const ConfigJournal* config) {
+    /*
+    Argument:
+        chemin: Fichier journal (FICHIER_HISTORIQUE en général)
+        config: Politique de vidage (NULL pour la politique par défaut)
+    But:
+        Ouvrir explicitement le journal avec une politique donnée
+        Sans cet appel, le journal s'ouvre tout seul au premier ajouter_log
+    Retour:
+        0 si succès, -1 sinon
+    */
+    pthread_mutex_lock(&verrou);
+    echec_ouverture = false;
+    int res = ouvrir_verrouille(chemin, config);
+    pthread_mutex_unlock(&verrou);
+    return res;
+}
+
+static void copier_dans_anneau(const char* donnees, size_t taille) {
+    /*
+    Argument:
+        donnees: Octets à ajouter
+        taille: Nombre d'octets (la place a déjà été vérifiée)
+    But:
+        Copier à la position de tête en repartant au début de l'anneau si besoin
+    Retour:
+        Aucun
+    */
+    size_t pos = tete % TAILLE_ANNEAU;
+    size_t premier_morceau = (pos + taille > TAILLE_ANNEAU) ? TAILLE_ANNEAU - pos : taille;
+    memcpy(anneau + pos, donnees, premier_morceau);
+    memcpy(anneau, donnees + premier_morceau, taille - premier_morceau);
+    tete += taille;
+}
+
+void journal_ecrire(const EvenementHistorique* evenement) {
+    /*
+    Argument:
+        evenement: Événement à enregistrer (sa date est remplacée par l'heure courante)
+    But:
+        Encoder l'événement hors verrou et le déposer dans l'anneau
+        Selon la politique, réveille le thread de vidage ou attend l'écriture
+    Retour:
+        Aucun
+    */
+    EvenementHistorique copie = *evenement;
+    copie.date = time(NULL);
+    unsigned char enregistrement[TAILLE_MAX_EVENEMENT];
+    size_t taille_totale = historique_encoder(&copie, enregistrement);
+
+    pthread_mutex_lock(&verrou);
+    if (!ouvert && (echec_ouverture || ouvrir_verrouille(FICHIER_HISTORIQUE, NULL) != 0)) {
+        pthread_mutex_unlock(&verrou);
+        return;
+    }
+
+    while (TAILLE_ANNEAU - (tete - queue) < taille_totale) {
+        demande_vidage = true;
+        pthread_cond_signal(&cond_travail);
+        pthread_cond_wait(&cond_avancement, &verrou);
+    }
+
+    bool etait_vide = (tete == queue);
+    copier_dans_anneau((const char*)enregistrement, taille_totale);
+    nb_en_attente++;
+
+    if (etait_vide && config_active.intervalle_ms > 0) {
+        calculer_echeance();
+    }
+
+    if (config_active.politique == JOURNAL_PAR_OPERATION) {
+        size_t ma_fin = tete;
+        demande_vidage = true;
+        pthread_cond_signal(&cond_travail);
+        while (queue < ma_fin && ouvert) {
+            pthread_cond_wait(&cond_avancement, &verrou);
+        }
+    } else if (etait_vide || vidage_necessaire()) {
+        pthread_cond_signal(&cond_travail); // nouvelle échéance ou seuil atteint
+    }
+    pthread_mutex_unlock(&verrou);
+}
+
+void journal_vider(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Forcer l'écriture de tout ce qui est en attente et attendre qu'elle soit faite
+    Retour:
+        Aucun
+    */
+    pthread_mutex_lock(&verrou);
+    if (ouvert) {
+        size_t cible = tete;
+        demande_vidage = true;
+        pthread_cond_signal(&cond_travail);
+        while (queue < cible) {
+            pthread_cond_wait(&cond_avancement, &verrou);
+        }
+    }
+    pthread_mutex_unlock(&verrou);
+}
+
+void journal_fermer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Vider l'anneau, arrêter le thread de vidage et fermer le fichier
+        Peut être appelée plusieurs fois
+    Retour:
+        Aucun
+    */
+    pthread_mutex_lock(&verrou);
+    if (!ouvert) {
+        pthread_mutex_unlock(&verrou);
+        return;
+    }
+    arret = true;
+    pthread_cond_signal(&cond_travail);
+    pthread_mutex_unlock(&verrou);
+
+    pthread_join(thread_vidage, NULL);
+
+    pthread_mutex_lock(&verrou);
+    if (fd >= 0) {
+        if (config_active.synchroniser_disque) {
+            fsync(fd);
+        }
+        close(fd);
+    }
+    if (octets_perdus > 0) {
+        fprintf(stderr, "[!] %llu octets d'evenements perdus : %s n'a pas pu etre rouvert.\n", (unsigned long long)octets_perdus, chemin_actif);
+        octets_perdus = 0;
+    }
+    fd = -1;
+    ouvert = false;
+    arret = false;
+    pthread_mutex_unlock(&verrou);
+}
@@ -0,0 +1,58 @@
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "historique.h"
+
+/*
+    Journal des actions (historique.bin, format décrit dans historique.h) :
+    - Le fichier reste ouvert pendant toute l'exécution.
+    - Les événements sont encodés et datés par journal_ecrire, copiés dans
+      un anneau mémoire, puis écrits par un thread de vidage selon la politique choisie.
+    - Rotation : quand le fichier dépasse taille_rotation octets (0 = jamais),
+      le thread de vidage le renomme en historique.bin.1 (les archives
+      existantes sont décalées, au-delà de NB_ARCHIVES_HISTORIQUE la plus
+      ancienne est supprimée) et repart d'un fichier vide. Si la rotation
+      échoue, le message est affiché une fois et le fichier courant est
+      rouvert au vidage suivant, qui retente la rotation ; les événements
+      perdus entre-temps (fichier impossible à rouvrir) sont comptés et signalés.
+    - L'ancien historique texte (historique.log) n'est ni converti, ni
+      modifié, ni relu : il reste consultable tel quel.
+
+    Politiques de vidage :
+    - JOURNAL_PAR_OPERATION : chaque ajouter_log attend que son événement soit écrit.
+    - JOURNAL_PAR_LOT : vidage tous les taille_lot événements (et au plus tard
+      après intervalle_ms si intervalle_ms > 0).
+    - JOURNAL_MINUTERIE : vidage au plus tard intervalle_ms après le premier
+      événement en attente.
+    Dans tous les cas, synchroniser_disque ajoute un fsync après chaque vidage.
+*/
+
+#define FICHIER_HISTORIQUE "historique.bin"
+#define ANCIEN_HISTORIQUE "historique.log"
+#define ROTATION_HISTORIQUE_DEFAUT (64u * 1024 * 1024)
+
+typedef enum {
+    JOURNAL_PAR_OPERATION,
+    JOURNAL_PAR_LOT,
+    JOURNAL_MINUTERIE
+} PolitiqueJournal;
+
+typedef struct {
+    PolitiqueJournal politique;
+    unsigned int taille_lot;
+    unsigned int intervalle_ms;
+    bool synchroniser_disque;
+    uint64_t taille_rotation;
+} ConfigJournal;
+
+void journal_config_defaut(ConfigJournal* config);
+int journal_config_depuis_chaine(const char* texte, ConfigJournal* config);
+int journal_ouvrir(const char* chemin, const ConfigJournal* config);
+void journal_ecrire(const EvenementHistorique* evenement);
+void journal_vider(void);
+void journal_fermer(void);
+
+#endif
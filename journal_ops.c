@@ -0,0 +1,922 @@
+/*
+Nom du fichier : journal_ops.c
+Fait par : Erwann GIRAULT
+But : Journal des opérations en ajout seul. Une sauvegarde n'écrit plus que
+      les changements depuis la précédente, et les modifications non
+      sauvegardées sont rejouées après un arrêt brutal
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "journal_ops.h"
+#include "gestion_db.h"
+#include "index_id.h"
+#include "colonnes.h"
+#include "stats.h"
+
+/*
+    Format du fichier (ordre des octets de la machine) :
+    - En-tête : "BGRSJOPS", version (u32), réservé (u32)
+    - Enregistrements : longueur de la charge (u32), somme FNV-1a (u32) sur le
+      type et la charge, type (u8), charge
+    Un enregistrement incomplet ou dont la somme est fausse marque la fin du
+    journal (arrêt pendant une écriture) : il est coupé à la réouverture.
+*/
+#define MAGIE_JOURNAL "BGRSJOPS"
+#define VERSION_JOURNAL 1
+#define TAILLE_ENTETE 16
+#define TAILLE_ENTETE_OP 9
+#define TAILLE_PILE_OP 2048 // au-delà, le tampon d'un enregistrement est alloué
+#define SEUIL_COMPACTION_MIN (1024 * 1024)
+#define TAILLE_CHEMIN 4096
+#define SEUIL_LOT_REPRISE 1024 // insertions consécutives rejouées en un lot
+
+typedef enum {
+    OP_BASE_FICHIER = 1, // point de départ : le fichier de sauvegarde décrit
+    OP_BASE_VIDE = 2,    // point de départ : un inventaire vide
+    OP_INSERTION = 3,
+    OP_MODIFICATION = 4,
+    OP_SUPPRESSION = 5,
+    OP_VALIDATION = 6    // tout ce qui précède fait partie de la sauvegarde
+} TypeOperation;
+
+typedef struct {
+    uint64_t inode;
+    uint64_t taille;
+    int64_t modif_s;
+    int64_t modif_ns;
+} IdentiteFichier;
+
+typedef struct {
+    size_t fin_valide;      // fin du dernier enregistrement intact
+    size_t fin_validee;     // fin de la dernière validation (TAILLE_ENTETE si aucune)
+    long debut_vide;        // fin du BASE_VIDE non validé, -1 si absent
+    bool a_base;            // le journal commence par un BASE_FICHIER
+    IdentiteFichier base;
+    size_t nb_valides;      // opérations avant fin_validee
+    size_t nb_non_valides;  // opérations après fin_validee
+} EtatJournal;
+
+typedef struct {
+    uint32_t id;
+    int32_t quantite;
+    float prix_unitaire;
+    int64_t date_peremption;
+    const char* champs[4]; // nom, description, catégorie, note (terminés par '\0')
+} OperationProduit;
+
+static int fd = -1;
+static char chemin_journal[TAILLE_CHEMIN];
+static char chemin_sauvegarde[TAILLE_CHEMIN];
+static size_t taille_journal = 0;
+static size_t fin_validee = 0;
+static uint64_t taille_base = 0;      // taille du fichier de sauvegarde de référence
+static bool attache = false;          // inventaire = fichier de sauvegarde + journal
+static bool segment_ouvert = false;   // BASE_VIDE déjà écrit pour cet inventaire détaché
+
+static uint32_t somme_operation(uint8_t type, const unsigned char* charge, size_t taille) {
+    /*
+    Argument:
+        type: Type de l'enregistrement
+        charge: Octets de la charge
+        taille: Longueur de la charge
+    But:
+        Somme FNV-1a 32 bits, pour reconnaître un enregistrement tronqué ou abîmé
+    Retour:
+        La somme
+    */
+    uint32_t h = 2166136261u;
+    h = (h ^ type) * 16777619u;
+    for (size_t i = 0; i < taille; i++) {
+        h = (h ^ charge[i]) * 16777619u;
+    }
+    return h;
+}
+
+static size_t sceller(unsigned char* enregistrement, uint8_t type, size_t taille_charge) {
+    /*
+    Argument:
+        enregistrement: Tampon dont la charge est déjà placée après l'en-tête
+        type: Type de l'enregistrement
+        taille_charge: Longueur de la charge
+    But:
+        Remplir l'en-tête de l'enregistrement (longueur, somme, type)
+    Retour:
+        Taille totale de l'enregistrement
+    */
+    uint32_t longueur = (uint32_t)taille_charge;
+    uint32_t somme = somme_operation(type, enregistrement + TAILLE_ENTETE_OP, taille_charge);
+    memcpy(enregistrement, &longueur, 4);
+    memcpy(enregistrement + 4, &somme, 4);
+    enregistrement[8] = type;
+    return TAILLE_ENTETE_OP + taille_charge;
+}
+
+static int ecrire_tout(const unsigned char* donnees, size_t taille) {
+    /*
+    Argument:
+        donnees: Octets à écrire en fin de journal
+        taille: Nombre d'octets
+    But:
+        Écrire un bloc complet (un seul appel write dans le cas normal)
+    Retour:
+        0 si succès, -1 sinon
+    */
+    while (taille > 0) {
+        ssize_t n = write(fd, donnees, taille);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        STATS_OCTETS_ECRITS((size_t)n);
+        donnees += n;
+        taille -= (size_t)n;
+    }
+    return 0;
+}
+
+static void desactiver(const char* raison) {
+    /*
+    Argument:
+        raison: Message d'erreur
+    But:
+        Fermer le journal après une erreur d'écriture : les sauvegardes
+        suivantes redeviennent des réécritures complètes
+    Retour:
+        Aucun
+    */
+    fprintf(stderr, "[!] Erreur : %s (%s), journal des operations desactive.\n", raison, chemin_journal);
+    close(fd);
+    fd = -1;
+    attache = false;
+    segment_ouvert = false;
+}
+
+static int ajouter_enregistrement(unsigned char* enregistrement, uint8_t type, size_t taille_charge) {
+    /*
+    Argument:
+        enregistrement: Tampon (en-tête + charge déjà placée)
+        type: Type de l'enregistrement
+        taille_charge: Longueur de la charge
+    But:
+        Sceller puis ajouter l'enregistrement en fin de journal
+    Retour:
+        0 si succès, -1 sinon (journal désactivé)
+    */
+    size_t total = sceller(enregistrement, type, taille_charge);
+    if (ecrire_tout(enregistrement, total) != 0) {
+        desactiver("Ecriture impossible");
+        return -1;
+    }
+    taille_journal += total;
+    return 0;
+}
+
+static int ajouter_marqueur(uint8_t type) {
+    /*
+    Argument:
+        type: OP_BASE_VIDE ou OP_VALIDATION (enregistrements sans charge)
+    But:
+        Ajouter un marqueur en fin de journal
+    Retour:
+        0 si succès, -1 sinon
+    */
+    unsigned char enregistrement[TAILLE_ENTETE_OP];
+    return ajouter_enregistrement(enregistrement, type, 0);
+}
+
+static bool preparer_ecriture(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Vérifier que le journal est utilisable. Un inventaire détaché (aucune
+        sauvegarde de référence) commence par un BASE_VIDE pour pouvoir être rejoué
+    Retour:
+        true si l'opération peut être ajoutée
+    */
+    if (fd < 0) return false;
+    if (!attache && !segment_ouvert) {
+        if (ajouter_marqueur(OP_BASE_VIDE) != 0) return false;
+        segment_ouvert = true;
+    }
+    return true;
+}
+
+static unsigned char* poser(unsigned char* p, const void* valeur, size_t taille) {
+    /*
+    Argument:
+        p: Position d'écriture
+        valeur: Octets à copier
+        taille: Nombre d'octets
+    But:
+        Copier une valeur dans la charge
+    Retour:
+        Position suivante
+    */
+    memcpy(p, valeur, taille);
+    return p + taille;
+}
+
+static void journaliser_produit(uint8_t type, const Produit* produit) {
+    /*
+    Argument:
+        type: OP_INSERTION ou OP_MODIFICATION
+        produit: Produit dans son nouvel état
+    But:
+        Ajouter un enregistrement contenant tous les champs du produit
+    Retour:
+        Aucun
+    */
+    if (produit == NULL || !preparer_ecriture()) return;
+
+    const char* champs[4] = {
+        produit->nom ? produit->nom : "Inconnu",
+        produit->description ? produit->description : "",
+        produit->categorie ? produit->categorie : "Divers",
+        produit->note ? produit->note : ""
+    };
+    uint32_t longueurs[4];
+    size_t taille_charge = 4 + 4 + 4 + 8;
+    for (int i = 0; i < 4; i++) {
+        longueurs[i] = (uint32_t)strlen(champs[i]);
+        taille_charge += 4 + (size_t)longueurs[i] + 1;
+    }
+
+    unsigned char pile[TAILLE_PILE_OP];
+    unsigned char* tampon = pile;
+    if (TAILLE_ENTETE_OP + taille_charge > sizeof(pile)) {
+        tampon = (unsigned char*)malloc(TAILLE_ENTETE_OP + taille_charge);
+        if (tampon == NULL) {
+            desactiver("Echec allocation memoire");
+            return;
+        }
+    }
+
+    int32_t quantite = produit->quantite;
+    int64_t date = (int64_t)produit->date_peremption;
+    unsigned char* p = tampon + TAILLE_ENTETE_OP;
+    p = poser(p, &produit->id, 4);
+    p = poser(p, &quantite, 4);
+    p = poser(p, &produit->prix_unitaire, 4);
+    p = poser(p, &date, 8);
+    for (int i = 0; i < 4; i++) {
+        p = poser(p, &longueurs[i], 4);
+        p = poser(p, champs[i], (size_t)longueurs[i] + 1);
+    }
+
+    ajouter_enregistrement(tampon, type, taille_charge);
+    if (tampon != pile) free(tampon);
+}
+
+void journal_ops_insertion(const Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui vient d'être inséré dans l'inventaire
+    But:
+        Journaliser l'insertion
+    Retour:
+        Aucun
+    */
+    journaliser_produit(OP_INSERTION, produit);
+}
+
+void journal_ops_modification(const Produit* produit) {
+    /*
+    Argument:
+        produit: Produit qui vient d'être modifié
+    But:
+        Journaliser le nouvel état complet du produit
+    Retour:
+        Aucun
+    */
+    journaliser_produit(OP_MODIFICATION, produit);
+}
+
+void journal_ops_suppression(uint32_t id) {
+    /*
+    Argument:
+        id: Identifiant du produit supprimé
+    But:
+        Journaliser la suppression
+    Retour:
+        Aucun
+    */
+    if (!preparer_ecriture()) return;
+    unsigned char enregistrement[TAILLE_ENTETE_OP + 4];
+    memcpy(enregistrement + TAILLE_ENTETE_OP, &id, 4);
+    ajouter_enregistrement(enregistrement, OP_SUPPRESSION, 4);
+}
+
+static int identite_fichier(const char* chemin, IdentiteFichier* identite) {
+    /*
+    Argument:
+        chemin: Fichier de sauvegarde
+        identite: Identité relevée
+    But:
+        Relever inode, taille et date de modification, pour vérifier que le
+        journal s'applique bien à ce fichier et pas à une autre version
+    Retour:
+        0 si succès, -1 si le fichier est absent
+    */
+    struct stat infos;
+    if (stat(chemin, &infos) != 0) return -1;
+    memset(identite, 0, sizeof(IdentiteFichier));
+    identite->inode = (uint64_t)infos.st_ino;
+    identite->taille = (uint64_t)infos.st_size;
+    identite->modif_s = (int64_t)infos.st_mtim.tv_sec;
+    identite->modif_ns = (int64_t)infos.st_mtim.tv_nsec;
+    return 0;
+}
+
+static bool meme_identite(const IdentiteFichier* a, const IdentiteFichier* b) {
+    /*
+    Argument:
+        a, b: Identités à comparer
+    But:
+        Comparer deux identités de fichier
+    Retour:
+        true si elles sont identiques
+    */
+    return a->inode == b->inode && a->taille == b->taille
+        && a->modif_s == b->modif_s && a->modif_ns == b->modif_ns;
+}
+
+static int tronquer(size_t taille) {
+    /*
+    Argument:
+        taille: Nouvelle taille du journal
+    But:
+        Couper la fin du journal (opérations abandonnées ou enregistrement incomplet)
+    Retour:
+        0 si succès, -1 sinon (journal désactivé)
+    */
+    if (ftruncate(fd, (off_t)taille) != 0) {
+        desactiver("Troncature impossible");
+        return -1;
+    }
+    taille_journal = taille;
+    if (fin_validee > taille) fin_validee = taille;
+    return 0;
+}
+
+static int reinitialiser(const IdentiteFichier* base) {
+    /*
+    Argument:
+        base: Identité du fichier de sauvegarde qui sert de point de départ,
+              ou NULL si l'inventaire n'a pas de sauvegarde de référence
+    But:
+        Repartir d'un journal vide (compaction) : en-tête, puis BASE_FICHIER
+        et VALIDATION si une sauvegarde de référence existe
+    Retour:
+        0 si succès, -1 sinon (journal désactivé)
+    */
+    unsigned char tampon[TAILLE_ENTETE + 2 * TAILLE_ENTETE_OP + sizeof(IdentiteFichier)];
+    uint32_t version = VERSION_JOURNAL;
+    uint32_t reserve = 0;
+    memcpy(tampon, MAGIE_JOURNAL, 8);
+    memcpy(tampon + 8, &version, 4);
+    memcpy(tampon + 12, &reserve, 4);
+    size_t taille = TAILLE_ENTETE;
+    if (base != NULL) {
+        memcpy(tampon + taille + TAILLE_ENTETE_OP, base, sizeof(IdentiteFichier));
+        taille += sceller(tampon + taille, OP_BASE_FICHIER, sizeof(IdentiteFichier));
+        taille += sceller(tampon + taille, OP_VALIDATION, 0);
+    }
+
+    if (ftruncate(fd, 0) != 0 || ecrire_tout(tampon, taille) != 0 || fsync(fd) != 0) {
+        desactiver("Reinitialisation impossible");
+        return -1;
+    }
+    taille_journal = taille;
+    fin_validee = taille;
+    attache = (base != NULL);
+    segment_ouvert = false;
+    taille_base = (base != NULL) ? base->taille : 0;
+    return 0;
+}
+
+static int lire_journal(unsigned char** donnees, size_t* taille) {
+    /*
+    Argument:
+        donnees: Contenu lu (à libérer par l'appelant)
+        taille: Nombre d'octets lus
+    But:
+        Lire tout le journal en mémoire (sa taille reste bornée par la compaction)
+    Retour:
+        0 si succès, -1 sinon
+    */
+    struct stat infos;
+    if (fstat(fd, &infos) != 0) return -1;
+
+    size_t total = (size_t)infos.st_size;
+    unsigned char* tampon = (unsigned char*)malloc(total > 0 ? total : 1);
+    if (tampon == NULL) return -1;
+
+    size_t lu = 0;
+    while (lu < total) {
+        ssize_t n = pread(fd, tampon + lu, total - lu, (off_t)lu);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        lu += (size_t)n;
+    }
+    STATS_OCTETS_LUS(lu);
+    *donnees = tampon;
+    *taille = lu;
+    return 0;
+}
+
+static int analyser_journal(const unsigned char* donnees, size_t taille, EtatJournal* etat) {
+    /*
+    Argument:
+        donnees: Contenu du journal
+        taille: Nombre d'octets
+        etat: Résumé rempli par l'analyse
+    But:
+        Vérifier l'en-tête puis parcourir les enregistrements jusqu'au premier
+        enregistrement incomplet ou abîmé
+    Retour:
+        0 si l'en-tête est valide, -1 sinon
+    */
+    uint32_t version;
+    if (taille < TAILLE_ENTETE || memcmp(donnees, MAGIE_JOURNAL, 8) != 0) return -1;
+    memcpy(&version, donnees + 8, 4);
+    if (version != VERSION_JOURNAL) return -1;
+
+    memset(etat, 0, sizeof(EtatJournal));
+    etat->fin_validee = TAILLE_ENTETE;
+    etat->debut_vide = -1;
+
+    size_t pos = TAILLE_ENTETE;
+    while (taille - pos >= TAILLE_ENTETE_OP) {
+        uint32_t longueur, somme;
+        memcpy(&longueur, donnees + pos, 4);
+        memcpy(&somme, donnees + pos + 4, 4);
+        uint8_t type = donnees[pos + 8];
+        const unsigned char* charge = donnees + pos + TAILLE_ENTETE_OP;
+
+        if (longueur > taille - pos - TAILLE_ENTETE_OP) break;
+        if (somme_operation(type, charge, longueur) != somme) break;
+        size_t fin = pos + TAILLE_ENTETE_OP + longueur;
+
+        if (type == OP_BASE_FICHIER) {
+            if (pos != TAILLE_ENTETE || longueur != sizeof(IdentiteFichier)) break;
+            memcpy(&etat->base, charge, sizeof(IdentiteFichier));
+            etat->a_base = true;
+        } else if (type == OP_BASE_VIDE) {
+            etat->debut_vide = (long)fin;
+        } else if (type == OP_VALIDATION) {
+            etat->fin_validee = fin;
+            etat->debut_vide = -1;
+            etat->nb_valides += etat->nb_non_valides;
+            etat->nb_non_valides = 0;
+        } else if (type >= OP_INSERTION && type <= OP_SUPPRESSION) {
+            etat->nb_non_valides++;
+        } else {
+            break;
+        }
+        pos = fin;
+    }
+    etat->fin_valide = pos;
+    return 0;
+}
+
+static bool lire_champ(const unsigned char** p, const unsigned char* fin, const char** champ) {
+    /*
+    Argument:
+        p: Position de lecture (avancée)
+        fin: Fin de la charge
+        champ: Chaîne lue (pointe dans la charge)
+    But:
+        Lire une chaîne préfixée par sa longueur et terminée par '\0'
+    Retour:
+        true si la chaîne est bien formée
+    */
+    uint32_t longueur;
+    if (fin - *p < 4) return false;
+    memcpy(&longueur, *p, 4);
+    *p += 4;
+    if ((size_t)(fin - *p) <= longueur || (*p)[longueur] != '\0') return false;
+    *champ = (const char*)*p;
+    *p += (size_t)longueur + 1;
+    return true;
+}
+
+static bool decoder_produit(const unsigned char* charge, size_t taille, OperationProduit* op) {
+    /*
+    Argument:
+        charge: Charge d'un enregistrement OP_INSERTION ou OP_MODIFICATION
+        taille: Longueur de la charge
+        op: Champs décodés
+    But:
+        Relire les champs d'un produit journalisé
+    Retour:
+        true si la charge est bien formée
+    */
+    const unsigned char* p = charge;
+    const unsigned char* fin = charge + taille;
+    if (taille < 20) return false;
+    memcpy(&op->id, p, 4);
+    memcpy(&op->quantite, p + 4, 4);
+    memcpy(&op->prix_unitaire, p + 8, 4);
+    memcpy(&op->date_peremption, p + 12, 8);
+    p += 20;
+    for (int i = 0; i < 4; i++) {
+        if (!lire_champ(&p, fin, &op->champs[i])) return false;
+    }
+    return p == fin;
+}
+
+static size_t fin_insertions(const unsigned char* donnees, size_t pos, size_t fin, size_t* nombre) {
+    /*
+    Argument:
+        donnees: Contenu du journal (déjà analysé)
+        pos: Début d'un enregistrement OP_INSERTION
+        fin: Fin de la zone à rejouer
+        nombre: Nombre d'insertions consécutives trouvées
+    But:
+        Mesurer la série d'insertions qui commence à pos (import, saisie en
+        rafale) sans décoder les charges
+    Retour:
+        Position du premier enregistrement qui n'est pas une insertion
+    */
+    *nombre = 0;
+    while (pos < fin && donnees[pos + 8] == OP_INSERTION) {
+        uint32_t longueur;
+        memcpy(&longueur, donnees + pos, 4);
+        pos += TAILLE_ENTETE_OP + longueur;
+        (*nombre)++;
+    }
+    return pos;
+}
+
+static size_t rejouer_lot(const unsigned char* donnees, size_t debut, size_t fin, Produit** head, uint32_t* max_id, size_t* ignorees) {
+    /*
+    Argument:
+        donnees: Contenu du journal (déjà analysé)
+        debut, fin: Série d'enregistrements OP_INSERTION
+        head: pointeur d'un pointeur vers la tête de la liste
+        max_id: Compteur d'ID global, relevé au plus grand ID inséré
+        ignorees: Incrémenté pour chaque insertion illisible ou refusée
+    But:
+        Rejouer la série comme un chargement : un seul passage par index
+        (insertion_lot) au lieu d'une insertion triée par produit. Le lot est
+        raccordé à l'envers pour que la liste finisse dans le même ordre
+        qu'avec des insertions une par une
+    Retour:
+        Nombre d'insertions appliquées (aucune si la mémoire manque pour les index)
+    */
+    LotProduits lot;
+    lot_initialiser(&lot);
+    lot.inverser = true;
+
+    for (size_t pos = debut; pos < fin;) {
+        uint32_t longueur;
+        memcpy(&longueur, donnees + pos, 4);
+        const unsigned char* charge = donnees + pos + TAILLE_ENTETE_OP;
+        pos += TAILLE_ENTETE_OP + longueur;
+
+        OperationProduit op;
+        if (!decoder_produit(charge, longueur, &op)) {
+            (*ignorees)++;
+            continue;
+        }
+        Produit* p = creer_produit(op.id, op.champs[0], op.champs[1], op.champs[2], op.quantite,
+                                   op.prix_unitaire, (time_t)op.date_peremption, op.champs[3]);
+        if (p == NULL || lot_ajouter(&lot, p) != 0) {
+            liberer_produit(p);
+            (*ignorees)++;
+        }
+    }
+
+    size_t nb = lot.nombre;
+    uint32_t lot_max_id = lot.max_id;
+    if (insertion_lot(head, &lot) != 0) {
+        fprintf(stderr, "[!] Erreur : Memoire insuffisante, %zu insertions du journal non rejouees.\n", nb);
+        return 0;
+    }
+    if (max_id != NULL && lot_max_id > *max_id) *max_id = lot_max_id;
+    return nb;
+}
+
+static size_t rejouer(const unsigned char* donnees, size_t debut, size_t fin, Produit** head, uint32_t* max_id, size_t* ignorees) {
+    /*
+    Argument:
+        donnees: Contenu du journal (déjà analysé)
+        debut, fin: Zone d'enregistrements à rejouer
+        head: pointeur d'un pointeur vers la tête de la liste
+        max_id: Compteur d'ID global, relevé au plus grand ID inséré
+        ignorees: Nombre d'opérations illisibles ou refusées (somme valide
+                  mais charge mal formée, ID inconnu ou déjà pris)
+    But:
+        Appliquer les opérations à l'inventaire en un seul passage, sans les
+        journaliser à nouveau. Une longue série d'insertions passe par
+        rejouer_lot ; le reste est appliqué opération par opération
+    Retour:
+        Nombre d'opérations appliquées
+    */
+    size_t nb = 0;
+    size_t pos = debut;
+    size_t fin_serie = debut; // fin de la dernière série d'insertions mesurée
+    activer_journalisation(false);
+
+    while (pos < fin) {
+        uint32_t longueur;
+        memcpy(&longueur, donnees + pos, 4);
+        uint8_t type = donnees[pos + 8];
+
+        if (type == OP_INSERTION && pos >= fin_serie) {
+            size_t nombre;
+            size_t debut_serie = pos;
+            fin_serie = fin_insertions(donnees, pos, fin, &nombre);
+            // Chaque lot reparcourt le tas et la table des trigrammes : il ne
+            // paie que si la série est longue devant l'inventaire déjà chargé
+            if (nombre >= SEUIL_LOT_REPRISE && nombre >= colonnes_taille() / 4) {
+                nb += rejouer_lot(donnees, debut_serie, fin_serie, head, max_id, ignorees);
+                pos = fin_serie;
+                continue;
+            }
+        }
+
+        const unsigned char* charge = donnees + pos + TAILLE_ENTETE_OP;
+        pos += TAILLE_ENTETE_OP + longueur;
+
+        OperationProduit op;
+        if (type == OP_SUPPRESSION) {
+            uint32_t id;
+            if (longueur == 4) memcpy(&id, charge, 4);
+            if (longueur == 4 && suppression_par_id(head, id) == 0) {
+                nb++;
+            } else {
+                (*ignorees)++;
+            }
+        } else if (type == OP_INSERTION || type == OP_MODIFICATION) {
+            if (!decoder_produit(charge, longueur, &op)) {
+                (*ignorees)++;
+                continue;
+            }
+            if (type == OP_INSERTION) {
+                Produit* p = creer_produit(op.id, op.champs[0], op.champs[1], op.champs[2], op.quantite,
+                                           op.prix_unitaire, (time_t)op.date_peremption, op.champs[3]);
+                if (p == NULL || insertion(head, p) != 0) {
+                    liberer_produit(p);
+                    (*ignorees)++;
+                    continue;
+                }
+                if (max_id != NULL && op.id > *max_id) *max_id = op.id;
+            } else {
+                Produit* p = index_id_chercher(op.id);
+                if (p == NULL || modifier_produit(p, op.champs[0], op.champs[1], op.champs[2], op.quantite,
+                                                  op.prix_unitaire, (time_t)op.date_peremption, op.champs[3]) == NULL) {
+                    (*ignorees)++;
+                    continue;
+                }
+            }
+            nb++;
+        }
+    }
+
+    activer_journalisation(true);
+    return nb;
+}
+
+static int reprendre(const unsigned char* donnees, const EtatJournal* etat, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        donnees: Contenu du journal
+        etat: Résumé du journal (opérations non validées présentes)
+        head: pointeur d'un pointeur vers la tête de la liste (vide)
+        max_id: Compteur d'ID global
+    But:
+        Reconstruire l'inventaire de la session interrompue : soit depuis un
+        inventaire vide (BASE_VIDE), soit depuis le fichier de sauvegarde s'il
+        n'a pas changé depuis, puis rejouer toutes les opérations
+    Retour:
+        0 si succès, -1 si les opérations n'ont pas pu être reprises
+    */
+    size_t debut;
+    if (etat->debut_vide >= 0) {
+        debut = (size_t)etat->debut_vide;
+        segment_ouvert = true;
+    } else {
+        IdentiteFichier actuelle;
+        if (!etat->a_base || identite_fichier(chemin_sauvegarde, &actuelle) != 0
+            || !meme_identite(&actuelle, &etat->base)) {
+            fprintf(stderr, "[!] Erreur : %s a change depuis l'arret, %zu operations non sauvegardees perdues.\n",
+                    chemin_sauvegarde, etat->nb_non_valides);
+            reinitialiser(NULL);
+            return -1;
+        }
+        charger_fichier(head, chemin_sauvegarde, max_id);
+        debut = TAILLE_ENTETE;
+        attache = true;
+        taille_base = actuelle.taille;
+    }
+
+    uint64_t debut_rejeu = stats_horloge();
+    size_t ignorees = 0;
+    size_t nb = rejouer(donnees, debut, etat->fin_valide, head, max_id, &ignorees);
+    printf("[i] Reprise apres arret inattendu : %zu operations rejouees depuis %s en %.3f s\n", nb, chemin_journal,
+           (double)(stats_horloge() - debut_rejeu) / 1e9);
+    if (ignorees > 0) {
+        fprintf(stderr, "[!] Attention : %zu operations du journal illisibles ou refusees, ignorees a la reprise.\n", ignorees);
+    }
+    ajouter_log(HISTORIQUE_REPRISE, nb, 0, chemin_journal);
+    return 0;
+}
+
+int journal_ops_ouvrir(const char* fichier_sauvegarde, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        fichier_sauvegarde: Fichier de sauvegarde texte (le journal est "<fichier>.journal")
+        head: pointeur d'un pointeur vers la tête de la liste (vide au démarrage)
+        max_id: Compteur d'ID global
+    But:
+        Ouvrir ou créer le journal. S'il contient des opérations non validées,
+        la session précédente s'est arrêtée sans quitter : elles sont rejouées
+    Retour:
+        0 si succès, -1 si le journal est inutilisable (sauvegardes complètes uniquement)
+    */
+    if (fd >= 0) return 0;
+    if (snprintf(chemin_sauvegarde, sizeof(chemin_sauvegarde), "%s", fichier_sauvegarde) >= (int)sizeof(chemin_sauvegarde)
+        || snprintf(chemin_journal, sizeof(chemin_journal), "%s.journal", fichier_sauvegarde) >= (int)sizeof(chemin_journal)) {
+        fprintf(stderr, "[!] Erreur : Chemin de sauvegarde trop long.\n");
+        return -1;
+    }
+
+    fd = open(chemin_journal, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[!] Erreur : Impossible d'ouvrir %s, sauvegardes completes uniquement.\n", chemin_journal);
+        return -1;
+    }
+    attache = false;
+    segment_ouvert = false;
+
+    unsigned char* donnees;
+    size_t taille;
+    if (lire_journal(&donnees, &taille) != 0) {
+        desactiver("Lecture impossible");
+        return -1;
+    }
+
+    EtatJournal etat;
+    if (analyser_journal(donnees, taille, &etat) != 0) {
+        if (taille > 0) {
+            fprintf(stderr, "[!] Erreur : %s illisible, journal reinitialise.\n", chemin_journal);
+        }
+        free(donnees);
+        return reinitialiser(NULL);
+    }
+
+    taille_journal = taille;
+    fin_validee = etat.fin_validee;
+    int res = 0;
+    if (etat.nb_non_valides > 0) {
+        // Enregistrement incomplet en fin de fichier : coupé avant d'ajouter la suite
+        if (etat.fin_valide < taille) res = tronquer(etat.fin_valide);
+        if (res == 0) res = reprendre(donnees, &etat, head, max_id);
+    } else if (taille > etat.fin_validee) {
+        res = tronquer(etat.fin_validee);
+    }
+    free(donnees);
+    return res;
+}
+
+static int charger(Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste (vide)
+        max_id: Compteur d'ID global, relevé pendant le chargement
+    But:
+        Recharger l'état sauvegardé : fichier de sauvegarde puis opérations
+        validées du journal. Les opérations non sauvegardées sont abandonnées
+    Retour:
+        0 si succès, -1 si le journal est inutilisable (fichier seul chargé)
+    */
+    if (fd < 0) {
+        charger_fichier(head, chemin_sauvegarde, max_id);
+        return -1;
+    }
+
+    unsigned char* donnees = NULL;
+    size_t taille = 0;
+    EtatJournal etat;
+    bool lisible = (lire_journal(&donnees, &taille) == 0 && analyser_journal(donnees, taille, &etat) == 0);
+
+    IdentiteFichier actuelle;
+    bool present = (identite_fichier(chemin_sauvegarde, &actuelle) == 0);
+    charger_fichier(head, chemin_sauvegarde, max_id);
+
+    int res;
+    if (lisible && etat.a_base && present && meme_identite(&actuelle, &etat.base)) {
+        res = tronquer(etat.fin_validee);
+        if (res == 0) {
+            attache = true;
+            segment_ouvert = false;
+            taille_base = actuelle.taille;
+            size_t ignorees = 0;
+            rejouer(donnees, TAILLE_ENTETE, etat.fin_validee, head, max_id, &ignorees);
+            if (ignorees > 0) {
+                fprintf(stderr, "[!] Attention : %zu operations validees du journal illisibles ou refusees, ignorees au chargement.\n", ignorees);
+            }
+        }
+    } else {
+        if (lisible && etat.nb_valides > 0) {
+            printf("[i] Info : %s ne correspond pas a %s, journal ignore.\n", chemin_journal, chemin_sauvegarde);
+        }
+        res = reinitialiser(present ? &actuelle : NULL);
+    }
+    free(donnees);
+    return res;
+}
+
+int journal_ops_charger(Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        head: pointeur d'un pointeur vers la tête de la liste (vide)
+        max_id: Compteur d'ID global, relevé pendant le chargement
+    But:
+        Recharger l'état sauvegardé (voir charger) en mesurant la durée du chargement
+    Retour:
+        0 si succès, -1 si le journal est inutilisable (fichier seul chargé)
+    */
+    STATS_DEBUT(debut);
+    int res = charger(head, max_id);
+    STATS_FIN(STATS_CHARGEMENT, debut);
+    return res;
+}
+
+static int sauvegarder(Produit* head) {
+    /*
+    Argument:
+        head: Pointeur vers la tête de la liste
+    But:
+        Sauvegarder l'inventaire. Si le journal décrit déjà l'inventaire depuis
+        la dernière sauvegarde, il suffit d'y ajouter une validation (+ fsync).
+        Sinon, ou s'il dépasse la moitié du fichier (1 Mo minimum), le fichier
+        est réécrit entièrement et le journal repart à zéro (compaction)
+    Retour:
+        0 si succès, -1 sinon
+    */
+    uint64_t seuil = (taille_base / 2 > SEUIL_COMPACTION_MIN) ? taille_base / 2 : SEUIL_COMPACTION_MIN;
+    if (fd >= 0 && attache && taille_journal < seuil) {
+        if (ajouter_marqueur(OP_VALIDATION) == 0 && fsync(fd) == 0) {
+            fin_validee = taille_journal;
+            return 0;
+        }
+        // Échec : on retombe sur une sauvegarde complète
+    }
+
+    if (sauvegarde(head, chemin_sauvegarde) != 0) return -1;
+    if (fd < 0) return 0;
+
+    IdentiteFichier identite;
+    if (identite_fichier(chemin_sauvegarde, &identite) != 0) {
+        desactiver("Sauvegarde introuvable apres ecriture");
+        return 0;
+    }
+    reinitialiser(&identite);
+    return 0;
+}
+
+int journal_ops_sauvegarder(Produit* head) {
+    /*
+    Argument:
+        head: Pointeur vers la tête de la liste
+    But:
+        Sauvegarder l'inventaire (voir sauvegarder) en mesurant la durée de la sauvegarde
+    Retour:
+        0 si succès, -1 sinon
+    */
+    STATS_DEBUT(debut);
+    int res = sauvegarder(head);
+    STATS_FIN(STATS_SAUVEGARDE, debut);
+    return res;
+}
+
+void journal_ops_fermer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Fermeture normale : les opérations non sauvegardées sont abandonnées,
+        comme quand on quitte sans sauvegarder
+    Retour:
+        Aucun
+    */
+    if (fd < 0) return;
+    if (taille_journal > fin_validee && tronquer(fin_validee) != 0) return;
+    close(fd);
+    fd = -1;
+    attache = false;
+    segment_ouvert = false;
+}
@@ -0,0 +1,31 @@
+#ifndef _JOURNAL_OPS_H
+#define _JOURNAL_OPS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gestion_produit.h"
+
+/*
+    Journal des opérations (fichier "<sauvegarde>.journal") :
+    - Chaque insertion, modification et suppression y est ajoutée à la fin
+      (un seul write par opération), avec tous les champs du produit.
+    - L'état sauvegardé = fichier de sauvegarde + opérations validées du journal.
+      Une sauvegarde ajoute un simple enregistrement de validation (+ fsync) ;
+      le fichier texte n'est réécrit (compaction) que lorsque le journal devient
+      trop gros par rapport à lui.
+    - Au démarrage, des opérations non validées signalent un arrêt inattendu :
+      elles sont rejouées pour ne rien perdre.
+    - Quitter normalement sans sauvegarder abandonne les opérations non validées,
+      comme avant.
+*/
+
+int journal_ops_ouvrir(const char* fichier_sauvegarde, Produit** head, uint32_t* max_id);
+void journal_ops_insertion(const Produit* produit);
+void journal_ops_modification(const Produit* produit);
+void journal_ops_suppression(uint32_t id);
+int journal_ops_charger(Produit** head, uint32_t* max_id);
+int journal_ops_sauvegarder(Produit* head);
+void journal_ops_fermer(void);
+
+#endif
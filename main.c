@@ -13,39 +13,82 @@ But : Point d'entrée de l'application BGRS. Gère la boucle principale,
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
-#include <ctype.h>
+#include <float.h>
+#include <unistd.h>
 #include "gestion_produit.h"
 #include "gestion_db.h"
+#include "colonnes.h"
+#include "index_nom.h"
+#include "categories.h"
+#include "index_tri.h"
+#include "journal.h"
+#include "historique.h"
+#include "journal_ops.h"
+#include "commandes.h"
+#include "serveur.h"
+#include "rendu.h"
+#include "stats.h"
 #include "utils.h" 
 
 static void afficher(Produit** head);
 static void ajouter(Produit** head, uint32_t* max_id);
 static void supprimer(Produit** head);
 static void modifier(Produit* head);
-static void rechercher(Produit* head);
+static void rechercher(void);
 static void sauvegarder(Produit* head);
 static void charger(Produit** head, uint32_t* max_id);
-static uint32_t recalculer_max_id(Produit* head);
 static void generer_loot(Produit** head, uint32_t* max_id);
-static void supprimer_perimes(Produit** head);
+static void nettoyer_perimes(Produit** head);
+static void resume_stock(void);
+static void afficher_categorie(void);
+static void afficher_statistiques(void);
+static void afficher_tri(void);
+static void afficher_peremptions(void);
+static void lire_configuration(void);
+static int mode_commandes(int argc, char* argv[]);
+static int mode_serveur(int argc, char* argv[]);
+static int mode_historique(int argc, char* argv[]);
 
+#define FICHIER_SAUVEGARDE "inventaire_sauvegarde.txt"
+#define TAILLE_TAMPON_COMMANDES (1024 * 1024)
+#define FICHES_PAR_PAGE 20 // pagination de l'affichage dans un terminal
 
-int main() {
+static unsigned int champs_affichage = RENDU_DEFAUT;
+
+
+int main(int argc, char* argv[]) {
     /*
     But :
         Fonction principale du programme
         Initialise les structures
         lance le menu et gère la fermeture 
+        (ou exécute un script avec --commandes, sert des clients avec --serveur,
+        ou relit l'historique avec --historique)
     Arguments :
-        Aucun
+        argc, argv : aucun argument pour le menu, "--commandes [fichier]" pour le
+                     mode commandes, "--serveur [socket]" pour le mode serveur,
+                     "--historique [filtres] [fichier]" pour le lecteur d'historique
     Retour :
         0 si le programme s'est terminé correctement.
     */
+    if (argc > 1 && strcmp(argv[1], "--serveur") == 0) {
+        return mode_serveur(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--historique") == 0) {
+        return mode_historique(argc, argv);
+    }
+    if (argc > 1) {
+        return mode_commandes(argc, argv);
+    }
+
     Produit* head = NULL;
     uint32_t max_id = 0;
     bool running = true;
     long choix;
 
+    lire_configuration();
+    journal_ops_ouvrir(FICHIER_SAUVEGARDE, &head, &max_id);
+
     while (running) {
         printf("\n=== Bureau de Gestion des Ressources de Soin (BGRS) ===\n");
         printf("1. Afficher l'inventaire\n");
@@ -57,6 +100,11 @@ int main() {
         printf("7. Charger un inventaire\n");
         printf("8. Charger le loot de depart\n");
         printf("9. Quitter\n");
+        printf("10. Resume du stock\n");
+        printf("11. Afficher une categorie\n");
+        printf("12. Statistiques\n");
+        printf("13. Produits tries (prix, quantite, peremption)\n");
+        printf("14. Peremptions a venir\n");
         printf("-------------------------------------------------------\n");
         printf("Votre choix : ");
 
@@ -64,44 +112,281 @@ int main() {
             printf("Erreur : En-trée invalide. Veuillez entrer un chiffre.\n");
             continue;
         }
-        supprimer_perimes(&head);
+        nettoyer_perimes(&head);
 
         switch (choix) {
             case 1: afficher(&head); break;
             case 2: ajouter(&head, &max_id); break;
             case 3: supprimer(&head); break;
             case 4: modifier(head); break;
-            case 5: rechercher(head); break;
+            case 5: rechercher(); break;
             case 6: sauvegarder(head); break;
             case 7: charger(&head, &max_id); break;
             case 8: generer_loot(&head, &max_id); break;
+            case 10: resume_stock(); break;
+            case 11: afficher_categorie(); break;
+            case 12: afficher_statistiques(); break;
+            case 13: afficher_tri(); break;
+            case 14: afficher_peremptions(); break;
             case 9:
                 printf("Fermeture du BGRS...\n");
+                journal_ops_fermer();
                 free_struct_produit(head); 
+                journal_fermer();
                 running = false;
                 break;
             default:
-                printf("Option inconnue. Veuillez choisir entre 1 et 8.\n");
+                printf("Option inconnue. Veuillez choisir entre 1 et 14.\n");
         }
     }
     return 0;
 }
 
 
+static int mode_commandes(int argc, char* argv[]) {
+    /*
+    Argument:
+        argc, argv: Arguments du programme ("--commandes" puis un fichier, "-" ou rien pour stdin)
+    But:
+        Exécuter un script de commandes sans menu (voir commandes.h), puis
+        fermer comme "Quitter" et afficher le débit sur la sortie d'erreur
+    Retour:
+        0 si toutes les commandes ont réussi, 1 si au moins une a échoué,
+        2 si les arguments ou le fichier sont invalides
+    */
+    if (strcmp(argv[1], "--commandes") != 0 || argc > 3) {
+        fprintf(stderr, "Usage : %s [--commandes [fichier] | --serveur [socket] | --historique [--id ID] [--debut DATE] [--fin DATE] [fichier]]\n", argv[0]);
+        return 2;
+    }
+    FILE* entree = stdin;
+    if (argc == 3 && strcmp(argv[2], "-") != 0) {
+        entree = fopen(argv[2], "r");
+        if (entree == NULL) {
+            fprintf(stderr, "[!] Erreur : Impossible d'ouvrir %s\n", argv[2]);
+            return 2;
+        }
+    }
+
+    // Tampon complet posé avant toute écriture : les réponses partent par gros blocs
+    setvbuf(stdout, NULL, _IOFBF, TAILLE_TAMPON_COMMANDES);
+
+    Produit* head = NULL;
+    uint32_t max_id = 0;
+    lire_configuration();
+    journal_ops_ouvrir(FICHIER_SAUVEGARDE, &head, &max_id);
+
+    struct timespec debut, fin;
+    BilanCommandes bilan;
+    clock_gettime(CLOCK_MONOTONIC, &debut);
+    int res = commandes_executer(entree, stdout, &head, &max_id, &bilan);
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    fflush(stdout);
+
+    double secondes = (double)(fin.tv_sec - debut.tv_sec) + (double)(fin.tv_nsec - debut.tv_nsec) / 1e9;
+    fprintf(stderr, "[INFO] %zu commandes (%zu erreurs, %zu perimes retires) en %.3f s",
+            bilan.nb_commandes, bilan.nb_erreurs, bilan.nb_perimes, secondes);
+    if (secondes > 0.0) fprintf(stderr, " - %.0f commandes/s", (double)bilan.nb_commandes / secondes);
+    fprintf(stderr, "\n");
+
+    if (entree != stdin) fclose(entree);
+    journal_ops_fermer();
+    free_struct_produit(head);
+    journal_fermer();
+    return (res == 0) ? 0 : 1;
+}
+
+static int mode_serveur(int argc, char* argv[]) {
+    /*
+    Argument:
+        argc, argv: Arguments du programme ("--serveur" puis éventuellement le chemin de la socket)
+    But:
+        Charger l'inventaire comme au démarrage du menu, le servir sur une
+        socket Unix jusqu'à SIGINT/SIGTERM, puis fermer comme "Quitter"
+    Retour:
+        0 après un arrêt normal, 2 si les arguments sont invalides ou si le
+        serveur n'a pas pu démarrer
+    */
+    if (argc > 3) {
+        fprintf(stderr, "Usage : %s --serveur [socket]\n", argv[0]);
+        return 2;
+    }
+    const char* chemin = (argc == 3) ? argv[2] : SOCKET_SERVEUR_DEFAUT;
+
+    Produit* head = NULL;
+    uint32_t max_id = 0;
+    lire_configuration();
+    journal_ops_ouvrir(FICHIER_SAUVEGARDE, &head, &max_id);
+
+    int res = serveur_executer(chemin, &head, &max_id);
+
+    journal_ops_fermer();
+    free_struct_produit(head);
+    journal_fermer();
+    return (res == 0) ? 0 : 2;
+}
+
+static int mode_historique(int argc, char* argv[]) {
+    /*
+    Argument:
+        argc, argv: "--historique", puis éventuellement "--id ID", "--debut DATE",
+                    "--fin DATE" (epoch ou AAAA-MM-JJ[ HH:MM:SS], fin exclue) et
+                    le fichier d'historique (FICHIER_HISTORIQUE par défaut)
+    But:
+        Relire l'historique binaire et ses archives sans charger l'inventaire,
+        au format texte de l'ancien historique.log, puis afficher le débit
+        sur la sortie d'erreur
+    Retour:
+        0 si succès, 2 si les arguments sont invalides ou l'historique introuvable
+    */
+    FiltreHistorique filtre = {0, 0, 0};
+    const char* chemin = FICHIER_HISTORIQUE;
+    bool valide = true;
+    for (int i = 2; i < argc && valide; i++) {
+        bool suivi = (i + 1 < argc);
+        if (strcmp(argv[i], "--id") == 0 && suivi) {
+            char* fin;
+            long id = strtol(argv[++i], &fin, 10);
+            valide = (*fin == '\0' && id > 0 && id <= (long)UINT32_MAX);
+            filtre.id = (uint64_t)id;
+        } else if (strcmp(argv[i], "--debut") == 0 && suivi) {
+            valide = (historique_date_depuis_chaine(argv[++i], &filtre.debut) == 0);
+        } else if (strcmp(argv[i], "--fin") == 0 && suivi) {
+            valide = (historique_date_depuis_chaine(argv[++i], &filtre.fin) == 0);
+        } else if (argv[i][0] != '-' && i == argc - 1) {
+            chemin = argv[i];
+        } else {
+            valide = false;
+        }
+    }
+    if (!valide) {
+        fprintf(stderr, "Usage : %s --historique [--id ID] [--debut DATE] [--fin DATE] [fichier]\n", argv[0]);
+        return 2;
+    }
+
+    struct timespec debut, fin;
+    size_t nb_lus, nb_rendus;
+    clock_gettime(CLOCK_MONOTONIC, &debut);
+    int res = historique_lire(chemin, &filtre, stdout, &nb_lus, &nb_rendus);
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    if (access(ANCIEN_HISTORIQUE, F_OK) == 0) {
+        fprintf(stderr, "[i] %s (ancien format texte) n'est pas relu : il se consulte tel quel.\n", ANCIEN_HISTORIQUE);
+    }
+    if (res != 0) {
+        fprintf(stderr, "[!] Erreur : Aucun historique lisible (%s)\n", chemin);
+        return 2;
+    }
+
+    double secondes = (double)(fin.tv_sec - debut.tv_sec) + (double)(fin.tv_nsec - debut.tv_nsec) / 1e9;
+    fprintf(stderr, "[INFO] %zu evenements lus, %zu affiches en %.3f s\n", nb_lus, nb_rendus, secondes);
+    return 0;
+}
+
+static void lire_configuration(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Appliquer les réglages passés par variables d'environnement :
+        - BGRS_JOURNAL : politique de vidage de l'historique ("operation",
+          "lot:N" ou "minuterie:MS", suivie de ",fsync" pour forcer la synchronisation
+          disque et/ou de ",rotation:MO" pour la taille de rotation)
+        - BGRS_THREADS : nombre de threads de chargement (0 ou absent = un par coeur)
+        - BGRS_SERVEUR_THREADS : nombre de threads de service du mode serveur
+          (0 ou absent = un par coeur)
+        - BGRS_SAUVEGARDE_FSYNC : "0" pour ne pas synchroniser le disque à chaque
+          sauvegarde complète (plus rapide, moins sûr en cas de coupure de courant)
+        - BGRS_FORMAT : "binaire" pour écrire les sauvegardes complètes en
+          instantané binaire, "texte" (défaut) pour le format lisible
+        - BGRS_CHAMPS : champs de "Afficher l'inventaire" ("id,nom,prix", "tous"...)
+        Puis ouvrir le journal
+    Retour:
+        Aucun
+    */
+    ConfigJournal config;
+    journal_config_defaut(&config);
+
+    const char* politique = getenv("BGRS_JOURNAL");
+    if (politique != NULL && journal_config_depuis_chaine(politique, &config) != 0) {
+        fprintf(stderr, "[!] BGRS_JOURNAL invalide (%s), politique par defaut utilisee.\n", politique);
+    }
+    journal_ouvrir(FICHIER_HISTORIQUE, &config);
+
+    const char* threads = getenv("BGRS_THREADS");
+    if (threads != NULL) {
+        char* fin;
+        long nb = strtol(threads, &fin, 10);
+        if (fin == threads || *fin != '\0' || nb < 0 || nb > 1024) {
+            fprintf(stderr, "[!] BGRS_THREADS invalide (%s), un thread par coeur.\n", threads);
+        } else {
+            charger_fichier_configurer_threads((unsigned int)nb);
+        }
+    }
+
+    const char* threads_serveur = getenv("BGRS_SERVEUR_THREADS");
+    if (threads_serveur != NULL) {
+        char* fin;
+        long nb = strtol(threads_serveur, &fin, 10);
+        if (fin == threads_serveur || *fin != '\0' || nb < 0 || nb > 64) {
+            fprintf(stderr, "[!] BGRS_SERVEUR_THREADS invalide (%s), un thread par coeur.\n", threads_serveur);
+        } else {
+            serveur_configurer_threads((unsigned int)nb);
+        }
+    }
+
+    const char* fsync_sauvegarde = getenv("BGRS_SAUVEGARDE_FSYNC");
+    if (fsync_sauvegarde != NULL) {
+        sauvegarde_configurer_fsync(strcmp(fsync_sauvegarde, "0") != 0);
+    }
+
+    const char* format = getenv("BGRS_FORMAT");
+    if (format != NULL) {
+        if (strcmp(format, "binaire") == 0 || strcmp(format, "texte") == 0) {
+            sauvegarde_configurer_format(strcmp(format, "binaire") == 0);
+        } else {
+            fprintf(stderr, "[!] BGRS_FORMAT invalide (%s), sauvegardes au format texte.\n", format);
+        }
+    }
+
+    const char* champs = getenv("BGRS_CHAMPS");
+    if (champs != NULL && rendu_champs_depuis_chaine(champs, &champs_affichage) != 0) {
+        fprintf(stderr, "[!] BGRS_CHAMPS invalide (%s), champs par defaut affiches.\n", champs);
+    }
+}
+
 static void afficher(Produit** head) {
     /*
     Argument:
         head: pointeur d'un pointeur vers la tête de liste
     But:
-        appeler la fonction d'affichage de la bibliothèque et gérer le cas vide
+        Afficher l'inventaire avec les champs choisis (BGRS_CHAMPS) et gérer
+        le cas vide. Dans un terminal, par pages de FICHES_PAR_PAGE fiches ;
+        redirigé vers un fichier ou un tube, tout d'un bloc
     Retour:
         Aucun
     */
     if (*head == NULL) {
         printf("Inventaire vide.\n");
-    } else {
-        printf("\n--- Inventaire Complet ---\n");
-        affichage(head);
+        return;
+    }
+    printf("\n--- Inventaire Complet ---\n");
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        rendu_produits(stdout, *head, 0, 0, champs_affichage, NULL);
+        return;
+    }
+
+    const Produit* suite = *head;
+    size_t affiches = 0;
+    size_t total = colonnes_taille();
+    while (suite != NULL) {
+        size_t nb;
+        suite = rendu_produits(stdout, suite, 0, FICHES_PAR_PAGE, champs_affichage, &nb);
+        affiches += nb;
+        if (suite == NULL) break;
+
+        char reponse[8];
+        printf("-- %zu / %zu : Entree pour la suite, q pour revenir au menu --", affiches, total);
+        if (!lire_chaine_securisee(reponse, 8) || reponse[0] == 'q' || reponse[0] == 'Q') break;
     }
 }
 
@@ -152,7 +437,7 @@ static void ajouter(Produit** head, uint32_t* max_id) {
     // Saisie Prix 
     do {
         printf("Prix unitaire : ");
-    } while (!lire_double_securise(&prix_double) || prix_double < 0);
+    } while (!lire_double_securise(&prix_double) || !(prix_double >= 0 && prix_double <= FLT_MAX));
 
     // Saisie Date
     printf("Date peremption (Timestamp, 0 si aucune) : ");
@@ -169,11 +454,11 @@ static void ajouter(Produit** head, uint32_t* max_id) {
     // Création
     Produit* nouveau = creer_produit(*max_id, nom, desc, cat, qte_long, prix_double, date_long, note);
     
-    if (nouveau == NULL) {
+    if (nouveau == NULL || insertion(head, nouveau) != 0) {
         printf("Erreur critique : Échec allocation mémoire.\n");
+        liberer_produit(nouveau);
         (*max_id)--; 
     } else {
-        insertion(head, nouveau);
         printf("[+] Produit ajoute avec l'ID %u.\n", *max_id);
     }
 }
@@ -235,7 +520,7 @@ static void modifier(Produit* head) {
     if (!lire_long_securise(&qte)) qte = p->quantite;
 
     printf("Nouveau Prix [%.2f] : ", p->prix_unitaire);
-    if (!lire_double_securise(&prix)) prix = p->prix_unitaire;
+    if (!lire_double_securise(&prix) || !(prix >= 0 && prix <= FLT_MAX)) prix = p->prix_unitaire;
     
     printf("Nouvelle Date (Timestamp) [%ld] : ", p->date_peremption);
     if (!lire_long_securise(&date)) date = p->date_peremption;
@@ -251,47 +536,36 @@ static void modifier(Produit* head) {
     }
 }
 
-static void rechercher(Produit* head) {
+static void rechercher(void) {
     /*
     Argument:
-        head: Pointeur vers la tête de liste
+        Aucun
     But:
-        Rechercher et afficher les produits (insensible à la casse)
+        Rechercher et afficher les produits dont le nom contient le texte saisi
+        (insensible à la casse et aux accents), par ID croissant, grâce à l'index
+        des trigrammes. Le motif peut faire 64 caractères, comme un nom
     Retour:
         Aucun
     */
-    char recherche[64];
+    char recherche[66]; // 64 caractères, le '\n' et le '\0'
     printf("Entrez le nom à rechercher : ");
-    if (!lire_chaine_securisee(recherche, 64)) return;
+    if (!lire_chaine_securisee(recherche, 66)) return;
 
-    char recherche_lower[64];
-    for (int i = 0; i < 64; i++) {
-        recherche_lower[i] = tolower((unsigned char)recherche[i]);
-        if (recherche[i] == '\0') break;
+    Produit** resultats;
+    size_t nb;
+    if (index_nom_rechercher(recherche, &resultats, &nb) != 0) {
+        printf("Erreur : Memoire insuffisante pour la recherche.\n");
+        return;
     }
-    recherche_lower[63] = '\0'; 
-
-    bool trouve = false;
-    Produit* actu = head;
     printf("\n--- Resultats de recherche ---\n");
-    
-    while (actu != NULL) {
-        char nom_lower[64]; 
-        for (int i = 0; i < 64; i++) {
-            nom_lower[i] = tolower((unsigned char)actu->nom[i]);
-            if (actu->nom[i] == '\0') break;
-        }
-        nom_lower[63] = '\0';
 
-        // Comparaison sur les versions normalisées
-        if (strstr(nom_lower, recherche_lower) != NULL) { 
-            printf("[%u] %s (Qte: %d) - %s\n", actu->id, actu->nom, actu->quantite, actu->categorie);
-            trouve = true;
-        }
-        actu = actu->suivant;
+    for (size_t i = 0; i < nb; i++) {
+        Produit* p = resultats[i];
+        printf("[%u] %s (Qte: %d) - %s\n", p->id, p->nom, p->quantite, p->categorie);
     }
+    free(resultats);
 
-    if (!trouve) printf("Aucun produit contenant '%s' trouve.\n", recherche);
+    if (nb == 0) printf("Aucun produit contenant '%s' trouve.\n", recherche);
 }
 static void sauvegarder(Produit* head) {
     /*
@@ -299,12 +573,15 @@ static void sauvegarder(Produit* head) {
         head: Pointeur vers la tête de liste
     But:
         Déclencher la sauvegarde de l'inventaire dans le fichier par défaut
+        (ajout au journal des opérations, réécriture complète si nécessaire)
     Retour:
         Aucun
     */
-    char fichier[64] = "inventaire_sauvegarde.txt";
-    sauvegarde(head, fichier);
-    printf("Sauvegarde terminee dans %s\n", fichier);
+    if (journal_ops_sauvegarder(head) == 0) {
+        printf("Sauvegarde terminee dans %s\n", FICHIER_SAUVEGARDE);
+    } else {
+        printf("Echec de la sauvegarde.\n");
+    }
 }
 
 static void charger(Produit** head, uint32_t* max_id) {
@@ -314,44 +591,23 @@ static void charger(Produit** head, uint32_t* max_id) {
         max_id: Pointeur vers le compteur global d'ID
     But:
         Nettoyer l'inventaire actuel et charger les données depuis le fichier
-        Recalcule le max_id 
+        puis rejouer les opérations sauvegardées dans le journal
+        Le max_id est relevé pendant la lecture du fichier
     Retour:
         Aucun.
     */
-    char fichier[64] = "inventaire_sauvegarde.txt";
-    
+
     if (*head != NULL) {
         printf("Nettoyage de l'inventaire actuel...\n");
         free_struct_produit(*head);
         *head = NULL;
     }
 
-    charger_fichier(head, fichier);
-    *max_id = recalculer_max_id(*head);
+    *max_id = 0;
+    journal_ops_charger(head, max_id);
     printf("Chargement termine. Prochain ID : %u\n", *max_id + 1);
 }
 
-static uint32_t recalculer_max_id(Produit* head) {
-    /*
-    Argument:
-        head: Pointeur vers la tête de liste
-    But:
-        Parcourir la liste pour trouver l'ID le plus grand utilisé
-        Nécessaire après un chargement pour reprendre la numérotation correctement
-    Retour:
-        L'ID maximum trouvé (uint32_t)
-    */
-    uint32_t max = 0;
-    Produit* actu = head;
-    while (actu != NULL) {
-        if (actu->id > max) {
-            max = actu->id;
-        }
-        actu = actu->suivant;
-    }
-    return max;
-}
-
 static void generer_loot(Produit** head, uint32_t* max_id) {
     /*
     Argument:
@@ -381,11 +637,11 @@ static void generer_loot(Produit** head, uint32_t* max_id) {
         (*max_id)++;
         Produit* p = creer_produit(*max_id, items[i].nom, items[i].desc, items[i].cat, items[i].qte, items[i].prix, 0, items[i].note);
         
-        if (p != NULL) {
-            insertion(head, p);
+        if (p != NULL && insertion(head, p) == 0) {
             printf("[+] Ajout auto : %s\n", items[i].nom);
         } else {
             printf("[!] Erreur ajout : %s\n", items[i].nom);
+            liberer_produit(p);
             (*max_id)--;
         }
     }
@@ -393,37 +649,196 @@ static void generer_loot(Produit** head, uint32_t* max_id) {
 }
 
 
-static void supprimer_perimes(Produit** head) {
+static void nettoyer_perimes(Produit** head) {
     /*
     Argument:
         head: Pointeur vers la tête de liste
     But:
-        Parcours automatique et suppression des produits périmés (basé sur Timestamp)
+        Suppression automatique des produits périmés (basé sur Timestamp), avant chaque choix du menu
+    Retour:
+        Aucun
+    */
+    size_t count = supprimer_perimes(head, time(NULL), true);
+    if (count > 0) {
+        printf("[INFO] %zu produits perimes ont ete retires de l'inventaire.\n", count);
+    }
+}
+
+static void resume_stock(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Afficher les agrégats du stock, calculés sur les colonnes numériques
+        (valeur totale, stock faible, péremptions proches), puis les agrégats
+        tenus à jour de chaque catégorie
+    Retour:
+        Aucun
     */
-    bool restart = true;
-    int count = 0;
-    time_t now = time(NULL); 
-
-    while (restart) {
-        restart = false;
-        Produit* actu = *head;
-
-        while (actu != NULL) {
-            // Si date existe (>0) ET date passée (< now)
-            if (actu->date_peremption != 0 && actu->date_peremption < now) {
-                
-                printf("[-] Suppression du produit perime ID %u (%s)\n", actu->id, actu->nom);
-                
-                suppression_par_id(head, actu->id);
-                
-                count++;
-                restart = true; 
-                break; 
-            }
-            actu = actu->suivant;
+    time_t limite = time(NULL) + (time_t)HORIZON_PEREMPTION_JOURS * 24 * 3600;
+
+    printf("\n--- Resume du stock ---\n");
+    printf("Produits : %zu\n", colonnes_taille());
+    printf("Valeur totale : %.2f\n", colonnes_valeur_stock());
+    printf("Stock faible (< %d) : %zu\n", SEUIL_STOCK_FAIBLE, colonnes_compter_stock_faible(SEUIL_STOCK_FAIBLE));
+    printf("Peremption sous %d jours : %zu\n", HORIZON_PEREMPTION_JOURS, colonnes_compter_peremption_avant(limite));
+
+    printf("\n%-20s %10s %12s %14s\n", "Categorie", "Produits", "Stock", "Valeur");
+    for (uint32_t id = 1; id <= categories_nombre(); id++) {
+        AgregatCategorie agregat;
+        categories_agregat(id, &agregat);
+        if (agregat.produits == 0) continue;
+        printf("%-20s %10zu %12lld %14.2f\n", categories_nom(id), agregat.produits,
+               (long long)agregat.stock, agregat.valeur);
+    }
+}
+
+static void afficher_categorie(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Lister les catégories et leur nombre de produits, puis afficher les
+        produits d'une seule catégorie (matériel médical et réparation d'outils
+        restent séparés) sans parcourir le reste de l'inventaire
+    Retour:
+        Aucun
+    */
+    printf("\n--- Categories ---\n");
+    for (uint32_t id = 1; id <= categories_nombre(); id++) {
+        if (categories_taille(id) > 0) {
+            printf("%s (%zu)\n", categories_nom(id), categories_taille(id));
         }
     }
-    if (count > 0) {
-        printf("[INFO] %d produits perimes ont ete retires de l'inventaire.\n", count);
+
+    char nom[64];
+    printf("Categorie a afficher : ");
+    if (!lire_chaine_securisee(nom, 64)) return;
+
+    uint32_t id = categories_chercher(nom);
+    size_t taille = categories_taille(id);
+    if (taille == 0) {
+        printf("Aucun produit dans la categorie '%s'.\n", nom);
+        return;
     }
-}
\ No newline at end of file
+
+    printf("\n--- Categorie %s ---\n", categories_nom(id));
+    for (size_t i = 0; i < taille; i++) {
+        Produit* p = categories_membre(id, i);
+        printf("[%u] %s (Qte: %d, Prix: %.2f)\n", p->id, p->nom, p->quantite, p->prix_unitaire);
+    }
+    AgregatCategorie agregat;
+    categories_agregat(id, &agregat);
+    printf("Produits : %zu - Valeur : %.2f - Stock : %lld\n", agregat.produits,
+           agregat.valeur, (long long)agregat.stock);
+}
+
+static void afficher_statistiques(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Afficher les compteurs et les durées des opérations depuis le lancement,
+        et les exporter en JSON dans FICHIER_STATISTIQUES
+    Retour:
+        Aucun
+    */
+    printf("\n--- Statistiques ---\n");
+    stats_afficher(stdout);
+    if (stats_exporter(FICHIER_STATISTIQUES) == 0) {
+        printf("Statistiques exportees dans %s\n", FICHIER_STATISTIQUES);
+    } else {
+        printf("Echec de l'export des statistiques.\n");
+    }
+}
+
+static void afficher_tri(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Afficher les produits dans l'ordre d'une vue triée (moins chers, stock
+        le plus bas, péremption la plus proche, ou l'inverse), en ne lisant que
+        les N premiers de la vue
+    Retour:
+        Aucun
+    */
+    static const char* const titres[NB_TRIS] = {"Prix", "Quantite", "Peremption"};
+    long choix, nombre, ordre;
+
+    printf("Trier par (1. Prix, 2. Quantite, 3. Peremption) : ");
+    if (!lire_long_securise(&choix) || choix < 1 || choix > NB_TRIS) {
+        printf("Critere invalide.\n");
+        return;
+    }
+    printf("Nombre de produits (0 = tous) : ");
+    if (!lire_long_securise(&nombre) || nombre < 0) {
+        printf("Nombre invalide.\n");
+        return;
+    }
+    printf("Ordre (1. Croissant, 2. Decroissant) : ");
+    if (!lire_long_securise(&ordre) || ordre < 1 || ordre > 2) {
+        printf("Ordre invalide.\n");
+        return;
+    }
+
+    CritereTri critere = (CritereTri)(choix - 1);
+    if (index_tri_taille(critere) == 0) {
+        printf("Aucun produit a afficher.\n");
+        return;
+    }
+
+    CurseurTri curseur;
+    index_tri_ouvrir(critere, ordre == 2, &curseur);
+    printf("\n--- Produits par %s (%s) ---\n", titres[critere], (ordre == 2) ? "decroissant" : "croissant");
+    long nb = 0;
+    Produit* p;
+    while ((nombre == 0 || nb < nombre) && (p = index_tri_suivant(&curseur)) != NULL) {
+        char date[TAILLE_DATE_RENDU];
+        rendu_date(p->date_peremption, date);
+        printf("[%u] %s (Qte: %d, Prix: %.2f, Peremption: %s)\n", p->id, p->nom, p->quantite, p->prix_unitaire, date);
+        nb++;
+    }
+    printf("Produits affiches : %ld / %zu\n", nb, index_tri_taille(critere));
+}
+
+static void afficher_peremptions(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Afficher les produits qui périment dans les N prochains jours, du plus
+        urgent au moins urgent, pour les redistribuer avant la date. La vue
+        triée des péremptions ne lit que les produits de l'intervalle
+    Retour:
+        Aucun
+    */
+    long jours;
+    printf("Peremptions dans les combien de jours ? ");
+    if (!lire_long_securise(&jours) || jours < 0 || jours > 36500) {
+        printf("Nombre de jours invalide (0 a 36500).\n");
+        return;
+    }
+
+    time_t debut = time(NULL);
+    time_t fin = debut + (time_t)jours * 24 * 3600;
+    CurseurTri curseur;
+    index_tri_placer(TRI_PEREMPTION, (double)debut, &curseur);
+
+    printf("\n--- Peremptions sous %ld jours ---\n", jours);
+    size_t nb = 0;
+    double valeur = 0.0;
+    Produit* p;
+    while ((p = index_tri_suivant(&curseur)) != NULL && p->date_peremption <= fin) {
+        char date[TAILLE_DATE_RENDU];
+        rendu_date(p->date_peremption, date);
+        printf("[%u] %s (Qte: %d, Prix: %.2f, Peremption: %s)\n", p->id, p->nom, p->quantite, p->prix_unitaire, date);
+        valeur += (double)p->quantite * p->prix_unitaire;
+        nb++;
+    }
+    if (nb == 0) {
+        printf("Aucun produit ne perime dans cet intervalle.\n");
+    } else {
+        printf("Produits : %zu - Valeur : %.2f\n", nb, valeur);
+    }
+}
@@ -0,0 +1,328 @@
+/*
+Nom du fichier : memoire.c
+Fait par : Erwann GIRAULT
+But : Réserve mémoire des produits. Blocs de nœuds Produit et arène de chaînes,
+      pour remplacer les cinq malloc par produit et tout libérer d'un coup.
+      Les nœuds et les zones de chaînes rendus sont réutilisés
+*/
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "memoire.h"
+
+#define PRODUITS_PAR_BLOC 4096
+#define TAILLE_ARENE (1024 * 1024)
+#define TAILLE_MAX_PARTAGEE (TAILLE_ARENE / 4) // au-delà, la zone a son propre bloc
+
+// Classes de zones de chaînes : de 16 en 16 octets jusqu'à 1 Ko, puis puissances
+// de 2 (jusqu'à la plus grande taille représentable)
+#define PAS_CLASSE 16
+#define TAILLE_MAX_PETITE 1024
+#define NB_PETITES_CLASSES (TAILLE_MAX_PETITE / PAS_CLASSE)
+#define NB_CLASSES (NB_PETITES_CLASSES + 54)
+
+typedef struct BlocMemoire {
+    struct BlocMemoire* suivant;
+    max_align_t donnees[];
+} BlocMemoire;
+
+typedef struct {
+    unsigned long generation;  // cache périmé si différent de la génération globale
+    Produit* produits;         // prochain nœud neuf du bloc courant
+    size_t produits_restants;
+    char* chaines;             // position courante dans l'arène
+    size_t chaines_restantes;
+} CacheThread;
+
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static BlocMemoire* blocs = NULL;
+static size_t octets_reserves = 0;
+static atomic_ulong generation = 1;
+static _Thread_local CacheThread cache;
+
+// Nœuds et zones rendus, partagés entre les threads : modifiés sous verrou,
+// lus sans verrou pour ne pas le prendre quand il n'y a rien à reprendre
+static _Atomic(Produit*) produits_rendus = NULL;      // chaînés par suivant
+static _Atomic(char*) zones_rendues[NB_CLASSES];     // chaînées par leurs premiers octets
+static size_t octets_rendus = 0;
+
+static void* nouveau_bloc(size_t taille) {
+    /*
+    Argument:
+        taille: Taille utile du bloc
+    But:
+        Allouer un bloc et l'enregistrer dans la liste globale (seul passage sous verrou)
+    Retour:
+        Zone utile du bloc, ou NULL en cas d'erreur d'allocation
+    */
+    BlocMemoire* bloc = (BlocMemoire*)malloc(sizeof(BlocMemoire) + taille);
+    if (bloc == NULL) return NULL;
+
+    pthread_mutex_lock(&verrou);
+    bloc->suivant = blocs;
+    blocs = bloc;
+    octets_reserves += taille;
+    pthread_mutex_unlock(&verrou);
+    return bloc->donnees;
+}
+
+static void verifier_cache(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Oublier le bloc et l'arène courants du thread s'ils ont été libérés
+        par memoire_liberer_tout depuis leur dernière utilisation
+    Retour:
+        Aucun
+    */
+    unsigned long actuelle = atomic_load_explicit(&generation, memory_order_acquire);
+    if (cache.generation != actuelle) {
+        memset(&cache, 0, sizeof(cache));
+        cache.generation = actuelle;
+    }
+}
+
+Produit* memoire_produit(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Fournir un nœud Produit : d'abord un nœud rendu (par n'importe quel
+        thread), sinon le suivant du bloc courant (nouveau bloc si celui-ci est épuisé)
+    Retour:
+        Nœud mis à zéro, ou NULL en cas d'erreur d'allocation
+    */
+    verifier_cache();
+
+    Produit* produit = NULL;
+    if (atomic_load_explicit(&produits_rendus, memory_order_relaxed) != NULL) {
+        pthread_mutex_lock(&verrou);
+        produit = atomic_load_explicit(&produits_rendus, memory_order_relaxed);
+        if (produit != NULL) {
+            atomic_store_explicit(&produits_rendus, produit->suivant, memory_order_relaxed);
+            octets_rendus -= sizeof(Produit);
+        }
+        pthread_mutex_unlock(&verrou);
+    }
+    if (produit == NULL) {
+        if (cache.produits_restants == 0) {
+            Produit* bloc = (Produit*)nouveau_bloc(PRODUITS_PAR_BLOC * sizeof(Produit));
+            if (bloc == NULL) return NULL;
+            cache.produits = bloc;
+            cache.produits_restants = PRODUITS_PAR_BLOC;
+        }
+        produit = cache.produits++;
+        cache.produits_restants--;
+    }
+    memset(produit, 0, sizeof(Produit));
+    return produit;
+}
+
+static size_t classe_zone(size_t taille, size_t* capacite) {
+    /*
+    Argument:
+        taille: Taille demandée (au moins 1)
+        capacite: Taille réelle de la zone de cette classe
+    But:
+        Ranger une taille dans sa classe : une zone rendue ne resservira qu'à
+        une demande de la même classe
+    Retour:
+        Numéro de la classe
+    */
+    if (taille <= TAILLE_MAX_PETITE) {
+        size_t classe = (taille + PAS_CLASSE - 1) / PAS_CLASSE - 1;
+        *capacite = (classe + 1) * PAS_CLASSE;
+        return classe;
+    }
+    size_t classe = NB_PETITES_CLASSES;
+    size_t taille_classe = 2 * TAILLE_MAX_PETITE;
+    while (taille_classe < taille) {
+        taille_classe *= 2;
+        classe++;
+    }
+    *capacite = taille_classe;
+    return classe;
+}
+
+void memoire_rendre_produit(Produit* produit) {
+    /*
+    Argument:
+        produit: Nœud qui n'est plus utilisé
+    But:
+        Rendre sa zone de chaînes et garder le nœud pour la prochaine
+        allocation, quel que soit le thread qui la fera
+    Retour:
+        Aucun
+    */
+    if (produit == NULL) return;
+    verifier_cache();
+    if (produit->zone != NULL) {
+        memoire_rendre_chaines(produit->zone, produit->taille_zone);
+    }
+    pthread_mutex_lock(&verrou);
+    produit->suivant = atomic_load_explicit(&produits_rendus, memory_order_relaxed);
+    atomic_store_explicit(&produits_rendus, produit, memory_order_relaxed);
+    octets_rendus += sizeof(Produit);
+    pthread_mutex_unlock(&verrou);
+}
+
+char* memoire_chaines(size_t taille) {
+    /*
+    Argument:
+        taille: Nombre d'octets (chaînes et leurs '\0')
+    But:
+        Fournir une zone de la classe de cette taille : une zone rendue si
+        possible, sinon une zone découpée dans l'arène du thread (une très
+        grande zone reçoit son propre bloc)
+    Retour:
+        Zone allouée, ou NULL en cas d'erreur d'allocation
+    */
+    verifier_cache();
+    if (taille == 0) taille = 1;
+    size_t capacite;
+    size_t classe = classe_zone(taille, &capacite);
+
+    if (atomic_load_explicit(&zones_rendues[classe], memory_order_relaxed) != NULL) {
+        pthread_mutex_lock(&verrou);
+        char* zone = atomic_load_explicit(&zones_rendues[classe], memory_order_relaxed);
+        if (zone != NULL) {
+            char* suivante;
+            memcpy(&suivante, zone, sizeof(suivante)); // zones non alignées
+            atomic_store_explicit(&zones_rendues[classe], suivante, memory_order_relaxed);
+            octets_rendus -= capacite;
+        }
+        pthread_mutex_unlock(&verrou);
+        if (zone != NULL) return zone;
+    }
+
+    if (capacite > cache.chaines_restantes) {
+        if (capacite > TAILLE_MAX_PARTAGEE) {
+            return (char*)nouveau_bloc(capacite);
+        }
+        char* arene = (char*)nouveau_bloc(TAILLE_ARENE);
+        if (arene == NULL) return NULL;
+        cache.chaines = arene;
+        cache.chaines_restantes = TAILLE_ARENE;
+    }
+    char* zone = cache.chaines;
+    cache.chaines += capacite;
+    cache.chaines_restantes -= capacite;
+    return zone;
+}
+
+void memoire_rendre_chaines(char* zone, size_t taille) {
+    /*
+    Argument:
+        zone: Zone obtenue par memoire_chaines
+        taille: Taille demandée à memoire_chaines pour cette zone
+    But:
+        Garder la zone pour la prochaine demande de la même classe
+    Retour:
+        Aucun
+    */
+    if (zone == NULL) return;
+    if (taille == 0) taille = 1;
+    size_t capacite;
+    size_t classe = classe_zone(taille, &capacite);
+
+    pthread_mutex_lock(&verrou);
+    char* suivante = atomic_load_explicit(&zones_rendues[classe], memory_order_relaxed);
+    memcpy(zone, &suivante, sizeof(suivante));
+    atomic_store_explicit(&zones_rendues[classe], zone, memory_order_relaxed);
+    octets_rendus += capacite;
+    pthread_mutex_unlock(&verrou);
+}
+
+char* memoire_tas(size_t taille) {
+    /*
+    Argument:
+        taille: Nombre d'octets
+    But:
+        Zone de taille exacte qui ne sera jamais rendue à l'unité (tas d'un
+        instantané binaire, partagé par tous ses produits) : découpée dans
+        l'arène du thread, ou son propre bloc si elle est grande
+    Retour:
+        Zone allouée, ou NULL en cas d'erreur d'allocation
+    */
+    verifier_cache();
+    if (taille == 0) taille = 1; // toujours une adresse valide, même pour un tas vide
+
+    if (taille > cache.chaines_restantes) {
+        if (taille > TAILLE_MAX_PARTAGEE) {
+            return (char*)nouveau_bloc(taille);
+        }
+        char* arene = (char*)nouveau_bloc(TAILLE_ARENE);
+        if (arene == NULL) return NULL;
+        cache.chaines = arene;
+        cache.chaines_restantes = TAILLE_ARENE;
+    }
+    char* zone = cache.chaines;
+    cache.chaines += taille;
+    cache.chaines_restantes -= taille;
+    return zone;
+}
+
+void memoire_liberer_tout(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Libérer tous les blocs en une passe, sans parcourir les produits.
+        Les caches des threads deviennent périmés (changement de génération)
+    Retour:
+        Aucun
+    */
+    pthread_mutex_lock(&verrou);
+    BlocMemoire* bloc = blocs;
+    while (bloc != NULL) {
+        BlocMemoire* suivant = bloc->suivant;
+        free(bloc);
+        bloc = suivant;
+    }
+    blocs = NULL;
+    octets_reserves = 0;
+    octets_rendus = 0;
+    atomic_store_explicit(&produits_rendus, NULL, memory_order_relaxed);
+    for (size_t i = 0; i < NB_CLASSES; i++) {
+        atomic_store_explicit(&zones_rendues[i], NULL, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+    pthread_mutex_unlock(&verrou);
+}
+
+size_t memoire_octets_rendus(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Mesurer la mémoire rendue en attente de réutilisation
+    Retour:
+        Nombre d'octets des nœuds et zones rendus
+    */
+    pthread_mutex_lock(&verrou);
+    size_t total = octets_rendus;
+    pthread_mutex_unlock(&verrou);
+    return total;
+}
+
+size_t memoire_octets_reserves(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Mesurer la mémoire prise par les produits (nœuds et chaînes)
+    Retour:
+        Nombre d'octets alloués par la réserve
+    */
+    pthread_mutex_lock(&verrou);
+    size_t total = octets_reserves;
+    pthread_mutex_unlock(&verrou);
+    return total;
+}
@@ -0,0 +1,37 @@
+#ifndef _MEMOIRE_H
+#define _MEMOIRE_H
+
+#include <stddef.h>
+
+#include "gestion_produit.h"
+
+/*
+    Réserve mémoire des produits :
+    - Les nœuds Produit sont découpés dans des blocs de plusieurs milliers de
+      nœuds ; un nœud rendu va dans une liste partagée, réutilisée par tous
+      les threads.
+    - Les chaînes d'un produit tiennent dans une zone prise dans une arène par
+      simple avancée de pointeur, arrondie à sa classe de taille (16 octets
+      près jusqu'à 1 Ko, puissance de 2 au-delà). Une zone rendue (suppression,
+      modification qui déplace les chaînes) est reprise par la prochaine
+      demande de la même classe : suppressions et modifications en boucle
+      n'agrandissent pas la réserve.
+    - memoire_tas fournit une zone exacte jamais rendue à l'unité (tas d'un
+      instantané binaire, partagé par ses produits).
+    - Chaque thread a son bloc et son arène courants : les threads de
+      chargement allouent sans verrou (verrou seulement pour un nouveau bloc,
+      ou pour reprendre un nœud ou une zone rendus).
+    - memoire_liberer_tout rend tout d'un coup (fin de l'inventaire, rechargement) :
+      aucun produit ne doit être utilisé ni alloué pendant cet appel.
+*/
+
+Produit* memoire_produit(void);
+void memoire_rendre_produit(Produit* produit);
+char* memoire_chaines(size_t taille);
+void memoire_rendre_chaines(char* zone, size_t taille);
+char* memoire_tas(size_t taille);
+void memoire_liberer_tout(void);
+size_t memoire_octets_reserves(void);
+size_t memoire_octets_rendus(void);
+
+#endif
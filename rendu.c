@@ -0,0 +1,379 @@
+/*
+Nom du fichier : rendu.c
+Fait par : Erwann GIRAULT
+But : Rendu texte rapide de l'inventaire : fiches formatées dans un grand
+      tampon, dates converties via un cache par jour, pagination et choix
+      des champs
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rendu.h"
+#include "formatage.h"
+
+#define TAILLE_TAMPON_RENDU (256 * 1024)
+#define TAILLE_TAMPON_SECOURS 4096 // sur la pile si le grand tampon ne peut être alloué
+#define CASES_CACHE_DATES 1024 // doit rester une puissance de 2
+#define SECONDES_PAR_JOUR 86400
+#define SEPARATEUR_FICHE "-------------------------\n"
+
+typedef struct {
+    int64_t jour;       // jour UTC (secondes / 86400) de la case
+    int32_t decalage;   // heure locale - UTC, en secondes, valable tout le jour
+    bool constant;      // false : changement d'heure ce jour-là, localtime_r à chaque fois
+    bool occupe;
+} CaseDate;
+
+typedef struct {
+    FILE* sortie;
+    int fd;             // -1 : flux sans descripteur (open_memstream), écrit par fwrite
+    char* tampon;
+    size_t taille;
+    size_t capacite;
+    bool erreur;        // sortie fermée (tube coupé...) : on arrête d'écrire
+} Rendu;
+
+static _Thread_local CaseDate cache_dates[CASES_CACHE_DATES];
+
+static const char* const noms_jours[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char* const noms_mois[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+static int64_t division_plancher(int64_t a, int64_t b) {
+    /*
+    Argument:
+        a, b: Dividende et diviseur (b > 0)
+    But:
+        Division arrondie vers le bas (les dates avant 1970 sont négatives)
+    Retour:
+        Le quotient
+    */
+    int64_t q = a / b;
+    return (a % b < 0) ? q - 1 : q;
+}
+
+static int64_t jours_depuis_civil(int64_t annee, int mois, int jour) {
+    /*
+    Argument:
+        annee, mois (1-12), jour (1-31): Date du calendrier grégorien
+    But:
+        Nombre de jours depuis le 1er janvier 1970 (algorithme de H. Hinnant)
+    Retour:
+        Le nombre de jours (négatif avant 1970)
+    */
+    annee -= (mois <= 2);
+    int64_t ere = division_plancher(annee, 400);
+    int64_t annee_ere = annee - ere * 400;
+    int64_t jour_annee = (153 * (mois + (mois > 2 ? -3 : 9)) + 2) / 5 + jour - 1;
+    int64_t jour_ere = annee_ere * 365 + annee_ere / 4 - annee_ere / 100 + jour_annee;
+    return ere * 146097 + jour_ere - 719468;
+}
+
+static void civil_depuis_jours(int64_t jours, int64_t* annee, int* mois, int* jour) {
+    /*
+    Argument:
+        jours: Jours depuis le 1er janvier 1970
+        annee, mois, jour: Date du calendrier grégorien
+    But:
+        Inverse de jours_depuis_civil
+    Retour:
+        Aucun
+    */
+    jours += 719468;
+    int64_t ere = division_plancher(jours, 146097);
+    int64_t jour_ere = jours - ere * 146097;
+    int64_t annee_ere = (jour_ere - jour_ere / 1460 + jour_ere / 36524 - jour_ere / 146096) / 365;
+    int64_t jour_annee = jour_ere - (365 * annee_ere + annee_ere / 4 - annee_ere / 100);
+    int64_t mp = (5 * jour_annee + 2) / 153;
+    *jour = (int)(jour_annee - (153 * mp + 2) / 5 + 1);
+    *mois = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *annee = annee_ere + ere * 400 + (*mois <= 2);
+}
+
+static bool decalage_local(int64_t instant, int32_t* decalage) {
+    /*
+    Argument:
+        instant: Secondes depuis 1970 (UTC)
+        decalage: Reçoit heure locale - UTC en secondes
+    But:
+        Mesurer le décalage du fuseau local à un instant (localtime_r)
+    Retour:
+        false si l'instant n'est pas représentable
+    */
+    time_t t = (time_t)instant;
+    struct tm tm_local;
+    if (localtime_r(&t, &tm_local) == NULL) return false;
+    int64_t local = jours_depuis_civil((int64_t)tm_local.tm_year + 1900, tm_local.tm_mon + 1, tm_local.tm_mday) * SECONDES_PAR_JOUR
+                    + tm_local.tm_hour * 3600 + tm_local.tm_min * 60 + tm_local.tm_sec;
+    *decalage = (int32_t)(local - instant);
+    return true;
+}
+
+static bool decalage_du_jour(int64_t instant, int32_t* decalage) {
+    /*
+    Argument:
+        instant: Date à convertir
+        decalage: Reçoit heure locale - UTC en secondes
+    But:
+        Trouver le décalage dans le cache du thread : mesuré au début et à la
+        fin du jour UTC, il vaut pour tout le jour s'il n'a pas changé
+    Retour:
+        false si la date n'est pas représentable
+    */
+    int64_t jour = division_plancher(instant, SECONDES_PAR_JOUR);
+    CaseDate* c = &cache_dates[(uint64_t)jour & (CASES_CACHE_DATES - 1)];
+    if (!c->occupe || c->jour != jour) {
+        int32_t debut, fin;
+        if (!decalage_local(jour * SECONDES_PAR_JOUR, &debut)
+            || !decalage_local(jour * SECONDES_PAR_JOUR + SECONDES_PAR_JOUR - 1, &fin)) {
+            return false;
+        }
+        c->jour = jour;
+        c->decalage = debut;
+        c->constant = (debut == fin);
+        c->occupe = true;
+    }
+    if (c->constant) {
+        *decalage = c->decalage;
+        return true;
+    }
+    return decalage_local(instant, decalage);
+}
+
+size_t rendu_date(time_t date, char* texte) {
+    /*
+    Argument:
+        date: Date de péremption (0 = aucune)
+        texte: Au moins TAILLE_DATE_RENDU octets
+    But:
+        Écrire la date au format de ctime ("Thu Jan  1 01:00:00 1970", sans
+        '\n'), ou "Aucune" pour un produit sans péremption
+    Retour:
+        Longueur écrite (sans le '\0')
+    */
+    int32_t decalage;
+    if (date == 0 || !decalage_du_jour((int64_t)date, &decalage)) {
+        strcpy(texte, (date == 0) ? "Aucune" : "Date invalide");
+        return strlen(texte);
+    }
+    int64_t local = (int64_t)date + decalage;
+    int64_t jours = division_plancher(local, SECONDES_PAR_JOUR);
+    int secondes = (int)(local - jours * SECONDES_PAR_JOUR);
+    int64_t annee;
+    int mois, jour;
+    civil_depuis_jours(jours, &annee, &mois, &jour);
+
+    int64_t jour_semaine = jours + 4 - division_plancher(jours + 4, 7) * 7; // 1er janvier 1970 : jeudi
+
+    char* p = texte;
+    memcpy(p, noms_jours[jour_semaine], 3);
+    p += 3;
+    *p++ = ' ';
+    memcpy(p, noms_mois[mois - 1], 3);
+    p += 3;
+    *p++ = ' ';
+    if (jour < 10) *p++ = ' ';
+    p = formatage_entier(p, (uint64_t)jour, 1);
+    *p++ = ' ';
+    p = formatage_entier(p, (uint64_t)(secondes / 3600), 2);
+    *p++ = ':';
+    p = formatage_entier(p, (uint64_t)(secondes / 60 % 60), 2);
+    *p++ = ':';
+    p = formatage_entier(p, (uint64_t)(secondes % 60), 2);
+    *p++ = ' ';
+    if (annee < 0) {
+        *p++ = '-';
+        annee = -annee;
+    }
+    p = formatage_entier(p, (uint64_t)annee, 1);
+    *p = '\0';
+    return (size_t)(p - texte);
+}
+
+static void vider(Rendu* r) {
+    /*
+    Argument:
+        r: Rendu en cours
+    But:
+        Écrire le tampon sur la sortie (write en boucle, ou fwrite sans descripteur)
+    Retour:
+        Aucun
+    */
+    size_t ecrit = 0;
+    while (!r->erreur && ecrit < r->taille) {
+        if (r->fd < 0) {
+            if (fwrite(r->tampon, 1, r->taille, r->sortie) != r->taille) r->erreur = true;
+            break;
+        }
+        ssize_t n = write(r->fd, r->tampon + ecrit, r->taille - ecrit);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            r->erreur = true;
+        } else {
+            ecrit += (size_t)n;
+        }
+    }
+    r->taille = 0;
+}
+
+static void ajouter(Rendu* r, const char* texte, size_t longueur) {
+    /*
+    Argument:
+        r: Rendu en cours
+        texte, longueur: Octets à ajouter
+    But:
+        Copier dans le tampon, vidé quand il est plein
+    Retour:
+        Aucun
+    */
+    while (longueur > 0) {
+        if (r->taille == r->capacite) vider(r);
+        size_t n = r->capacite - r->taille;
+        if (n > longueur) n = longueur;
+        memcpy(r->tampon + r->taille, texte, n);
+        r->taille += n;
+        texte += n;
+        longueur -= n;
+    }
+}
+
+static void ajouter_champ(Rendu* r, const char* etiquette, size_t taille_etiquette, const char* valeur, size_t taille_valeur) {
+    /*
+    Argument:
+        r: Rendu en cours
+        etiquette: "Nom: " etc.
+        valeur: Texte du champ
+    But:
+        Ajouter une ligne "etiquette valeur\n"
+    Retour:
+        Aucun
+    */
+    ajouter(r, etiquette, taille_etiquette);
+    ajouter(r, valeur, taille_valeur);
+    ajouter(r, "\n", 1);
+}
+
+#define AJOUTER_CHAMP(r, etiquette, valeur, taille) ajouter_champ((r), etiquette, sizeof(etiquette) - 1, (valeur), (taille))
+
+static void rendre_fiche(Rendu* r, const Produit* p, unsigned int champs) {
+    /*
+    Argument:
+        r: Rendu en cours
+        p: Produit
+        champs: Champs à afficher (RENDU_*)
+    But:
+        Ajouter la fiche d'un produit (champs dans l'ordre de l'affichage historique)
+    Retour:
+        Aucun
+    */
+    char nombre[TAILLE_PRIX_FORMATE]; // assez pour un ID ou un prix
+    if (champs & RENDU_ID) {
+        AJOUTER_CHAMP(r, "ID: ", nombre, (size_t)(formatage_entier(nombre, p->id, 1) - nombre));
+    }
+    if (champs & RENDU_NOM) AJOUTER_CHAMP(r, "Nom: ", p->nom, strlen(p->nom));
+    if (champs & RENDU_CATEGORIE) AJOUTER_CHAMP(r, "Categorie: ", p->categorie, strlen(p->categorie));
+    if (champs & RENDU_DESCRIPTION) AJOUTER_CHAMP(r, "Description: ", p->description, strlen(p->description));
+    if (champs & RENDU_PRIX) AJOUTER_CHAMP(r, "Prix Unitaire: ", nombre, (size_t)(formatage_prix(nombre, p->prix_unitaire) - nombre));
+    if (champs & RENDU_QUANTITE) {
+        char* fin = nombre;
+        if (p->quantite < 0) *fin++ = '-';
+        fin = formatage_entier(fin, (p->quantite < 0) ? (uint64_t)(-(int64_t)p->quantite) : (uint64_t)p->quantite, 1);
+        AJOUTER_CHAMP(r, "Quantite: ", nombre, (size_t)(fin - nombre));
+    }
+    if (champs & RENDU_PEREMPTION) {
+        char date[TAILLE_DATE_RENDU];
+        AJOUTER_CHAMP(r, "Date de Peremption: ", date, rendu_date(p->date_peremption, date));
+    }
+    if (champs & RENDU_NOTE) AJOUTER_CHAMP(r, "Note: ", p->note, strlen(p->note));
+    ajouter(r, SEPARATEUR_FICHE, sizeof(SEPARATEUR_FICHE) - 1);
+}
+
+const Produit* rendu_produits(FILE* sortie, const Produit* premier, size_t debut, size_t limite, unsigned int champs, size_t* nb_rendus) {
+    /*
+    Argument:
+        sortie: Flux de sortie (vidé avant le rendu, qui écrit directement sur son descripteur)
+        premier: Premier produit de la liste
+        debut: Nombre de produits à sauter
+        limite: Nombre maximum de fiches (0 = jusqu'à la fin)
+        champs: Champs à afficher (RENDU_*)
+        nb_rendus: Reçoit le nombre de fiches écrites (peut être NULL)
+    But:
+        Afficher une page de l'inventaire
+    Retour:
+        Premier produit non affiché (pour la page suivante), NULL en fin de
+        liste ou si la sortie est fermée
+    */
+    const Produit* actu = premier;
+    for (size_t i = 0; i < debut && actu != NULL; i++) {
+        actu = actu->suivant;
+    }
+
+    char secours[TAILLE_TAMPON_SECOURS];
+    Rendu r;
+    r.sortie = sortie;
+    r.fd = fileno(sortie);
+    r.taille = 0;
+    r.erreur = false;
+    r.tampon = (char*)malloc(TAILLE_TAMPON_RENDU);
+    r.capacite = TAILLE_TAMPON_RENDU;
+    if (r.tampon == NULL) {
+        r.tampon = secours;
+        r.capacite = sizeof(secours);
+    }
+    fflush(sortie);
+
+    size_t nb = 0;
+    for (; actu != NULL && (limite == 0 || nb < limite) && !r.erreur; actu = actu->suivant, nb++) {
+        rendre_fiche(&r, actu, champs);
+    }
+    vider(&r);
+    if (r.tampon != secours) free(r.tampon);
+
+    if (nb_rendus != NULL) *nb_rendus = nb;
+    return r.erreur ? NULL : actu;
+}
+
+int rendu_champs_depuis_chaine(const char* texte, unsigned int* champs) {
+    /*
+    Argument:
+        texte: Noms de champs séparés par des virgules ("id,nom,prix"), ou "tous"
+        champs: Reçoit le masque RENDU_* correspondant
+    But:
+        Lire la sélection de champs de l'affichage (variable BGRS_CHAMPS)
+    Retour:
+        0 si succès, -1 si un nom est inconnu ou si aucun champ n'est choisi
+    */
+    static const struct {
+        const char* nom;
+        unsigned int masque;
+    } noms[] = {
+        {"id", RENDU_ID}, {"nom", RENDU_NOM}, {"categorie", RENDU_CATEGORIE},
+        {"description", RENDU_DESCRIPTION}, {"prix", RENDU_PRIX}, {"quantite", RENDU_QUANTITE},
+        {"peremption", RENDU_PEREMPTION}, {"note", RENDU_NOTE}, {"tous", RENDU_TOUS}
+    };
+    unsigned int masque = 0;
+    const char* p = texte;
+    while (*p != '\0') {
+        size_t longueur = strcspn(p, ",");
+        size_t i = 0;
+        while (i < sizeof(noms) / sizeof(noms[0])
+               && !(strlen(noms[i].nom) == longueur && strncmp(noms[i].nom, p, longueur) == 0)) {
+            i++;
+        }
+        if (i == sizeof(noms) / sizeof(noms[0])) return -1;
+        masque |= noms[i].masque;
+        p += longueur;
+        if (*p == ',') p++;
+    }
+    if (masque == 0) return -1;
+    *champs = masque;
+    return 0;
+}
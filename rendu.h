@@ -0,0 +1,38 @@
+#ifndef _RENDU_H
+#define _RENDU_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "gestion_produit.h"
+
+/*
+    Rendu texte de l'inventaire (menu "Afficher l'inventaire") :
+    - Les fiches sont formatées à la main dans un grand tampon, écrit en
+      quelques gros write : pas de printf par champ.
+    - Les dates passent par un cache du décalage horaire de chaque jour
+      (localtime_r une fois par jour rencontré, pas une fois par produit) et
+      gardent le format de ctime. Une date à 0 (sans péremption) s'affiche
+      "Aucune".
+    - Pagination (debut, limite) et choix des champs affichés (RENDU_*).
+*/
+
+#define RENDU_ID          0x01
+#define RENDU_NOM         0x02
+#define RENDU_CATEGORIE   0x04
+#define RENDU_DESCRIPTION 0x08
+#define RENDU_PRIX        0x10
+#define RENDU_QUANTITE    0x20
+#define RENDU_PEREMPTION  0x40
+#define RENDU_NOTE        0x80
+#define RENDU_TOUS        0xFF
+#define RENDU_DEFAUT      (RENDU_TOUS & ~RENDU_NOTE) // champs de l'affichage historique
+
+#define TAILLE_DATE_RENDU 40
+
+size_t rendu_date(time_t date, char* texte);
+int rendu_champs_depuis_chaine(const char* texte, unsigned int* champs);
+const Produit* rendu_produits(FILE* sortie, const Produit* premier, size_t debut, size_t limite, unsigned int champs, size_t* nb_rendus);
+
+#endif
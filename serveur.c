@@ -0,0 +1,571 @@
+/*
+Nom du fichier : serveur.c
+Fait par : Erwann GIRAULT
+But : Mode serveur : threads de service partageant une boucle d'événements
+      epoll sur une socket Unix locale, plusieurs clients envoyant des
+      commandes (protocole du mode commandes)
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+#include "serveur.h"
+#include "commandes.h"
+#include "echeancier.h"
+
+#define EVENEMENTS_MAX 8                  // par réveil d'un thread : les autres prennent la suite
+#define THREADS_SERVEUR_MAX 64
+#define TAILLE_LECTURE 65536
+#define LIGNE_MAX (64 * 1024)             // une commande plus longue ferme la connexion
+#define SORTIE_MAX_EN_ATTENTE (4 * 1024 * 1024) // au-delà, on cesse de lire ce client
+#define ATTENTE_MAX_MS 1000
+
+typedef struct Client {
+    int fd;
+    char* entree;              // octets reçus pas encore exécutés (ligne incomplète)
+    size_t entree_taille;
+    size_t entree_capacite;
+    char* sortie;              // réponses pas encore envoyées
+    size_t sortie_taille;
+    size_t sortie_envoye;
+    size_t numero;             // numéro de la dernière commande, pour les erreurs
+    bool lecture_finie;        // fin de flux reçue ou "quit" : fermer une fois tout envoyé
+    pthread_mutex_t passage;   // autour du réarmement et à la reprise par un autre thread
+    struct Client* precedent;  // liste des connexions ouvertes
+    struct Client* suivant;
+} Client;
+
+typedef struct {
+    size_t nb_connexions;
+    size_t nb_commandes;
+    size_t nb_erreurs;
+} BilanServeur;
+
+typedef struct {
+    int epoll_fd;
+    int ecoute;
+    Produit** head;
+    uint32_t* max_id;
+    atomic_llong dernier_controle; // seconde du dernier contrôle des péremptions
+} Contexte;
+
+typedef struct {
+    pthread_t thread;
+    bool lance;
+    Contexte* contexte;
+    BilanServeur bilan;        // propre au thread, additionné à l'arrêt
+} Travailleur;
+
+static atomic_bool arret_demande = false;
+static pthread_mutex_t verrou_clients = PTHREAD_MUTEX_INITIALIZER;
+static Client* clients = NULL;
+static int reveil[2] = {-1, -1};   // tube d'arrêt : son adresse marque l'événement dans epoll
+static unsigned int nb_threads_serveur = 0; // 0 = un par coeur
+
+void serveur_configurer_threads(unsigned int nb_threads) {
+    /*
+    Argument:
+        nb_threads: Nombre de threads de service (0 = un par coeur)
+    But:
+        Régler le parallélisme de serveur_executer
+    Retour:
+        Aucun
+    */
+    nb_threads_serveur = nb_threads;
+}
+
+static int rendre_non_bloquant(int fd) {
+    /*
+    Argument:
+        fd: Descripteur
+    But:
+        Passer le descripteur en mode non bloquant
+    Retour:
+        0 si succès, -1 sinon
+    */
+    int drapeaux = fcntl(fd, F_GETFL, 0);
+    if (drapeaux < 0) return -1;
+    return fcntl(fd, F_SETFL, drapeaux | O_NONBLOCK);
+}
+
+static int ouvrir_socket(const char* chemin) {
+    /*
+    Argument:
+        chemin: Chemin de la socket Unix
+    But:
+        Créer la socket d'écoute (une socket restée d'un ancien serveur est
+        remplacée), lisible et inscriptible par le propriétaire et son groupe
+    Retour:
+        Descripteur de la socket, ou -1 en cas d'erreur
+    */
+    struct sockaddr_un adresse;
+    if (strlen(chemin) >= sizeof(adresse.sun_path)) {
+        fprintf(stderr, "[!] Erreur : Chemin de socket trop long (%s)\n", chemin);
+        return -1;
+    }
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    strcpy(adresse.sun_path, chemin);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("[!] Erreur socket");
+        return -1;
+    }
+    unlink(chemin);
+    if (bind(fd, (struct sockaddr*)&adresse, sizeof(adresse)) != 0 || listen(fd, SOMAXCONN) != 0
+        || rendre_non_bloquant(fd) != 0) {
+        perror("[!] Erreur ouverture de la socket");
+        close(fd);
+        return -1;
+    }
+    chmod(chemin, 0660);
+    return fd;
+}
+
+static void fermer_client(int epoll_fd, Client* client) {
+    /*
+    Argument:
+        epoll_fd: Boucle d'événements
+        client: Connexion à fermer (aucun autre thread ne la traite : EPOLLONESHOT)
+    But:
+        Retirer la connexion de la boucle et de la liste, et libérer ses tampons
+    Retour:
+        Aucun
+    */
+    pthread_mutex_lock(&verrou_clients);
+    if (client->precedent != NULL) {
+        client->precedent->suivant = client->suivant;
+    } else {
+        clients = client->suivant;
+    }
+    if (client->suivant != NULL) client->suivant->precedent = client->precedent;
+    pthread_mutex_unlock(&verrou_clients);
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    pthread_mutex_destroy(&client->passage);
+    free(client->entree);
+    free(client->sortie);
+    free(client);
+}
+
+static void surveiller(int epoll_fd, Client* client) {
+    /*
+    Argument:
+        epoll_fd: Boucle d'événements
+        client: Connexion
+    But:
+        Réarmer la connexion (EPOLLONESHOT : un seul thread à la fois la
+        traite) en demandant EPOLLOUT seulement s'il reste des réponses à
+        envoyer, et cesser de lire un client qui ne lit pas ses réponses.
+        Le réarmement se fait sous client->passage : le thread qui reprend la
+        connexion prend ce verrou, ce qui ordonne en C11 (et pour
+        ThreadSanitizer, qui ne voit pas la synchronisation d'epoll) tout ce
+        que ce thread-ci y a fait avant
+    Retour:
+        Aucun
+    */
+    size_t en_attente = client->sortie_taille - client->sortie_envoye;
+    uint32_t voulus = EPOLLONESHOT;
+    if (!client->lecture_finie && en_attente < SORTIE_MAX_EN_ATTENTE) voulus |= EPOLLIN;
+    if (en_attente > 0) voulus |= EPOLLOUT;
+
+    struct epoll_event ev;
+    ev.events = voulus;
+    ev.data.ptr = client;
+    pthread_mutex_lock(&client->passage);
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+    pthread_mutex_unlock(&client->passage);
+}
+
+static bool envoyer(Client* client) {
+    /*
+    Argument:
+        client: Connexion
+    But:
+        Envoyer autant de réponses que la socket en accepte
+    Retour:
+        false si la connexion est perdue
+    */
+    while (client->sortie_envoye < client->sortie_taille) {
+        ssize_t n = send(client->fd, client->sortie + client->sortie_envoye,
+                         client->sortie_taille - client->sortie_envoye, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        client->sortie_envoye += (size_t)n;
+    }
+    client->sortie_taille = 0;
+    client->sortie_envoye = 0;
+    return true;
+}
+
+static bool ajouter_sortie(Client* client, const char* donnees, size_t taille) {
+    /*
+    Argument:
+        client: Connexion
+        donnees, taille: Réponses à ajouter
+    But:
+        Mettre des réponses en attente d'envoi (tampon agrandi au besoin)
+    Retour:
+        false en cas d'erreur d'allocation
+    */
+    if (taille == 0) return true;
+    if (client->sortie_envoye > 0) {
+        memmove(client->sortie, client->sortie + client->sortie_envoye, client->sortie_taille - client->sortie_envoye);
+        client->sortie_taille -= client->sortie_envoye;
+        client->sortie_envoye = 0;
+    }
+    char* agrandi = (char*)realloc(client->sortie, client->sortie_taille + taille);
+    if (agrandi == NULL) return false;
+    client->sortie = agrandi;
+    memcpy(client->sortie + client->sortie_taille, donnees, taille);
+    client->sortie_taille += taille;
+    return true;
+}
+
+static bool executer_lignes(Client* client, Produit** head, uint32_t* max_id, BilanServeur* bilan) {
+    /*
+    Argument:
+        client: Connexion dont les octets reçus contiennent des lignes complètes
+        head, max_id: Inventaire et compteur d'ID
+        bilan: Compteurs du serveur
+    But:
+        Exécuter toutes les commandes complètes reçues (les réponses sont
+        écrites dans un flux mémoire puis ajoutées en une fois au client) et
+        garder la ligne incomplète pour la prochaine lecture
+    Retour:
+        false si la connexion doit être fermée immédiatement (ligne trop longue,
+        erreur d'allocation)
+    */
+    char* reponses = NULL;
+    size_t taille_reponses = 0;
+    FILE* sortie = open_memstream(&reponses, &taille_reponses);
+    if (sortie == NULL) return false;
+
+    size_t debut = 0;
+    while (!client->lecture_finie) {
+        char* saut = memchr(client->entree + debut, '\n', client->entree_taille - debut);
+        if (saut == NULL) break;
+        *saut = '\0';
+        char* ligne = client->entree + debut;
+        debut = (size_t)(saut - client->entree) + 1;
+
+        bool ignoree = (ligne[0] == '\0' || ligne[0] == '#');
+        int res = commandes_executer_ligne(ligne, ++client->numero, sortie, head, max_id);
+        if (!ignoree) bilan->nb_commandes++;
+        if (res < 0) bilan->nb_erreurs++;
+        if (res > 0) client->lecture_finie = true; // "quit" : le reste est ignoré
+    }
+    fclose(sortie);
+
+    bool ok = ajouter_sortie(client, reponses, taille_reponses);
+    free(reponses);
+
+    memmove(client->entree, client->entree + debut, client->entree_taille - debut);
+    client->entree_taille -= debut;
+    return ok && client->entree_taille <= LIGNE_MAX;
+}
+
+static bool lire(Client* client, Produit** head, uint32_t* max_id, BilanServeur* bilan) {
+    /*
+    Argument:
+        client: Connexion lisible
+        head, max_id, bilan: Voir executer_lignes
+    But:
+        Lire tout ce que la socket a reçu et exécuter les commandes complètes
+        (pause si trop de réponses attendent d'être lues par le client).
+        En fin de flux, une dernière commande sans '\n' est exécutée aussi
+    Retour:
+        false si la connexion doit être fermée immédiatement
+    */
+    while (!client->lecture_finie && client->sortie_taille - client->sortie_envoye < SORTIE_MAX_EN_ATTENTE) {
+        if (client->entree_capacite - client->entree_taille < TAILLE_LECTURE) {
+            size_t nouvelle = client->entree_taille + TAILLE_LECTURE + 1; // + '\0' de fin de flux
+            char* agrandi = (char*)realloc(client->entree, nouvelle);
+            if (agrandi == NULL) return false;
+            client->entree = agrandi;
+            client->entree_capacite = nouvelle - 1;
+        }
+        ssize_t n = recv(client->fd, client->entree + client->entree_taille, TAILLE_LECTURE, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        if (n == 0) {
+            if (client->entree_taille > 0) client->entree[client->entree_taille++] = '\n';
+            if (!executer_lignes(client, head, max_id, bilan)) return false;
+            client->lecture_finie = true;
+            break;
+        }
+        client->entree_taille += (size_t)n;
+        if (!executer_lignes(client, head, max_id, bilan)) return false;
+    }
+    return true;
+}
+
+static void accepter(int epoll_fd, int ecoute, BilanServeur* bilan) {
+    /*
+    Argument:
+        epoll_fd: Boucle d'événements
+        ecoute: Socket d'écoute
+        bilan: Compteurs du serveur
+    But:
+        Accepter toutes les connexions en attente, puis réarmer la socket d'écoute
+    Retour:
+        Aucun
+    */
+    for (;;) {
+        int fd = accept(ecoute, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break; // EAGAIN : plus de connexion en attente (ou trop de descripteurs)
+        }
+        Client* client = (Client*)calloc(1, sizeof(Client));
+        if (client == NULL || rendre_non_bloquant(fd) != 0 || pthread_mutex_init(&client->passage, NULL) != 0) {
+            free(client);
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+
+        // Dans la liste avant d'être dans epoll : un autre thread peut la
+        // traiter (et la fermer) dès l'ajout
+        pthread_mutex_lock(&verrou_clients);
+        client->suivant = clients;
+        if (clients != NULL) clients->precedent = client;
+        clients = client;
+        pthread_mutex_unlock(&verrou_clients);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = client;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            fermer_client(epoll_fd, client);
+            continue;
+        }
+        bilan->nb_connexions++;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = NULL;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, ecoute, &ev);
+}
+
+static void retirer_perimes(Contexte* contexte) {
+    /*
+    Argument:
+        contexte: Boucle partagée par les threads
+    But:
+        Au plus une fois par seconde (un seul thread s'en charge), regarder
+        en lecture la prochaine échéance et ne prendre l'écriture que si un
+        produit est périmé
+    Retour:
+        Aucun
+    */
+    time_t maintenant = time(NULL);
+    long long dernier = atomic_load_explicit(&contexte->dernier_controle, memory_order_relaxed);
+    if (dernier >= (long long)maintenant
+        || !atomic_compare_exchange_strong(&contexte->dernier_controle, &dernier, (long long)maintenant)) {
+        return;
+    }
+
+    inventaire_verrouiller_lecture();
+    Produit* prochain = echeancier_prochain();
+    bool perime = (prochain != NULL && prochain->date_peremption < maintenant);
+    inventaire_deverrouiller();
+    if (!perime) return;
+
+    inventaire_verrouiller_ecriture();
+    supprimer_perimes(contexte->head, maintenant, false);
+    inventaire_deverrouiller();
+}
+
+static void* servir(void* argument) {
+    /*
+    Argument:
+        argument: Travailleur du thread
+    But:
+        Boucle d'un thread de service : attendre les événements de la boucle
+        partagée et traiter les connexions prêtes, jusqu'au réveil d'arrêt
+    Retour:
+        NULL
+    */
+    Travailleur* travailleur = (Travailleur*)argument;
+    Contexte* contexte = travailleur->contexte;
+    int epoll_fd = contexte->epoll_fd;
+    struct epoll_event evenements[EVENEMENTS_MAX];
+
+    while (!atomic_load(&arret_demande)) {
+        int nb = epoll_wait(epoll_fd, evenements, EVENEMENTS_MAX, ATTENTE_MAX_MS);
+        if (nb < 0) {
+            if (errno == EINTR) continue;
+            perror("[!] Erreur epoll_wait");
+            atomic_store(&arret_demande, true);
+            kill(getpid(), SIGTERM); // réveille le thread principal
+            break;
+        }
+        retirer_perimes(contexte);
+
+        for (int i = 0; i < nb; i++) {
+            Client* client = (Client*)evenements[i].data.ptr;
+            if (client == (Client*)(void*)reveil) continue; // le tube reste lisible : tous les threads le voient
+            if (client == NULL) {
+                accepter(epoll_fd, contexte->ecoute, &travailleur->bilan);
+                continue;
+            }
+            // Attend que le thread précédent ait fini de réarmer (voir surveiller)
+            pthread_mutex_lock(&client->passage);
+            pthread_mutex_unlock(&client->passage);
+            bool ok = true;
+            if (evenements[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                ok = lire(client, contexte->head, contexte->max_id, &travailleur->bilan);
+            }
+            // Réponses envoyées tout de suite : pas d'aller-retour par EPOLLOUT
+            // tant que la socket accepte les données
+            if (ok) ok = envoyer(client);
+            if (!ok || (client->lecture_finie && client->sortie_taille == 0)) {
+                fermer_client(epoll_fd, client);
+                continue;
+            }
+            surveiller(epoll_fd, client);
+        }
+    }
+    return NULL;
+}
+
+static unsigned int threads_a_lancer(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Nombre de threads de service : réglage, sinon un par coeur, borné
+    Retour:
+        Entre 1 et THREADS_SERVEUR_MAX
+    */
+    long nb = (long)nb_threads_serveur;
+    if (nb == 0) nb = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nb < 1) nb = 1;
+    if (nb > THREADS_SERVEUR_MAX) nb = THREADS_SERVEUR_MAX;
+    return (unsigned int)nb;
+}
+
+int serveur_executer(const char* chemin, Produit** head, uint32_t* max_id) {
+    /*
+    Argument:
+        chemin: Chemin de la socket Unix
+        head, max_id: Inventaire et compteur d'ID (l'inventaire reste au serveur)
+    But:
+        Servir les clients avec les threads de service jusqu'à SIGINT ou
+        SIGTERM (attendus ici par sigwait), puis réveiller les threads par
+        le tube d'arrêt, fermer toutes les connexions et supprimer la socket
+    Retour:
+        0 après un arrêt demandé, -1 si le serveur n'a pas pu démarrer
+    */
+    int ecoute = ouvrir_socket(chemin);
+    if (ecoute < 0) return -1;
+
+    int epoll_fd = epoll_create1(0);
+    struct epoll_event ev_ecoute, ev_reveil;
+    ev_ecoute.events = EPOLLIN | EPOLLONESHOT;
+    ev_ecoute.data.ptr = NULL; // NULL : socket d'écoute
+    ev_reveil.events = EPOLLIN;
+    ev_reveil.data.ptr = reveil;
+    if (epoll_fd < 0 || pipe(reveil) != 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ecoute, &ev_ecoute) != 0
+        || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, reveil[0], &ev_reveil) != 0) {
+        perror("[!] Erreur epoll");
+        if (reveil[0] >= 0) {
+            close(reveil[0]);
+            close(reveil[1]);
+            reveil[0] = reveil[1] = -1;
+        }
+        if (epoll_fd >= 0) close(epoll_fd);
+        close(ecoute);
+        unlink(chemin);
+        return -1;
+    }
+
+    // Signaux d'arrêt bloqués avant de lancer les threads (ils héritent du
+    // masque) : seul le thread principal les reçoit, par sigwait
+    sigset_t arret, masque_precedent;
+    sigemptyset(&arret);
+    sigaddset(&arret, SIGINT);
+    sigaddset(&arret, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &arret, &masque_precedent);
+    signal(SIGPIPE, SIG_IGN);
+    atomic_store(&arret_demande, false);
+
+    Contexte contexte;
+    contexte.epoll_fd = epoll_fd;
+    contexte.ecoute = ecoute;
+    contexte.head = head;
+    contexte.max_id = max_id;
+    atomic_init(&contexte.dernier_controle, 0);
+
+    unsigned int nb_threads = threads_a_lancer();
+    Travailleur travailleurs[THREADS_SERVEUR_MAX];
+    unsigned int nb_lances = 0;
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        travailleurs[i].contexte = &contexte;
+        travailleurs[i].bilan = (BilanServeur){0, 0, 0};
+        travailleurs[i].lance = (pthread_create(&travailleurs[i].thread, NULL, servir, &travailleurs[i]) == 0);
+        if (travailleurs[i].lance) nb_lances++;
+    }
+
+    if (nb_lances > 0) {
+        printf("Serveur BGRS en ecoute sur %s (%u threads)\n", chemin, nb_lances);
+        fflush(stdout);
+        int signal_recu;
+        sigwait(&arret, &signal_recu);
+    } else {
+        fprintf(stderr, "[!] Erreur : Aucun thread de service n'a pu etre lance\n");
+    }
+
+    atomic_store(&arret_demande, true);
+    ssize_t ecrit = write(reveil[1], "x", 1);
+    (void)ecrit; // tube vide et neuf : l'écriture d'un octet ne peut échouer
+    BilanServeur bilan = {0, 0, 0};
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        if (!travailleurs[i].lance) continue;
+        pthread_join(travailleurs[i].thread, NULL);
+        bilan.nb_connexions += travailleurs[i].bilan.nb_connexions;
+        bilan.nb_commandes += travailleurs[i].bilan.nb_commandes;
+        bilan.nb_erreurs += travailleurs[i].bilan.nb_erreurs;
+    }
+    pthread_sigmask(SIG_SETMASK, &masque_precedent, NULL);
+
+    // Arrêt : les connexions encore ouvertes sont fermées sans attendre
+    while (clients != NULL) {
+        fermer_client(epoll_fd, clients);
+    }
+    close(ecoute);
+    unlink(chemin);
+    close(reveil[0]);
+    close(reveil[1]);
+    reveil[0] = reveil[1] = -1;
+    close(epoll_fd);
+
+    fprintf(stderr, "[INFO] Serveur arrete : %zu connexions, %zu commandes (%zu erreurs)\n",
+            bilan.nb_connexions, bilan.nb_commandes, bilan.nb_erreurs);
+    return (nb_lances > 0) ? 0 : -1;
+}
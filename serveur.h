@@ -0,0 +1,32 @@
+#ifndef _SERVEUR_H
+#define _SERVEUR_H
+
+#include <stdint.h>
+
+#include "gestion_produit.h"
+
+/*
+    Mode serveur (./bgrs --serveur [socket]) : le processus garde l'inventaire
+    en mémoire et sert plusieurs opérateurs sur une socket Unix locale.
+    - Protocole : celui du mode commandes (commandes.h), une commande par
+      ligne. Un client peut envoyer plusieurs commandes sans attendre les
+      réponses : elles sont exécutées et répondues dans l'ordre.
+    - Une boucle d'événements epoll partagée par plusieurs threads de
+      service (un par coeur, ou serveur_configurer_threads), sockets non
+      bloquantes. EPOLLONESHOT : une connexion n'est traitée que par un
+      thread à la fois, ses commandes restent donc dans l'ordre.
+    - Les consultations (get, find, cat, list, summary) de clients différents
+      avancent en parallèle sous le verrou de lecture de l'inventaire ; les
+      modifications prennent le verrou d'écriture (voir gestion_produit.h).
+    - La prochaine péremption est contrôlée une fois par seconde ; le verrou
+      d'écriture n'est pris que si un produit est périmé.
+    - SIGINT ou SIGTERM arrêtent le serveur proprement ; "quit" ne ferme que
+      la connexion du client.
+*/
+
+#define SOCKET_SERVEUR_DEFAUT "bgrs.sock"
+
+void serveur_configurer_threads(unsigned int nb_threads);
+int serveur_executer(const char* chemin, Produit** head, uint32_t* max_id);
+
+#endif
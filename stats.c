@@ -0,0 +1,263 @@
+/*
+Nom du fichier : stats.c
+Fait par : Erwann GIRAULT
+But : Compteurs et histogrammes de durée des opérations de l'inventaire,
+      affichés par le menu ou la commande "stats" et exportés en JSON
+*/
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "stats.h"
+#include "colonnes.h"
+#include "memoire.h"
+
+#define CASES_PAR_OCTAVE 4 // 4 cases par puissance de 2 : 2 bits sous le bit de poids fort
+#define NB_CASES (CASES_PAR_OCTAVE * 63) // jusqu'à 2^64 ns
+
+#ifdef BGRS_SANS_STATS
+#define INSTRUMENTATION "false"
+#else
+#define INSTRUMENTATION "true"
+#endif
+
+typedef struct {
+    atomic_uint_least64_t total_ns; // le nombre d'appels est la somme des cases
+    atomic_uint_least64_t max_ns;
+    atomic_uint_least64_t cases[NB_CASES];
+} CompteurOperation;
+
+typedef struct {
+    uint64_t nombre;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+} ResumeOperation;
+
+static const char* const noms_operations[NB_OPERATIONS_STATS] = {
+    "ajout", "suppression", "modification", "recherche", "sauvegarde", "chargement", "purge"
+};
+
+static CompteurOperation compteurs[NB_OPERATIONS_STATS];
+static atomic_uint_least64_t octets_lus;
+static atomic_uint_least64_t octets_ecrits;
+static pthread_mutex_t verrou_export = PTHREAD_MUTEX_INITIALIZER; // un seul export à la fois vers le même fichier
+
+uint64_t stats_horloge(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Lire l'horloge monotone (pas d'appel système : vDSO)
+    Retour:
+        Temps en nanosecondes depuis une origine arbitraire
+    */
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static size_t case_duree(uint64_t ns) {
+    /*
+    Argument:
+        ns: Durée mesurée
+    But:
+        Trouver la case de l'histogramme : les valeurs 0 à 3 ont chacune leur
+        case, au-delà la puissance de 2 et les deux bits qui suivent le bit de
+        poids fort donnent la case
+    Retour:
+        Indice de la case
+    */
+    if (ns < CASES_PAR_OCTAVE) return (size_t)ns;
+    unsigned int octave = 63u - (unsigned int)__builtin_clzll(ns); // >= 2
+    size_t sous_case = (size_t)(ns >> (octave - 2)) & (CASES_PAR_OCTAVE - 1);
+    return (octave - 1) * CASES_PAR_OCTAVE + sous_case;
+}
+
+static uint64_t borne_case(size_t indice) {
+    /*
+    Argument:
+        indice: Case de l'histogramme
+    But:
+        Inverse de case_duree : plus grande durée rangée dans la case
+    Retour:
+        Durée en nanosecondes
+    */
+    if (indice < CASES_PAR_OCTAVE) return indice;
+    unsigned int decalage = (unsigned int)(indice / CASES_PAR_OCTAVE) - 1;
+    uint64_t debut = (uint64_t)(CASES_PAR_OCTAVE + indice % CASES_PAR_OCTAVE) << decalage;
+    return debut + (((uint64_t)1 << decalage) - 1);
+}
+
+void stats_noter(OperationStats operation, uint64_t debut) {
+    /*
+    Argument:
+        operation: Opération mesurée
+        debut: Valeur de stats_horloge au début de l'opération
+    But:
+        Compter l'opération et ranger sa durée dans l'histogramme
+    Retour:
+        Aucun
+    */
+    uint64_t fin = stats_horloge();
+    uint64_t duree = (fin > debut) ? fin - debut : 0;
+    CompteurOperation* c = &compteurs[operation];
+
+    atomic_fetch_add_explicit(&c->total_ns, duree, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->cases[case_duree(duree)], 1, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&c->max_ns, memory_order_relaxed);
+    while (duree > max && !atomic_compare_exchange_weak_explicit(&c->max_ns, &max, duree,
+                                                                   memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void stats_octets_lus(size_t octets) {
+    /*
+    Argument:
+        octets: Octets lus depuis un fichier de l'inventaire
+    But:
+        Cumuler le volume lu
+    Retour:
+        Aucun
+    */
+    atomic_fetch_add_explicit(&octets_lus, octets, memory_order_relaxed);
+}
+
+void stats_octets_ecrits(size_t octets) {
+    /*
+    Argument:
+        octets: Octets écrits dans un fichier de l'inventaire
+    But:
+        Cumuler le volume écrit
+    Retour:
+        Aucun
+    */
+    atomic_fetch_add_explicit(&octets_ecrits, octets, memory_order_relaxed);
+}
+
+static uint64_t quantile(const uint64_t* cases, uint64_t nombre, uint64_t max, unsigned int pour_mille) {
+    /*
+    Argument:
+        cases: Copie de l'histogramme
+        nombre: Total des cases
+        max: Durée maximale relevée (borne le résultat)
+        pour_mille: Quantile voulu (500 pour p50, 990 pour p99)
+    But:
+        Trouver la case qui contient le rang demandé
+    Retour:
+        Borne haute de cette case en nanosecondes (0 sans mesure)
+    */
+    if (nombre == 0) return 0;
+    uint64_t rang = (nombre * pour_mille + 999) / 1000;
+    if (rang == 0) rang = 1;
+    uint64_t cumul = 0;
+    for (size_t i = 0; i < NB_CASES; i++) {
+        cumul += cases[i];
+        if (cumul >= rang) {
+            uint64_t borne = borne_case(i);
+            return (borne < max) ? borne : max;
+        }
+    }
+    return max;
+}
+
+static void resumer(OperationStats operation, ResumeOperation* resume) {
+    /*
+    Argument:
+        operation: Opération à résumer
+        resume: Résultat
+    But:
+        Relever les compteurs d'une opération et calculer p50 et p99.
+        Les compteurs continuent d'avancer pendant la copie : le nombre, pris
+        sur l'histogramme copié, reste cohérent avec les quantiles
+    Retour:
+        Aucun
+    */
+    const CompteurOperation* c = &compteurs[operation];
+    uint64_t cases[NB_CASES];
+    uint64_t nombre = 0;
+    for (size_t i = 0; i < NB_CASES; i++) {
+        cases[i] = atomic_load_explicit(&c->cases[i], memory_order_relaxed);
+        nombre += cases[i];
+    }
+    resume->nombre = nombre;
+    resume->total_ns = atomic_load_explicit(&c->total_ns, memory_order_relaxed);
+    resume->max_ns = atomic_load_explicit(&c->max_ns, memory_order_relaxed);
+    resume->p50_ns = quantile(cases, nombre, resume->max_ns, 500);
+    resume->p99_ns = quantile(cases, nombre, resume->max_ns, 990);
+}
+
+void stats_afficher(FILE* sortie) {
+    /*
+    Argument:
+        sortie: Flux de sortie
+    But:
+        Afficher le tableau des statistiques (durées en microsecondes).
+        Le verrou de l'inventaire doit être tenu en lecture (nombre de produits)
+    Retour:
+        Aucun
+    */
+    fprintf(sortie, "Produits : %zu | Memoire : %.1f Ko (dont %.1f Ko rendus, a reutiliser)\n", colonnes_taille(),
+            (double)memoire_octets_reserves() / 1024.0, (double)memoire_octets_rendus() / 1024.0);
+    fprintf(sortie, "Octets lus : %llu | Octets ecrits : %llu\n",
+            (unsigned long long)atomic_load(&octets_lus), (unsigned long long)atomic_load(&octets_ecrits));
+#ifdef BGRS_SANS_STATS
+    fprintf(sortie, "Mesure des operations desactivee a la compilation (make STATS=0).\n");
+#else
+    fprintf(sortie, "%-13s %10s %10s %10s %10s %10s (us)\n", "Operation", "Nombre", "Moyenne", "p50", "p99", "Max");
+    for (int i = 0; i < NB_OPERATIONS_STATS; i++) {
+        ResumeOperation r;
+        resumer((OperationStats)i, &r);
+        double moyenne = (r.nombre > 0) ? (double)r.total_ns / (double)r.nombre / 1000.0 : 0.0;
+        fprintf(sortie, "%-13s %10llu %10.1f %10.1f %10.1f %10.1f\n", noms_operations[i], (unsigned long long)r.nombre,
+                moyenne, (double)r.p50_ns / 1000.0, (double)r.p99_ns / 1000.0, (double)r.max_ns / 1000.0);
+    }
+#endif
+}
+
+int stats_exporter(const char* chemin) {
+    /*
+    Argument:
+        chemin: Fichier JSON à (ré)écrire
+    But:
+        Écrire un instantané des statistiques (durées en nanosecondes), lisible
+        par un script de suivi. Même verrou que stats_afficher ; les exports
+        concurrents (clients du serveur en lecture) passent un par un
+    Retour:
+        0 si succès, -1 sinon
+    */
+    pthread_mutex_lock(&verrou_export);
+    FILE* fichier = fopen(chemin, "w");
+    if (fichier == NULL) {
+        pthread_mutex_unlock(&verrou_export);
+        return -1;
+    }
+
+    fprintf(fichier, "{\n  \"instrumentation\": %s,\n", INSTRUMENTATION);
+    fprintf(fichier, "  \"produits\": %zu,\n  \"memoire_octets\": %zu,\n  \"memoire_rendue_octets\": %zu,\n",
+            colonnes_taille(), memoire_octets_reserves(), memoire_octets_rendus());
+    fprintf(fichier, "  \"octets_lus\": %llu,\n  \"octets_ecrits\": %llu,\n",
+            (unsigned long long)atomic_load(&octets_lus), (unsigned long long)atomic_load(&octets_ecrits));
+    fprintf(fichier, "  \"operations\": {\n");
+    for (int i = 0; i < NB_OPERATIONS_STATS; i++) {
+        ResumeOperation r;
+        resumer((OperationStats)i, &r);
+        fprintf(fichier, "    \"%s\": {\"nombre\": %llu, \"total_ns\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu}%s\n",
+                noms_operations[i], (unsigned long long)r.nombre, (unsigned long long)r.total_ns,
+                (unsigned long long)r.p50_ns, (unsigned long long)r.p99_ns, (unsigned long long)r.max_ns,
+                (i + 1 < NB_OPERATIONS_STATS) ? "," : "");
+    }
+    fprintf(fichier, "  }\n}\n");
+
+    bool erreur = ferror(fichier);
+    if (fclose(fichier) != 0) erreur = true;
+    pthread_mutex_unlock(&verrou_export);
+    return erreur ? -1 : 0;
+}
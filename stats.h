@@ -0,0 +1,55 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+    Statistiques d'exécution (menu "Statistiques", commande "stats") :
+    - Pour chaque opération : nombre d'appels, temps total et maximal, et un
+      histogramme logarithmique des durées (4 cases par puissance de 2, soit
+      au plus 19 % d'écart) d'où sont tirés p50 et p99.
+    - Octets lus et écrits par les sauvegardes, les chargements et le journal
+      des opérations, nombre de produits et mémoire de la réserve.
+    - Les compteurs sont atomiques (relâchés) : le serveur les met à jour
+      depuis tous ses threads sans verrou.
+    - Compilé avec -DBGRS_SANS_STATS (make STATS=0), STATS_DEBUT, STATS_FIN et
+      STATS_OCTETS_* ne génèrent aucun code ; seuls produits et mémoire restent.
+*/
+
+typedef enum {
+    STATS_AJOUT,
+    STATS_SUPPRESSION,
+    STATS_MODIFICATION,
+    STATS_RECHERCHE,
+    STATS_SAUVEGARDE,
+    STATS_CHARGEMENT,
+    STATS_PURGE,
+    NB_OPERATIONS_STATS
+} OperationStats;
+
+/* Seul fichier d'export : la commande "stats export" est permise aux clients
+   du serveur, qui ne doivent pas pouvoir choisir un chemin à écraser */
+#define FICHIER_STATISTIQUES "statistiques.json"
+
+uint64_t stats_horloge(void);
+void stats_noter(OperationStats operation, uint64_t debut);
+void stats_octets_lus(size_t octets);
+void stats_octets_ecrits(size_t octets);
+void stats_afficher(FILE* sortie);
+int stats_exporter(const char* chemin);
+
+#ifdef BGRS_SANS_STATS
+#define STATS_DEBUT(debut)
+#define STATS_FIN(operation, debut) ((void)0)
+#define STATS_OCTETS_LUS(octets) ((void)0)
+#define STATS_OCTETS_ECRITS(octets) ((void)0)
+#else
+#define STATS_DEBUT(debut) uint64_t debut = stats_horloge()
+#define STATS_FIN(operation, debut) stats_noter((operation), (debut))
+#define STATS_OCTETS_LUS(octets) stats_octets_lus(octets)
+#define STATS_OCTETS_ECRITS(octets) stats_octets_ecrits(octets)
+#endif
+
+#endif
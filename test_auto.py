@@ -1,11 +1,17 @@
 import subprocess
 import os
 import shutil  
+import time
+import socket
+import signal
+import json
 
 # --- CONFIGURATION ---
 EXECUTABLE = "./bgrs"
 DB_FILE = "inventaire_sauvegarde.txt"
-LOG_FILE = "historique.log"
+LOG_FILE = "historique.bin"
+JOURNAL_FILE = DB_FILE + ".journal"
+STATS_FILE = "statistiques.json"
 
 # --- COULEURS DU TERMINAL ---
 GREEN = "\033[92m"
@@ -26,7 +32,7 @@ def log(message, type="INFO"):
 def backup_artifacts():
     """Sauvegarde les fichiers de prod actuels en .bak avant les tests"""
     print(f"{YELLOW}--- BACKUP DES DONNÉES ACTUELLES ---{RESET}")
-    for f in [DB_FILE, LOG_FILE]:
+    for f in [DB_FILE, LOG_FILE, JOURNAL_FILE, STATS_FILE]:
         if os.path.exists(f):
             backup_name = f + ".bak"
             shutil.copy(f, backup_name)
@@ -37,7 +43,7 @@ def backup_artifacts():
 def restore_artifacts():
     """Restaure les fichiers .bak et écrase les fichiers de test"""
     print(f"\n{YELLOW}--- RESTAURATION DES DONNÉES ---{RESET}")
-    for f in [DB_FILE, LOG_FILE]:
+    for f in [DB_FILE, LOG_FILE, JOURNAL_FILE, STATS_FILE]:
         backup_name = f + ".bak"
         if os.path.exists(backup_name):
             shutil.move(backup_name, f) 
@@ -50,7 +56,7 @@ def restore_artifacts():
 
 def clean_artifacts():
     """Nettoie les fichiers générés pour partir sur une base propre"""
-    for f in [DB_FILE, LOG_FILE]:
+    for f in [DB_FILE, LOG_FILE, JOURNAL_FILE, STATS_FILE]:
         if os.path.exists(f):
             os.remove(f)
 
@@ -64,10 +70,190 @@ def compile_project():
         exit(1)
     log("Compilation successful", "PASS")
 
-def run_scenario(name, inputs, expected_output_snippets=[], valgrind=False):
+def journal_insertions(data):
+    """Positions des enregistrements d'insertion complets du journal des
+    opérations (en-tête de 16 octets, puis longueur u32, somme u32, type u8)"""
+    positions, pos = [], 16
+    while len(data) - pos >= 9:
+        length = int.from_bytes(data[pos:pos + 4], "little")
+        if pos + 9 + length > len(data):
+            break
+        if data[pos + 8] == 3:
+            positions.append(pos)
+        pos += 9 + length
+    return positions
+
+def crash_after(args, commands, nb_insertions, timeout=10):
+    """Envoie les commandes puis tue le programme dès que le journal contient
+    nb_insertions insertions complètes, au lieu d'attendre au hasard"""
+    crash = subprocess.Popen([EXECUTABLE] + args, stdin=subprocess.PIPE, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, text=True)
+    crash.stdin.write(commands)
+    crash.stdin.flush()
+    deadline = time.time() + timeout
+    written = 0
+    while time.time() < deadline:
+        if os.path.exists(JOURNAL_FILE):
+            with open(JOURNAL_FILE, "rb") as f:
+                written = len(journal_insertions(f.read()))
+            if written >= nb_insertions:
+                break
+        time.sleep(0.01)
+    crash.kill()
+    crash.wait()
+    return written >= nb_insertions
+
+def run_server_scenario(name, clients, expected_output_snippets=[]):
+    """Lance ./bgrs --serveur, envoie les commandes de chaque client en une fois
+    (pipeline) sur des connexions simultanées, puis arrête le serveur par SIGTERM"""
+    sock_path = "test_bgrs.sock"
+    server = subprocess.Popen([EXECUTABLE, "--serveur", sock_path], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    try:
+        for _ in range(50):
+            if os.path.exists(sock_path):
+                break
+            time.sleep(0.05)
+        conns = []
+        for commands in clients:
+            c = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            c.settimeout(3)
+            c.connect(sock_path)
+            c.sendall(("\n".join(commands) + "\n").encode())
+            c.shutdown(socket.SHUT_WR)
+            conns.append(c)
+        replies = ""
+        for c in conns:
+            with c.makefile("rb") as f:
+                replies += f.read().decode()
+            c.close()
+        server.send_signal(signal.SIGTERM)
+        server.communicate(timeout=3)
+
+        for snippet in expected_output_snippets:
+            if snippet not in replies:
+                log(f"Scenario '{name}': Missing expected output '{snippet}'", "FAIL")
+                return False
+        if os.path.exists(sock_path):
+            log(f"Scenario '{name}': socket not removed on shutdown", "FAIL")
+            return False
+        log(f"Scenario '{name}': Success", "PASS")
+        return True
+    except Exception as e:
+        server.kill()
+        server.wait()
+        log(f"Scenario '{name}': Exception {e}", "FAIL")
+        return False
+
+def run_server_stress():
+    """Plusieurs clients envoient en même temps leurs commandes à ./bgrs --serveur
+    (journalisation active) : chaque ajout reçoit un ID distinct, chaque
+    relecture retrouve son produit, et le total final est exact"""
+    clean_artifacts()
+    sock_path = "test_bgrs.sock"
+    clients, per_client = 8, 300
+    server = subprocess.Popen([EXECUTABLE, "--serveur", sock_path], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True,
+                              env={**os.environ, "BGRS_SERVEUR_THREADS": "4"})
+    try:
+        for _ in range(100):
+            if os.path.exists(sock_path):
+                break
+            time.sleep(0.05)
+        conns = []
+        for c in range(clients):
+            commands = []
+            for i in range(per_client):
+                commands += [f"add Client {c} article {i}|d|Stress{c % 3}|1|2|0|", f"find client {c} article {i}", "summary"]
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.settimeout(30)
+            s.connect(sock_path)
+            s.sendall(("\n".join(commands) + "\n").encode())
+            s.shutdown(socket.SHUT_WR)
+            conns.append(s)
+        replies = []
+        for s in conns:
+            with s.makefile("rb") as f:
+                replies.append(f.read().decode())
+            s.close()
+
+        last = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        last.settimeout(5)
+        last.connect(sock_path)
+        last.sendall(b"summary\n")
+        last.shutdown(socket.SHUT_WR)
+        with last.makefile("rb") as f:
+            final = f.read().decode()
+        last.close()
+        server.send_signal(signal.SIGTERM)
+        server.communicate(timeout=5)
+
+        for c, reply in enumerate(replies):
+            lines = reply.splitlines()
+            for i in range(per_client):
+                if not any(l.split("|")[1:2] == [f"Client {c} article {i}"] for l in lines):
+                    log(f"Scenario 'Server Stress': client {c} never found article {i}", "FAIL")
+                    return False
+            if any(l.startswith("erreur") for l in lines):
+                log(f"Scenario 'Server Stress': client {c} got an error", "FAIL")
+                return False
+        added = [int(l.split("|")[0]) for r in replies for l in r.splitlines() if "|" in l]
+        if f"produits {clients * per_client} " not in final or len(set(added)) != clients * per_client:
+            log(f"Scenario 'Server Stress': expected {clients * per_client} distinct products, got: {final.strip()}", "FAIL")
+            return False
+        log(f"Scenario 'Server Stress': {clients} clients, {clients * per_client * 3} commands", "PASS")
+        return True
+    except Exception as e:
+        server.kill()
+        server.wait()
+        log(f"Scenario 'Server Stress': Exception {e}", "FAIL")
+        return False
+    finally:
+        clean_artifacts()
+
+def run_concurrency_test():
+    """Construit test_concurrence (ThreadSanitizer) et le lance : lecteurs et
+    écrivains en parallèle sur l'inventaire partagé, sans puis avec
+    journalisation, puis clients du serveur"""
+    build = subprocess.run(["make", "test_concurrence"], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    if build.returncode != 0:
+        log("Scenario 'Concurrency Stress': ThreadSanitizer unavailable, skipped", "WARN")
+        return True
+    try:
+        result = subprocess.run(["./test_concurrence"], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, timeout=120)
+    except subprocess.TimeoutExpired:
+        log("Scenario 'Concurrency Stress': Timeout (deadlock?)", "FAIL")
+        return False
+    if result.returncode != 0 or "Concurrence OK" not in result.stdout:
+        log("Scenario 'Concurrency Stress': Data race or inconsistency detected", "FAIL")
+        print(result.stderr[-4000:])
+        return False
+    log(f"Scenario 'Concurrency Stress': {result.stdout.strip().splitlines()[-1]}", "PASS")
+    return True
+
+def run_bench_smoke():
+    """Construit bench_bgrs et le lance sur un petit inventaire : la sortie
+    doit être du JSON avec une mesure par opération"""
+    build = subprocess.run(["make", "bench_bgrs"], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    if build.returncode != 0:
+        log("Scenario 'Benchmark JSON': build failed", "FAIL")
+        print(build.stderr.decode())
+        return False
+    try:
+        result = subprocess.run(["./bench_bgrs", "--tailles", "1000"], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, timeout=30)
+        operations = {r["operation"] for r in json.loads(result.stdout)["resultats"]}
+    except Exception as e:
+        log(f"Scenario 'Benchmark JSON': Exception {e}", "FAIL")
+        return False
+    expected = {"creer_produit", "insertion", "rechercher_par_id", "recherche_nom", "sauvegarde", "supprimer_perimes", "charger_fichier",
+                "sauvegarde_binaire", "charger_binaire"}
+    if result.returncode != 0 or operations != expected:
+        log(f"Scenario 'Benchmark JSON': unexpected operations {sorted(operations)}", "FAIL")
+        return False
+    log("Scenario 'Benchmark JSON': Success", "PASS")
+    return True
+
+def run_scenario(name, inputs, expected_output_snippets=[], valgrind=False, args=[], env={}, unexpected_output_snippets=[], with_stderr=False):
     input_str = "\n".join(inputs) + "\n"
     
-    cmd = [EXECUTABLE]
+    cmd = [EXECUTABLE] + args
     if valgrind:
         cmd = ["valgrind", "--leak-check=full", "--error-exitcode=100"] + cmd
 
@@ -77,9 +263,12 @@ def run_scenario(name, inputs, expected_output_snippets=[], valgrind=False):
             stdin=subprocess.PIPE,
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
-            text=True
+            text=True,
+            env={**os.environ, **env}
         )
         stdout, stderr = process.communicate(input=input_str, timeout=3)
+        if with_stderr: # messages d'erreur cherchés aussi sur la sortie d'erreur
+            stdout += stderr
 
         if valgrind and process.returncode == 100:
             log(f"Scenario '{name}': Memory Leak/Error detected via Valgrind!", "FAIL")
@@ -90,6 +279,10 @@ def run_scenario(name, inputs, expected_output_snippets=[], valgrind=False):
             if snippet not in stdout:
                 log(f"Scenario '{name}': Missing expected output '{snippet}'", "FAIL")
                 return False
+        for snippet in unexpected_output_snippets:
+            if snippet in stdout:
+                log(f"Scenario '{name}': Unexpected output '{snippet}'", "FAIL")
+                return False
 
         log(f"Scenario '{name}': Success", "PASS")
         return True
@@ -102,6 +295,113 @@ def run_scenario(name, inputs, expected_output_snippets=[], valgrind=False):
         log(f"Scenario '{name}': Exception {e}", "FAIL")
         return False
 
+def run_churn_test():
+    """Ajouts, modifications (chaînes plus longues, donc déplacées) et
+    suppressions en boucle : la réserve mémoire doit cesser de grandir
+    après les premiers tours, et l'index des noms ne doit plus rien trouver
+    une fois tout supprimé"""
+    clean_artifacts()
+    rounds, per_round = 30, 200
+    commands = []
+    next_id = 1
+    for r in range(rounds):
+        first = next_id
+        for i in range(per_round):
+            commands.append(f"add Tour {r} {i}{'x' * (i % 40)}|{'d' * (i % 300)}|c{i % 5}|{i}|1.5|0|{'n' * (i % 50)}")
+        for i in range(per_round):
+            commands.append(f"mod {first + i} Modif {i}{'y' * (i % 45)}|{'e' * (i % 400)}|c{(i + 1) % 5}||||{'m' * (i % 60)}")
+        for i in range(per_round):
+            commands.append(f"del {first + i}")
+        next_id += per_round
+        if r in (2, rounds - 1):
+            commands.append("stats")
+    commands += ["find modif", "find tour", "add Modif final|d|c|1|1.5|0|", "find modif"]
+    result = subprocess.run([EXECUTABLE, "--commandes"], input="\n".join(commands) + "\n",
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, timeout=60)
+    sizes = [float(line.split("Memoire : ")[1].split(" Ko")[0]) for line in result.stdout.splitlines() if "Memoire : " in line]
+    if result.returncode != 0 or len(sizes) != 2:
+        log(f"Scenario 'Memory Churn': unexpected output (code {result.returncode})", "FAIL")
+    elif [l for l in result.stdout.splitlines() if l.startswith("ok ")][-4:] != ["ok 0", "ok 0", f"ok {next_id}", "ok 1"]:
+        log("Scenario 'Memory Churn': name index still returns deleted products", "FAIL")
+    elif sizes[1] > sizes[0]:
+        log(f"Scenario 'Memory Churn': reserve grew from {sizes[0]} Ko to {sizes[1]} Ko", "FAIL")
+    else:
+        log(f"Scenario 'Memory Churn': reserve stable at {sizes[1]} Ko after {rounds} rounds", "PASS")
+    clean_artifacts()
+
+def run_history_tests():
+    """Historique : l'ancien historique.log est laissé tel quel, et une
+    rotation impossible (archives occupées par des dossiers) est signalée
+    sans perdre les événements suivants"""
+    clean_artifacts()
+    legacy = "[Mon Jan  5 10:00:00 2026] [+] Ajout du produit ID 1 : Ancien (Qte: 1)\n"
+    if os.path.exists("historique.log"):
+        shutil.move("historique.log", "historique.log.test_sauve")
+    with open("historique.log", "w") as f:
+        f.write(legacy)
+    run_scenario("Legacy History Untouched", ["add Nouveau|d|c|1|1|0|"], ["ok 1"], args=["--commandes"])
+    run_scenario("Legacy History Reader", [], ["Ajout du produit ID 1 : Nouveau", "historique.log (ancien format texte) n'est pas relu"],
+                 args=["--historique"], with_stderr=True, unexpected_output_snippets=["Ancien"])
+    with open("historique.log") as f:
+        if f.read() != legacy:
+            log("Scenario 'Legacy History Untouched': historique.log was modified", "FAIL")
+    os.remove("historique.log")
+    if os.path.exists("historique.log.test_sauve"):
+        shutil.move("historique.log.test_sauve", "historique.log")
+
+    clean_artifacts()
+    archives = [f"{LOG_FILE}.{i}" for i in range(1, 10)]
+    for a in archives:
+        os.makedirs(os.path.join(a, "occupe"))
+    try:
+        count = 20000  # un peu plus de 1 Mo d'historique : au moins une rotation
+        commands = [f"add Produit {i} au nom assez long pour remplir vite|description|cat|1|1|0|" for i in range(count)]
+        result = subprocess.run([EXECUTABLE, "--commandes"], input="\n".join(commands) + "\n", env={**os.environ, "BGRS_JOURNAL": "lot:64,rotation:1"},
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True, timeout=60)
+        reader = subprocess.run([EXECUTABLE, "--historique", "--id", str(count)], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, timeout=30)
+        if result.stderr.count("Rotation de historique.bin impossible") != 1:
+            log("Scenario 'History Rotation Failure': failure not reported exactly once", "FAIL")
+        elif f"Ajout du produit ID {count} :" not in reader.stdout:
+            log("Scenario 'History Rotation Failure': events after the failed rotation were lost", "FAIL")
+        else:
+            log("Scenario 'History Rotation Failure': reported once, no event lost", "PASS")
+    finally:
+        for a in archives:
+            shutil.rmtree(a, ignore_errors=True)
+    clean_artifacts()
+
+def run_snapshot_tests():
+    """Instantané binaire (BGRS_FORMAT=binaire) : aller-retour, puis fichiers
+    tronqué, corrompu et en-tête forgé, tous refusés au chargement"""
+    clean_artifacts()
+    run_scenario("Binary Snapshot (Save)", ["8", "6", "9"], ["Sauvegarde terminee"], env={"BGRS_FORMAT": "binaire"})
+    with open(DB_FILE, "rb") as f:
+        snapshot = f.read()
+    if not snapshot.startswith(b"BGRSINST"):
+        log("Scenario 'Binary Snapshot (Save)': file is not a binary snapshot", "FAIL")
+    os.remove(JOURNAL_FILE)
+    run_scenario("Binary Snapshot (Load)", ["7", "1", "9"], ["Chargement termine", "Duct tape", "Prix Unitaire: 120.00"])
+
+    def reject(name, data, message):
+        with open(DB_FILE, "wb") as f:
+            f.write(data)
+        if os.path.exists(JOURNAL_FILE):
+            os.remove(JOURNAL_FILE)
+        run_scenario(name, ["7", "1", "9"], [message, "Inventaire vide"], with_stderr=True, unexpected_output_snippets=["Duct tape"])
+
+    reject("Binary Snapshot (Truncated)", snapshot[:len(snapshot) - 10], "tronqué ou corrompu")
+    corrupted = bytearray(snapshot)
+    corrupted[-5] ^= 0x20
+    reject("Binary Snapshot (Corrupted)", bytes(corrupted), "somme de contrôle invalide")
+    # nb_produits et taille du tas choisis pour que nb * 72 + tas retombe, modulo 2^64,
+    # sur la taille du fichier
+    forged = bytearray(snapshot)
+    nb = 2**58
+    forged[16:24] = nb.to_bytes(8, "little")
+    forged[24:32] = ((len(snapshot) - 64 - nb * 72) % 2**64).to_bytes(8, "little")
+    reject("Binary Snapshot (Forged Header)", bytes(forged), "taille incohérente")
+    clean_artifacts()
+
 # --- DÉBUT DE LA BATTERIE DE TESTS ---
 
 def main():
@@ -149,6 +449,111 @@ def main():
         
         run_scenario("Modif Bad ID", ["8", "4", "999", "9"], ["Produit introuvable"], valgrind=True)
 
+        # Recherche par l'index des trigrammes, qui doit suivre le renommage
+        run_scenario("Name Search", ["8", "5", "PANS", "4", "6", "Bistouri Laser", "\n", "\n", "\n", "\n", "\n", "\n", "5", "photon", "9"], ["Pansement Ecoprix", "Aucun produit contenant 'photon' trouve"], valgrind=True)
+
+        # Clé de recherche normalisée : casse et accents ignorés
+        run_scenario("Accent Search", ["2", "Sérum Réparateur", "Desc", "Potion", "1", "1", "0", "", "5", "SERUM rep", "9"], ["[1] Sérum Réparateur"], valgrind=True)
+
+        # Index par catégorie : suit les changements de catégorie
+        run_scenario("Category Listing", ["8", "4", "2", "", "", "Outil", "", "", "", "", "11", "Outil", "9"], ["Scalpel Photonique", "Duct tape", "Produits : 2 - Valeur : 440.00"], valgrind=True)
+
+        # Mode commandes : pas de menu, une réponse par commande
+        run_scenario("Batch Commands", ["add Potion Test|Desc|Potion|3|2.5|0|", "add Bad|D|Cat|-1|1|0", "find POTION", "del 1", "get 1", "quit"],
+                     ["ok 1", "erreur 2 : quantite invalide", "1|Potion Test|Desc|Potion|3|2.50|0|", "erreur 5 : ID introuvable"], valgrind=True, args=["--commandes"])
+
+        # Prix non représentables en float : refusés, les totaux restent finis
+        run_scenario("Batch Invalid Prices", ["add X|d|c|1|inf|0|", "add X|d|c|1|1e39|0|", "add X|d|c|1|nan|0|",
+                                              "add Y|d|c|2|1.5|0|", "mod 1 ||||infinity||", "categories"],
+                     ["erreur 1 : prix invalide", "erreur 2 : prix invalide", "erreur 3 : prix invalide",
+                      "erreur 5 : prix invalide", "c|1|2|3.00"], args=["--commandes"],
+                     unexpected_output_snippets=["inf|", "|inf", "nan"])
+
+        # Mode serveur : deux clients simultanés, commandes envoyées en pipeline
+        run_server_scenario("Server Mode", [["add Potion Serveur|D|Potion|3|2.5|0|", "get 1", "find serveur"], ["summary", "frob"]],
+                            ["ok 1", "1|Potion Serveur|D|Potion|3|2.50|0|", "erreur 2 : commande inconnue"])
+
+        # Un client ne choisit pas le fichier d'export des statistiques
+        if run_server_scenario("Server Stats Export", [["stats test_ecrase.json", "stats export"]],
+                               ["erreur 1 : stats attend [export]", "ok"]):
+            if not os.path.exists(STATS_FILE) or os.path.exists("test_ecrase.json"):
+                log("Scenario 'Server Stats Export': export written to the wrong file", "FAIL")
+            if os.path.exists("test_ecrase.json"):
+                os.remove("test_ecrase.json")
+
+        run_concurrency_test()
+        run_bench_smoke()
+
+        # Affichage : champs choisis, produit sans péremption
+        run_scenario("Field Selection", ["8", "1", "9"], ["Nom: WD-40", "Date de Peremption: Aucune"], valgrind=True,
+                     env={"BGRS_CHAMPS": "nom,peremption"}, unexpected_output_snippets=["1970", "Description:"])
+        run_scenario("Paged List", ["add A|d|c|1|1|0|", "add B|d|c|2|2|0|", "add C|d|c|3|3|0|", "list 1 1"],
+                     ["2|B|d|c|2|2.00|0|"], args=["--commandes"], unexpected_output_snippets=["1|A|d", "3|C|d"])
+
+        # Vues triées : tenues à jour par l'ajout et la modification, sans trier la liste
+        run_scenario("Sorted Views", ["add A|d|c|5|3|0|", "add B|d|c|1|7|1900000000|", "add C|d|c|9|1|1800000000|",
+                                      "mod 3 ||||12||", "top prix 1", "top peremption 1"],
+                     ["1|A|d|c|5|3.00|0|", "3|C|d|c|9|12.00|1800000000|"], args=["--commandes"],
+                     unexpected_output_snippets=["2|B|d"])
+
+        # Péremptions dans un intervalle (bornes incluses, produits sans date ignorés)
+        run_scenario("Expiry Range", ["add Bientot|d|c|1|1|4000000000|", "add Plus tard|d|c|1|1|4100000000|",
+                                      "add Jamais|d|c|1|1|0|", "expiring 0 4050000000"],
+                     ["1|Bientot|d|c|1|1.00|4000000000|", "ok 1"], args=["--commandes"],
+                     unexpected_output_snippets=["Plus tard|d", "Jamais|d"])
+
+        # Agrégats par catégorie : suivis par ajout, modification, suppression et rechargement
+        run_scenario("Category Aggregates", ["add A|d|Outil|3|2.5|0|", "add B|d|Outil|4|1.25|0|", "add C|d|Soin|10|0.1|0|",
+                                             "mod 2 ||Soin|6|||", "mod 1 |||5|||", "del 3", "categories",
+                                             "save", "load", "categories"],
+                     ["Outil|1|5|12.50", "Soin|1|6|7.50", "ok 2"], args=["--commandes"],
+                     unexpected_output_snippets=["Outil|2|", "Soin|2|"])
+
+        # Historique binaire : relu au format texte, filtré par produit
+        run_scenario("History Reader", [], ["[+] Ajout du produit ID 4 : Serum de Vitalite Beta", "Suppression du produit ID 4"],
+                     args=["--historique", "--id", "4"], unexpected_output_snippets=["ID 1 :", "ID 3 :"])
+
+        # Statistiques : compteurs des opérations et export JSON
+        run_scenario("Operation Stats", ["8", "5", "pot", "6", "12", "9"],
+                     ["Produits : 7", "recherche", "Statistiques exportees dans statistiques.json"], valgrind=True)
+
+        run_scenario("Stock Summary", ["8", "3", "1", "10", "9"], ["Valeur totale : 1207.00", "Stock faible (< 5) : 1", "Categorie"], valgrind=True)
+
+        # Test Reprise après arrêt brutal (journal des opérations)
+        if not crash_after([], "8\n", 7):
+            log("Scenario 'Crash Recovery': journal never reached 7 insertions", "FAIL")
+        run_scenario("Crash Recovery", ["1", "9"], ["operations rejouees", "Duct tape"], valgrind=True)
+
+        # Reprise d'une longue série d'insertions (rejouée en un lot)
+        if not crash_after(["--commandes"], "".join(f"add Lot {i}|d|Rafale|{i}|1|0|\n" for i in range(1, 2001)), 2000):
+            log("Scenario 'Bulk Crash Recovery': journal never reached 2000 insertions", "FAIL")
+        with open(JOURNAL_FILE, "rb") as f:
+            journal = f.read()
+        run_scenario("Bulk Crash Recovery", ["list 0 1", "find lot 1999", "cat Rafale"],
+                     ["2000 operations rejouees", "2000|Lot 2000|d|Rafale|2000|", "1999|Lot 1999|d|Rafale|1999|", "ok 2000"],
+                     args=["--commandes"], with_stderr=True, unexpected_output_snippets=["ignorees"])
+
+        # Enregistrement à la somme valide mais indécodable (note sans '\0') :
+        # la reprise en lot l'écarte et le signale
+        bad = bytearray(journal)
+        pos = journal_insertions(journal)[41]
+        length = int.from_bytes(bad[pos:pos + 4], "little")
+        bad[pos + 9 + length - 1] = ord("X")
+        checksum = 2166136261
+        for byte in bad[pos + 8:pos + 9 + length]:
+            checksum = ((checksum ^ byte) * 16777619) % 2**32
+        bad[pos + 4:pos + 8] = checksum.to_bytes(4, "little")
+        with open(JOURNAL_FILE, "wb") as f:
+            f.write(bad)
+        run_scenario("Bulk Crash Recovery (Bad Record)", ["get 42", "cat Rafale"],
+                     ["1999 operations rejouees", "1 operations du journal illisibles ou refusees", "erreur 1 : ID introuvable", "ok 1999"],
+                     args=["--commandes"], with_stderr=True)
+
+        run_snapshot_tests()
+        run_history_tests()
+        run_churn_test()
+        run_server_stress()
+
     except KeyboardInterrupt:
         print(f"\n{RED}[!] Tests interrompus par l'utilisateur.{RESET}")
     except Exception as e:
@@ -0,0 +1,653 @@
+/*
+Nom du fichier : test_concurrence.c
+Fait par : Erwann GIRAULT
+But : Test de charge multithread de l'inventaire partagé : des lecteurs
+      (recherche par ID, par nom, par catégorie, vue triée, parcours de la liste)
+      tournent pendant que des écrivains ajoutent, modifient et suppriment.
+      Trois passes : sans journalisation, avec historique et journal des
+      opérations, puis des clients qui envoient leurs commandes au serveur
+      (socket Unix) pendant que les lecteurs continuent.
+      Construit avec -fsanitize=thread par "make test_concurrence"
+*/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gestion_produit.h"
+#include "index_id.h"
+#include "index_nom.h"
+#include "colonnes.h"
+#include "categories.h"
+#include "index_tri.h"
+#include "journal.h"
+#include "journal_ops.h"
+#include "historique.h"
+#include "serveur.h"
+
+#define NB_LECTEURS 6
+#define NB_ECRIVAINS 2
+#define OPERATIONS_PAR_ECRIVAIN 5000
+#define PRODUITS_INITIAUX 2000
+#define NB_CATEGORIES 8
+#define PREFIXE "produit-"
+#define NB_CLIENTS 4
+#define TOURS_PAR_CLIENT 300
+#define PREFIXE_SERVEUR "serveur-" // le reste du nom est recopié dans la note
+#define FICHIER_TEST_HISTORIQUE "test_concurrence.bin"
+#define FICHIER_TEST_SAUVEGARDE "test_concurrence.txt"
+#define FICHIER_TEST_JOURNAL FICHIER_TEST_SAUVEGARDE ".journal"
+#define SOCKET_TEST "test_concurrence.sock"
+#define TAILLE_REPONSE 512
+
+static Produit* head = NULL;
+static uint32_t max_id = 0;          // protégé par le verrou d'écriture
+static atomic_bool ecritures_finies = false;
+static atomic_size_t nb_erreurs = 0;
+static atomic_size_t nb_lectures = 0;
+static atomic_size_t nb_appliquees = 0; // ajouts, modifications et suppressions réussis
+static atomic_long bilan_produits = 0;  // ajouts moins suppressions des clients du serveur
+
+static void signaler(const char* message, uint32_t id) {
+    /*
+    Argument:
+        message: Incohérence constatée
+        id: Produit concerné
+    But:
+        Compter une erreur (les 10 premières sont affichées)
+    Retour:
+        Aucun
+    */
+    if (atomic_fetch_add(&nb_erreurs, 1) < 10) {
+        fprintf(stderr, "[!] %s (ID %u)\n", message, id);
+    }
+}
+
+static void verifier_produit(const Produit* p) {
+    /*
+    Argument:
+        p: Produit lu sous le verrou de lecture
+    But:
+        Le nom porte l'ID ("produit-ID" suivi d'un suffixe éventuel), ou
+        pour un produit venu du serveur la note recopie la fin du nom, et la
+        catégorie est bien le libellé interné de id_categorie : un nœud
+        libéré puis réutilisé ou une modification à moitié faite se voient
+    Retour:
+        Aucun
+    */
+    if (strncmp(p->nom, PREFIXE_SERVEUR, strlen(PREFIXE_SERVEUR)) == 0) {
+        if (strcmp(p->nom + strlen(PREFIXE_SERVEUR), p->note) != 0) {
+            signaler("nom et note d'un produit du serveur differents", p->id);
+        }
+    } else if (strncmp(p->nom, PREFIXE, strlen(PREFIXE)) != 0
+               || strtoul(p->nom + strlen(PREFIXE), NULL, 10) != p->id) {
+        signaler("nom qui ne correspond pas a l'ID", p->id);
+    }
+    if (p->categorie != categories_nom(p->id_categorie)) {
+        signaler("categorie qui ne correspond pas a son ID", p->id);
+    }
+}
+
+static Produit* nouveau_produit(uint32_t id, unsigned int* graine) {
+    /*
+    Argument:
+        id: ID du produit
+        graine: Graine rand_r du thread
+    But:
+        Créer un produit de test (nom d'une longueur variable pour que les
+        modifications changent de zone mémoire)
+    Retour:
+        Le produit, ou NULL en cas d'erreur
+    */
+    char nom[65];
+    char categorie[16];
+    int suffixe = rand_r(graine) % 40;
+    snprintf(nom, sizeof(nom), PREFIXE "%u-%.*s", id, suffixe, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+    snprintf(categorie, sizeof(categorie), "cat%d", rand_r(graine) % NB_CATEGORIES);
+    time_t date = (rand_r(graine) % 2) ? 0 : (time(NULL) + 3600 + rand_r(graine) % 100000);
+    return creer_produit(id, nom, "description", categorie, rand_r(graine) % 100,
+                         (float)(rand_r(graine) % 1000) / 10.0f, date, "note");
+}
+
+static void* ecrire(void* argument) {
+    /*
+    Argument:
+        argument: Graine du thread
+    But:
+        Ajouter, modifier et supprimer des produits au hasard
+    Retour:
+        NULL
+    */
+    unsigned int graine = (unsigned int)(uintptr_t)argument;
+    for (int i = 0; i < OPERATIONS_PAR_ECRIVAIN; i++) {
+        int choix = rand_r(&graine) % 10;
+        inventaire_verrouiller_ecriture();
+        if (choix < 4) {
+            Produit* p = nouveau_produit(max_id + 1, &graine);
+            if (p == NULL || insertion(&head, p) != 0) {
+                signaler("ajout refuse", max_id + 1);
+                if (p != NULL) liberer_produit(p);
+            } else {
+                max_id++;
+                atomic_fetch_add(&nb_appliquees, 1);
+            }
+        } else {
+            uint32_t id = 1 + (uint32_t)rand_r(&graine) % max_id;
+            Produit* p = rechercher_par_id(head, id);
+            if (p != NULL && choix < 7) {
+                char nom[65];
+                char categorie[16];
+                snprintf(nom, sizeof(nom), PREFIXE "%u-%.*s", id, rand_r(&graine) % 40, "modifiemodifiemodifiemodifiemodifiemodifie");
+                snprintf(categorie, sizeof(categorie), "cat%d", rand_r(&graine) % NB_CATEGORIES);
+                if (modifier_produit(p, nom, p->description, categorie, p->quantite + 1, p->prix_unitaire,
+                                     p->date_peremption, p->note) == NULL) {
+                    signaler("modification refusee", id);
+                } else {
+                    atomic_fetch_add(&nb_appliquees, 1);
+                }
+            } else if (p != NULL && suppression_par_id(&head, id) == 0) {
+                atomic_fetch_add(&nb_appliquees, 1);
+            }
+        }
+        inventaire_deverrouiller();
+    }
+    return NULL;
+}
+
+static void* lire(void* argument) {
+    /*
+    Argument:
+        argument: Graine du thread
+    But:
+        Consulter l'inventaire de toutes les façons tant que les écrivains
+        travaillent, en vérifiant chaque produit rencontré
+    Retour:
+        NULL
+    */
+    unsigned int graine = (unsigned int)(uintptr_t)argument;
+    while (!atomic_load(&ecritures_finies)) {
+        int choix = rand_r(&graine) % 100;
+        inventaire_verrouiller_lecture();
+        if (choix < 80) {
+            uint32_t id = 1 + (uint32_t)rand_r(&graine) % (PRODUITS_INITIAUX * 4);
+            Produit* p = rechercher_par_id(head, id);
+            if (p != NULL) {
+                if (p->id != id) signaler("index d'ID incoherent", id);
+                verifier_produit(p);
+            }
+        } else if (choix < 90) {
+            char motif[32];
+            snprintf(motif, sizeof(motif), PREFIXE "%d", 1 + rand_r(&graine) % 999);
+            Produit** resultats;
+            size_t nb;
+            if (index_nom_rechercher(motif, &resultats, &nb) != 0) signaler("recherche en echec", 0);
+            for (size_t i = 0; i < nb; i++) {
+                if (strstr(resultats[i]->nom, motif) == NULL) signaler("resultat de recherche faux", resultats[i]->id);
+                verifier_produit(resultats[i]);
+            }
+            free(resultats);
+        } else if (choix < 94) {
+            Produit* premiers[16];
+            bool decroissant = (rand_r(&graine) % 2 == 0);
+            size_t nb = index_tri_premiers(TRI_PRIX, decroissant, 16, premiers);
+            for (size_t i = 0; i < nb; i++) {
+                verifier_produit(premiers[i]);
+                if (i > 0 && (decroissant ? premiers[i]->prix_unitaire > premiers[i - 1]->prix_unitaire
+                                          : premiers[i]->prix_unitaire < premiers[i - 1]->prix_unitaire)) {
+                    signaler("vue triee dans le desordre", premiers[i]->id);
+                }
+            }
+        } else if (choix < 97) {
+            char nom[16];
+            snprintf(nom, sizeof(nom), "cat%d", rand_r(&graine) % NB_CATEGORIES);
+            uint32_t id = categories_chercher(nom);
+            size_t taille = categories_taille(id);
+            for (size_t i = 0; i < taille; i++) {
+                Produit* p = categories_membre(id, i);
+                if (p->id_categorie != id) signaler("membre d'une autre categorie", p->id);
+                verifier_produit(p);
+            }
+        } else {
+            size_t nb = 0;
+            const Produit* precedent = NULL;
+            for (const Produit* actu = head; actu != NULL; actu = actu->suivant, nb++) {
+                if (actu->precedent != precedent) signaler("chainage incoherent", actu->id);
+                verifier_produit(actu);
+                precedent = actu;
+            }
+            if (nb != index_id_taille()) signaler("liste et index d'ID de tailles differentes", 0);
+        }
+        inventaire_deverrouiller();
+        atomic_fetch_add_explicit(&nb_lectures, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static void verifier_ligne(const char* ligne, uint32_t id_attendu) {
+    /*
+    Argument:
+        ligne: Ligne produit renvoyée par le serveur ("ID|nom|...|note")
+        id_attendu: ID qu'elle doit porter (0 = quelconque)
+    But:
+        Même contrôle que verifier_produit, sur la réponse d'un client
+    Retour:
+        Aucun
+    */
+    char* fin;
+    uint32_t id = (uint32_t)strtoul(ligne, &fin, 10);
+    const char* nom = fin + 1;
+    const char* note = strrchr(ligne, '|');
+    if (*fin != '|' || note == NULL || (id_attendu != 0 && id != id_attendu)) {
+        signaler("reponse du serveur mal formee", id);
+    } else if (strncmp(nom, PREFIXE_SERVEUR, strlen(PREFIXE_SERVEUR)) == 0) {
+        size_t longueur = strcspn(nom + strlen(PREFIXE_SERVEUR), "|");
+        if (strlen(note + 1) != longueur || strncmp(nom + strlen(PREFIXE_SERVEUR), note + 1, longueur) != 0) {
+            signaler("reponse du serveur : nom et note differents", id);
+        }
+    } else if (strncmp(nom, PREFIXE, strlen(PREFIXE)) != 0 || strtoul(nom + strlen(PREFIXE), NULL, 10) != id) {
+        signaler("reponse du serveur : nom qui ne correspond pas a l'ID", id);
+    }
+}
+
+static bool demander(FILE* envoi, FILE* reponse, const char* commande, const char* cherche, bool* trouve, char* statut) {
+    /*
+    Argument:
+        envoi, reponse: Connexion au serveur
+        commande: Ligne à envoyer (sans '\n')
+        cherche: Début de ligne recherché dans les données (NULL = aucun)
+        trouve: true si une ligne de données commence par cherche
+        statut: Reçoit la ligne finale "ok ..." ou "erreur ..." (TAILLE_REPONSE)
+    But:
+        Envoyer une commande et lire sa réponse. Les lignes de données des
+        commandes qui listent des produits sont vérifiées une à une
+    Retour:
+        false si la connexion a été coupée
+    */
+    bool produits = (strncmp(commande, "get", 3) == 0 || strncmp(commande, "find", 4) == 0
+                     || strncmp(commande, "cat ", 4) == 0 || strncmp(commande, "top", 3) == 0
+                     || strncmp(commande, "list", 4) == 0);
+    if (fprintf(envoi, "%s\n", commande) < 0 || fflush(envoi) != 0) return false;
+    if (trouve != NULL) *trouve = false;
+    char ligne[TAILLE_REPONSE];
+    while (fgets(ligne, sizeof(ligne), reponse) != NULL) {
+        ligne[strcspn(ligne, "\n")] = '\0';
+        if (strncmp(ligne, "ok", 2) == 0 || strncmp(ligne, "erreur", 6) == 0) {
+            snprintf(statut, TAILLE_REPONSE, "%s", ligne);
+            return true;
+        }
+        if (produits) verifier_ligne(ligne, 0);
+        if (cherche != NULL && strncmp(ligne, cherche, strlen(cherche)) == 0) *trouve = true;
+    }
+    return false;
+}
+
+static void* client(void* argument) {
+    /*
+    Argument:
+        argument: Numéro du client
+    But:
+        Se connecter au serveur et enchaîner ajouts, relectures, modifications,
+        recherches, suppressions et consultations, en vérifiant chaque réponse.
+        Chaque client ne modifie que ses propres produits
+    Retour:
+        NULL
+    */
+    unsigned int numero = (unsigned int)(uintptr_t)argument;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un adresse;
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    snprintf(adresse.sun_path, sizeof(adresse.sun_path), "%s", SOCKET_TEST);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&adresse, sizeof(adresse)) != 0) {
+        signaler("connexion au serveur impossible", numero);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    FILE* envoi = fdopen(dup(fd), "w");
+    FILE* reponse = fdopen(fd, "r");
+    if (envoi == NULL || reponse == NULL) {
+        signaler("flux du client impossibles a ouvrir", numero);
+        if (envoi != NULL) fclose(envoi);
+        if (reponse != NULL) fclose(reponse);
+        return NULL;
+    }
+
+    static const char* const consultations[] = {"categories", "top prix 5", "summary", "list 0 10", "cat cat3", "stats"};
+    char commande[TAILLE_REPONSE];
+    char attendu[TAILLE_REPONSE];
+    char statut[TAILLE_REPONSE];
+    bool trouve;
+    bool connecte = true;
+    for (int tour = 0; tour < TOURS_PAR_CLIENT && connecte; tour++) {
+        snprintf(commande, sizeof(commande), "add " PREFIXE_SERVEUR "%u-%d|d|cat%d|%d|1.5|0|%u-%d",
+                 numero, tour, tour % NB_CATEGORIES, tour, numero, tour);
+        connecte = demander(envoi, reponse, commande, NULL, NULL, statut);
+        uint32_t id = (connecte && strncmp(statut, "ok ", 3) == 0) ? (uint32_t)strtoul(statut + 3, NULL, 10) : 0;
+        if (id == 0) {
+            if (connecte) signaler("ajout refuse par le serveur", numero);
+            break;
+        }
+        atomic_fetch_add(&nb_appliquees, 1);
+        atomic_fetch_add(&bilan_produits, 1);
+
+        snprintf(commande, sizeof(commande), "get %u", id);
+        snprintf(attendu, sizeof(attendu), "%u|" PREFIXE_SERVEUR "%u-%d|", id, numero, tour);
+        connecte = connecte && demander(envoi, reponse, commande, attendu, &trouve, statut);
+        if (connecte && !trouve) signaler("produit ajoute introuvable par get", id);
+
+        if (tour % 2 == 0) {
+            snprintf(commande, sizeof(commande), "mod %u " PREFIXE_SERVEUR "%u-%d-m||cat%d||||%u-%d-m",
+                     id, numero, tour, (tour + 1) % NB_CATEGORIES, numero, tour);
+            connecte = connecte && demander(envoi, reponse, commande, NULL, NULL, statut);
+            snprintf(attendu, sizeof(attendu), "ok %u", id);
+            if (connecte && strcmp(statut, attendu) != 0) signaler("modification refusee par le serveur", id);
+            if (connecte) atomic_fetch_add(&nb_appliquees, 1);
+            snprintf(attendu, sizeof(attendu), "%u|" PREFIXE_SERVEUR "%u-%d-m|", id, numero, tour);
+        }
+
+        snprintf(commande, sizeof(commande), "find " PREFIXE_SERVEUR "%u-%d", numero, tour);
+        connecte = connecte && demander(envoi, reponse, commande, attendu, &trouve, statut);
+        if (connecte && !trouve) signaler("produit introuvable par find", id);
+
+        if (tour % 3 == 0) {
+            snprintf(commande, sizeof(commande), "del %u", id);
+            connecte = connecte && demander(envoi, reponse, commande, NULL, NULL, statut);
+            if (connecte && strncmp(statut, "ok", 2) != 0) signaler("suppression refusee par le serveur", id);
+            if (connecte) {
+                atomic_fetch_add(&nb_appliquees, 1);
+                atomic_fetch_sub(&bilan_produits, 1);
+            }
+            snprintf(commande, sizeof(commande), "get %u", id);
+            connecte = connecte && demander(envoi, reponse, commande, NULL, NULL, statut);
+            if (connecte && strncmp(statut, "erreur", 6) != 0) signaler("produit supprime encore visible", id);
+        }
+
+        const char* consultation = consultations[(numero + (unsigned int)tour) % (sizeof(consultations) / sizeof(consultations[0]))];
+        connecte = connecte && demander(envoi, reponse, consultation, NULL, NULL, statut);
+        if (connecte && strncmp(statut, "ok", 2) != 0) signaler("consultation refusee par le serveur", numero);
+    }
+    if (!connecte) signaler("connexion coupee par le serveur", numero);
+
+    fclose(envoi);
+    fclose(reponse);
+    return NULL;
+}
+
+static void* servir(void* argument) {
+    /*
+    Argument:
+        argument: Inutilisé
+    But:
+        Faire tourner le serveur sur l'inventaire partagé jusqu'à SIGTERM
+    Retour:
+        NULL
+    */
+    (void)argument;
+    if (serveur_executer(SOCKET_TEST, &head, &max_id) != 0) {
+        signaler("serveur impossible a demarrer", 0);
+    }
+    return NULL;
+}
+
+static bool attendre_serveur(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Attendre que la socket du serveur accepte les connexions
+    Retour:
+        true si le serveur est prêt avant 10 secondes
+    */
+    for (int essai = 0; essai < 1000; essai++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un adresse;
+        memset(&adresse, 0, sizeof(adresse));
+        adresse.sun_family = AF_UNIX;
+        snprintf(adresse.sun_path, sizeof(adresse.sun_path), "%s", SOCKET_TEST);
+        bool pret = (fd >= 0 && connect(fd, (struct sockaddr*)&adresse, sizeof(adresse)) == 0);
+        if (fd >= 0) close(fd);
+        if (pret) return true;
+        nanosleep(&(struct timespec){0, 10000000L}, NULL);
+    }
+    return false;
+}
+
+static bool construire(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Créer l'inventaire initial d'une passe
+    Retour:
+        true si succès
+    */
+    unsigned int graine = 42;
+    for (int i = 0; i < PRODUITS_INITIAUX; i++) {
+        Produit* p = nouveau_produit(max_id + 1, &graine);
+        if (p == NULL || insertion(&head, p) != 0) {
+            fprintf(stderr, "[!] Erreur : Inventaire initial impossible a construire\n");
+            return false;
+        }
+        max_id++;
+        atomic_fetch_add(&nb_appliquees, 1);
+    }
+    return true;
+}
+
+static void lancer(bool avec_serveur) {
+    /*
+    Argument:
+        avec_serveur: false : écrivains dans le processus ; true : les
+                      écritures passent par les clients du serveur
+    But:
+        Faire tourner les lecteurs pendant les écritures, puis tout arrêter
+    Retour:
+        Aucun
+    */
+    pthread_t lecteurs[NB_LECTEURS];
+    pthread_t ecrivains[NB_CLIENTS > NB_ECRIVAINS ? NB_CLIENTS : NB_ECRIVAINS];
+    pthread_t serveur;
+    int nb_ecrivains = 0;
+    atomic_store(&ecritures_finies, false);
+
+    if (avec_serveur) {
+        serveur_configurer_threads(NB_CLIENTS);
+        if (pthread_create(&serveur, NULL, servir, NULL) != 0) {
+            signaler("thread du serveur impossible a lancer", 0);
+            return;
+        }
+        if (!attendre_serveur()) {
+            signaler("serveur injoignable", 0);
+            pthread_kill(serveur, SIGTERM);
+            pthread_join(serveur, NULL);
+            return;
+        }
+    }
+    for (uintptr_t i = 0; i < NB_LECTEURS; i++) {
+        if (pthread_create(&lecteurs[i], NULL, lire, (void*)(i + 1)) != 0) exit(1);
+    }
+    for (uintptr_t i = 0; i < (avec_serveur ? NB_CLIENTS : NB_ECRIVAINS); i++) {
+        if (pthread_create(&ecrivains[i], NULL, avec_serveur ? client : ecrire, (void*)(i + 100)) != 0) exit(1);
+        nb_ecrivains++;
+    }
+    for (int i = 0; i < nb_ecrivains; i++) {
+        pthread_join(ecrivains[i], NULL);
+    }
+    atomic_store(&ecritures_finies, true);
+    for (int i = 0; i < NB_LECTEURS; i++) {
+        pthread_join(lecteurs[i], NULL);
+    }
+    if (avec_serveur) {
+        pthread_kill(serveur, SIGTERM); // reçu par le sigwait du serveur
+        pthread_join(serveur, NULL);
+    }
+}
+
+static size_t verifier_coherence(const char* passe) {
+    /*
+    Argument:
+        passe: Nom de la passe, pour les messages
+    But:
+        Contrôler que la liste, l'index d'ID, les colonnes, les vues triées et
+        les catégories comptent les mêmes produits et que les agrégats par
+        catégorie valent ceux recalculés
+    Retour:
+        Nombre de produits de la liste
+    */
+    size_t nb = 0;
+    for (const Produit* actu = head; actu != NULL; actu = actu->suivant) {
+        nb++;
+    }
+    size_t total_categories = 0;
+    for (uint32_t id = 1; id <= categories_nombre(); id++) {
+        total_categories += categories_taille(id);
+        // Les agrégats tenus à jour doivent valoir ceux recalculés depuis les membres
+        AgregatCategorie agregat;
+        categories_agregat(id, &agregat);
+        int64_t stock = 0;
+        double valeur = 0.0;
+        for (size_t i = 0; i < categories_taille(id); i++) {
+            const Produit* p = categories_membre(id, i);
+            stock += p->quantite;
+            valeur += (double)p->quantite * (double)p->prix_unitaire;
+        }
+        double ecart = agregat.valeur - valeur;
+        if (agregat.produits != categories_taille(id) || agregat.stock != stock || ecart > 1e-6 || ecart < -1e-6) {
+            fprintf(stderr, "[!] %s : agregats de %s incoherents : stock %lld/%lld, valeur %.6f/%.6f\n", passe,
+                    categories_nom(id), (long long)agregat.stock, (long long)stock, agregat.valeur, valeur);
+            atomic_fetch_add(&nb_erreurs, 1);
+        }
+    }
+    if (nb != index_id_taille() || nb != colonnes_taille() || nb != total_categories
+        || nb != index_tri_taille(TRI_PRIX) || nb != index_tri_taille(TRI_QUANTITE)) {
+        fprintf(stderr, "[!] %s : tailles finales incoherentes : liste %zu, index %zu, colonnes %zu, categories %zu, vues %zu/%zu\n",
+                passe, nb, index_id_taille(), colonnes_taille(), total_categories,
+                index_tri_taille(TRI_PRIX), index_tri_taille(TRI_QUANTITE));
+        atomic_fetch_add(&nb_erreurs, 1);
+    }
+    return nb;
+}
+
+static uint64_t empreinte(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Résumer l'inventaire (ID, nom, quantité, catégorie de chaque produit)
+        indépendamment de l'ordre de la liste
+    Retour:
+        Somme des empreintes FNV-1a des produits
+    */
+    uint64_t total = 0;
+    for (const Produit* p = head; p != NULL; p = p->suivant) {
+        uint64_t h = 14695981039346656037ull ^ p->id;
+        for (const char* c = p->nom; *c != '\0'; c++) h = (h ^ (unsigned char)*c) * 1099511628211ull;
+        for (const char* c = p->categorie; *c != '\0'; c++) h = (h ^ (unsigned char)*c) * 1099511628211ull;
+        total += (h ^ (uint64_t)(uint32_t)p->quantite) * 1099511628211ull;
+    }
+    return total;
+}
+
+static void retirer_fichiers(void) {
+    /*
+    Argument:
+        Aucun
+    But:
+        Supprimer les fichiers des passes journalisées
+    Retour:
+        Aucun
+    */
+    remove(FICHIER_TEST_HISTORIQUE);
+    remove(FICHIER_TEST_SAUVEGARDE);
+    remove(FICHIER_TEST_JOURNAL);
+}
+
+int main(void) {
+    /*
+    But :
+        1. Lecteurs et écrivains sans journalisation.
+        2. Les mêmes avec l'historique et le journal des opérations.
+        3. Clients du serveur sur le même inventaire, toujours journalisés.
+        Après chaque passe, contrôle de cohérence des index ; à la fin,
+        l'historique doit compter chaque opération réussie et un rechargement
+        (sauvegarde + journal) doit redonner le même inventaire
+    Retour :
+        0 si aucune incohérence n'a été vue, 1 sinon
+    */
+    activer_journalisation(false); // passe 1 : ni historique ni journal des opérations
+    if (!construire()) return 1;
+    lancer(false);
+    size_t nb = verifier_coherence("sans journal");
+    free_struct_produit(head);
+    head = NULL;
+    max_id = 0;
+
+    retirer_fichiers();
+    ConfigJournal config;
+    journal_config_defaut(&config);
+    if (journal_ouvrir(FICHIER_TEST_HISTORIQUE, &config) != 0 || journal_ops_ouvrir(FICHIER_TEST_SAUVEGARDE, &head, &max_id) != 0) {
+        fprintf(stderr, "[!] Erreur : Journaux de test impossibles a ouvrir\n");
+        return 1;
+    }
+    activer_journalisation(true);
+    atomic_store(&nb_appliquees, 0);
+    if (!construire()) return 1;
+    lancer(false);
+    size_t nb_journal = verifier_coherence("journalisee");
+
+    lancer(true);
+    size_t nb_serveur = verifier_coherence("serveur");
+    if ((long)nb_serveur != (long)nb_journal + atomic_load(&bilan_produits)) {
+        fprintf(stderr, "[!] serveur : %zu produits, %ld attendus\n", nb_serveur, (long)nb_journal + atomic_load(&bilan_produits));
+        atomic_fetch_add(&nb_erreurs, 1);
+    }
+
+    // Chaque opération réussie a laissé un et un seul événement dans l'historique
+    journal_vider();
+    FiltreHistorique tout = {0, 0, 0};
+    size_t nb_lus = 0, nb_rendus;
+    FILE* poubelle = fopen("/dev/null", "w");
+    if (poubelle == NULL || historique_lire(FICHIER_TEST_HISTORIQUE, &tout, poubelle, &nb_lus, &nb_rendus) != 0
+        || nb_lus != atomic_load(&nb_appliquees)) {
+        fprintf(stderr, "[!] Historique : %zu evenements pour %zu operations\n", nb_lus, atomic_load(&nb_appliquees));
+        atomic_fetch_add(&nb_erreurs, 1);
+    }
+    if (poubelle != NULL) fclose(poubelle);
+
+    // Sauvegarde puis rechargement (fichier + journal) : même inventaire
+    uint64_t avant = empreinte();
+    if (journal_ops_sauvegarder(head) != 0) {
+        fprintf(stderr, "[!] Sauvegarde journalisee impossible\n");
+        atomic_fetch_add(&nb_erreurs, 1);
+    }
+    free_struct_produit(head);
+    head = NULL;
+    max_id = 0;
+    journal_ops_charger(&head, &max_id);
+    if (verifier_coherence("rechargement") != nb_serveur || empreinte() != avant) {
+        fprintf(stderr, "[!] Rechargement : inventaire different de celui sauvegarde\n");
+        atomic_fetch_add(&nb_erreurs, 1);
+    }
+
+    journal_ops_fermer();
+    free_struct_produit(head);
+    journal_fermer();
+    retirer_fichiers();
+
+    size_t erreurs = atomic_load(&nb_erreurs);
+    printf("%s : %zu lectures, %d ecritures, %d tours de clients, %zu/%zu/%zu produits, %zu erreurs\n",
+           (erreurs == 0) ? "Concurrence OK" : "Concurrence ECHEC", atomic_load(&nb_lectures),
+           2 * NB_ECRIVAINS * OPERATIONS_PAR_ECRIVAIN, NB_CLIENTS * TOURS_PAR_CLIENT, nb, nb_journal, nb_serveur, erreurs);
+    return (erreurs == 0) ? 0 : 1;
+}